@@ -0,0 +1,167 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+// Reports compressed by Compression: read back as saved, corrupted ones rejected
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Common/Compression.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace MediaConch;
+
+//---------------------------------------------------------------------------
+static int errors = 0;
+
+//---------------------------------------------------------------------------
+static void check(const std::string& name, bool ok)
+{
+    if (ok)
+        return;
+
+    std::cerr << name << ": failed" << std::endl;
+    ++errors;
+}
+
+//---------------------------------------------------------------------------
+static std::string create_report(size_t count)
+{
+    std::stringstream report;
+    report << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<MediaArea>\n";
+    for (size_t i = 0; i < count; ++i)
+        report << "  <track type=\"Video\"><ID>" << i << "</ID><Format>FFV1</Format><Width>" << (i * 7) % 1921
+               << "</Width></track>\n";
+    report << "</MediaArea>\n";
+    return report.str();
+}
+
+//---------------------------------------------------------------------------
+// Compressed, the report is read back with the same bytes, with or without its size saved
+static void check_round_trip(const std::string& name, const Compression& c, MediaConchLib::compression mode,
+                             const std::string& report, int expected_dictionary_id)
+{
+    MediaConchLib::compression compress = mode;
+    int dictionary_id = -1;
+    std::string data(report);
+    c.compress(data, compress, dictionary_id);
+    check(name + " mode", compress == mode);
+    check(name + " compressed", data.size() < report.size());
+    check(name + " dictionary", dictionary_id == expected_dictionary_id);
+
+    std::string out(data);
+    check(name + " uncompress", c.uncompress(out, compress, report.size(), dictionary_id) == 0 && out == report);
+
+    out = data;
+    check(name + " uncompress without size", c.uncompress(out, compress, 0, dictionary_id) == 0 && out == report);
+
+    // Corrupted header, truncated data
+    out = data;
+    out[0] = (char)(out[0] ^ 0xFF);
+    check(name + " corrupted header", c.uncompress(out, compress, report.size(), dictionary_id) < 0);
+
+    out = data.substr(0, data.size() / 2);
+    check(name + " truncated", c.uncompress(out, compress, report.size(), dictionary_id) < 0);
+}
+
+//---------------------------------------------------------------------------
+int main()
+{
+    std::string report = create_report(2000);
+    std::string err;
+
+    // Without compression, the report is kept as is
+    {
+        Compression c;
+        MediaConchLib::compression compress = MediaConchLib::compression_None;
+        int dictionary_id = -1;
+        std::string data(report);
+        c.compress(data, compress, dictionary_id);
+        check("none", compress == MediaConchLib::compression_None && dictionary_id == 0 && data == report);
+        check("none uncompress", c.uncompress(data, compress) == 0 && data == report);
+    }
+
+    // zlib, the size saved with the report is only a hint
+    {
+        Compression c;
+        c.set_level(MediaConchLib::compression_ZLib, 6);
+        check_round_trip("zlib", c, MediaConchLib::compression_ZLib, report, 0);
+
+        MediaConchLib::compression compress = MediaConchLib::compression_ZLib;
+        int dictionary_id = -1;
+        std::string data(report);
+        c.compress(data, compress, dictionary_id);
+        check("zlib wrong size", c.uncompress(data, compress, report.size() / 2) == 0 && data == report);
+    }
+
+    // Codecs not available fall back to zlib
+    if (!Compression::is_available(MediaConchLib::compression_ZStd)
+     || !Compression::is_available(MediaConchLib::compression_LZ4))
+    {
+        Compression c;
+        MediaConchLib::compression compress = Compression::is_available(MediaConchLib::compression_ZStd)
+                                            ? MediaConchLib::compression_LZ4 : MediaConchLib::compression_ZStd;
+        int dictionary_id = -1;
+        std::string data(report);
+        c.compress(data, compress, dictionary_id);
+        check("fallback", compress == MediaConchLib::compression_ZLib);
+        check("fallback uncompress", c.uncompress(data, compress, report.size()) == 0 && data == report);
+    }
+
+    // zstd, with the dictionary saved with each report
+    if (Compression::is_available(MediaConchLib::compression_ZStd))
+    {
+        Compression c;
+        check_round_trip("zstd", c, MediaConchLib::compression_ZStd, report, 0);
+
+        std::string dictionary = create_report(50);
+        check("zstd dictionary", c.set_zstd_dictionary(dictionary, err) == 0);
+
+        MediaConchLib::compression compress = MediaConchLib::compression_ZStd;
+        int dictionary_id = -1;
+        std::string data(report);
+        c.compress(data, compress, dictionary_id);
+        check("zstd dictionary id", compress == MediaConchLib::compression_ZStd && dictionary_id > 0);
+        check_round_trip("zstd with dictionary", c, MediaConchLib::compression_ZStd, report, dictionary_id);
+
+        // Reports compressed before the dictionary are still read
+        std::string previous(report);
+        MediaConchLib::compression previous_compress = MediaConchLib::compression_ZStd;
+        int previous_id = -1;
+        {
+            Compression before;
+            before.compress(previous, previous_compress, previous_id);
+        }
+        std::string out(previous);
+        check("zstd without dictionary", c.uncompress(out, previous_compress, report.size(), previous_id) == 0
+                                      && out == report);
+
+        // A new dictionary, the previous one is needed to read the reports saved with it
+        Compression next;
+        check("zstd new dictionary", next.set_zstd_dictionary(create_report(60), err) == 0);
+        out = data;
+        check("zstd unknown dictionary", next.uncompress(out, compress, report.size(), dictionary_id) < 0);
+        check("zstd previous dictionary", next.add_zstd_previous_dictionary(dictionary, err) == 0);
+        out = data;
+        check("zstd previous dictionary uncompress", next.uncompress(out, compress, report.size(), dictionary_id) == 0
+                                                  && out == report);
+    }
+    else
+        check("zstd dictionary not available", Compression().set_zstd_dictionary("dictionary", err) < 0);
+
+    // lz4, with the default and the HC levels
+    if (Compression::is_available(MediaConchLib::compression_LZ4))
+    {
+        Compression c;
+        check_round_trip("lz4", c, MediaConchLib::compression_LZ4, report, 0);
+        c.set_level(MediaConchLib::compression_LZ4, 9);
+        check_round_trip("lz4 hc", c, MediaConchLib::compression_LZ4, report, 0);
+    }
+
+    return errors ? 1 : 0;
+}
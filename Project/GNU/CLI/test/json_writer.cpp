@@ -0,0 +1,128 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+// JSON written by JsonWriter: escaping, values not representable, failed output
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Common/JsonWriter.h"
+#include <iostream>
+#include <string>
+#include <math.h>
+
+using namespace MediaConch;
+
+//---------------------------------------------------------------------------
+// Output whose space cannot be reserved
+class FailingJsonWriter : public JsonWriter
+{
+public:
+    FailingJsonWriter(std::string& o) : out(o) {}
+
+protected:
+    void  write(const char* data, size_t len) { out.append(data, len); }
+    char *reserve(size_t, size_t&) { return NULL; }
+    void  commit(size_t) {}
+
+private:
+    std::string& out;
+};
+
+//---------------------------------------------------------------------------
+static int errors = 0;
+
+//---------------------------------------------------------------------------
+static void check(const std::string& name, const std::string& out, const std::string& expected)
+{
+    if (out == expected)
+        return;
+
+    std::cerr << name << ": got " << out << ", expected " << expected << std::endl;
+    ++errors;
+}
+
+//---------------------------------------------------------------------------
+int main()
+{
+    // Quote, backslash, control characters, UTF-8 kept as is
+    {
+        std::string out;
+        JsonStringWriter writer(out);
+        writer.add_string(std::string("a\"b\\c\nd\re\tf\bg\fh\x01i\x1fj\xc3\xa9/", 22));
+        check("escape", out, "\"a\\\"b\\\\c\\nd\\re\\tf\\bg\\fh\\u0001i\\u001fj\xc3\xa9/\"");
+        check("escape failed", writer.has_failed() ? "true" : "false", "false");
+    }
+
+    // A NUL byte is a control character
+    {
+        std::string out;
+        JsonStringWriter writer(out);
+        writer.add_string(std::string("a\0b", 3));
+        check("nul", out, "\"a\\u0000b\"");
+    }
+
+    // Escaped by chunks, the escapes at the chunk boundaries are complete
+    {
+        std::string value;
+        std::string expected("\"");
+        for (size_t i = 0; i < 200000; ++i)
+        {
+            value += i % 3 ? 'x' : '"';
+            expected += i % 3 ? "x" : "\\\"";
+        }
+        expected += "\"";
+
+        std::string out;
+        JsonStringWriter writer(out);
+        writer.add_string(value);
+        if (out != expected)
+            check("large", "different", "same");
+    }
+
+    // NaN and infinities are not JSON numbers
+    {
+        double zero = 0.0;
+        std::string out;
+        JsonStringWriter writer(out);
+        writer.start_array();
+        writer.add_real(zero / zero);
+        writer.add_real(HUGE_VAL);
+        writer.add_real(-HUGE_VAL);
+        writer.add_real(0.5);
+        writer.add_integer(-3);
+        writer.end_array();
+        check("non finite", out, "[null, null, null, 0.5, -3]");
+    }
+
+    // Members and elements separators
+    {
+        std::string out;
+        JsonStringWriter writer(out);
+        writer.start_object();
+        writer.add_key("k\"1");
+        writer.start_array();
+        writer.add_bool(true);
+        writer.add_null();
+        writer.end_array();
+        writer.add_key("k2");
+        writer.add_string("v");
+        writer.end_object();
+        check("object", out, "{\"k\\\"1\": [true, null], \"k2\": \"v\"}");
+    }
+
+    // The output not reserved is reported, not silently truncated
+    {
+        std::string out;
+        FailingJsonWriter writer(out);
+        writer.start_object();
+        writer.add_key("report");
+        std::string failed = writer.has_failed() ? "true" : "false";
+        check("failed", failed, "true");
+    }
+
+    return errors ? 1 : 0;
+}
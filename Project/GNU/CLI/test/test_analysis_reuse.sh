@@ -0,0 +1,79 @@
+#!/bin/sh
+
+PATH_SCRIPT=$(dirname "$0")
+. "$PATH_SCRIPT/utils.sh"
+
+FILES_DIRECTORY="$PATH_SCRIPT/SampleFiles/ImplementationTestFiles/Matroska"
+SQLITE3="${SQLITE3:-sqlite3}"
+
+# The database is read to know which files got the reports of another one
+if ! command -v "$SQLITE3" > /dev/null 2>&1
+then
+    exit 77
+fi
+
+DIR="`mktemp -d`"
+CONFIG="$DIR/analysis_reuse.rc"
+trap 'rm -rf "$DIR"' EXIT
+
+# Reports of a file as saved, the text MediaInfo report contains the name of the file parsed
+reports_of()
+{
+    "$SQLITE3" "$DIR/db/MediaConch.db" "SELECT TOOL, FORMAT, hex(REPORT) FROM MEDIACONCH_REPORT WHERE FILE_ID = \
+        (SELECT ID FROM MEDIACONCH_FILE WHERE FILENAME LIKE '%$1' AND USER = $2) ORDER BY TOOL, FORMAT, OPTIONS;"
+}
+
+for MODE in Full Sampled
+do
+    rm -rf "$DIR/db" "$DIR/a" "$DIR/b"
+    mkdir "$DIR/db" "$DIR/a" "$DIR/b"
+    echo "[{\"SQLite_Path\": \"$DIR/db\"}, {\"Analysis_Fingerprint\": \"$MODE\"}]" > "$CONFIG"
+
+    # Same content at another path, and same size with one byte changed
+    cp "$FILES_DIRECTORY/tiny.mkv" "$DIR/a/tiny.mkv"
+    cp "$FILES_DIRECTORY/tiny.mkv" "$DIR/b/copy.mkv"
+    cp "$FILES_DIRECTORY/tiny.mkv" "$DIR/a/changed.mkv"
+    SIZE=`wc -c < "$DIR/a/changed.mkv"`
+    printf 'X' | dd of="$DIR/a/changed.mkv" bs=1 seek=`expr $SIZE - 1` conv=notrunc 2> /dev/null
+
+    DATA="`./mediaconch -c \"$CONFIG\" -u 1 -fx \"$DIR/a/tiny.mkv\"`"
+    cmd_is_ok
+    xml_is_correct
+
+    # Without SQLite, the reports are not kept between the runs
+    if [ ! -f "$DIR/db/MediaConch.db" ]
+    then
+        exit 77
+    fi
+
+    REFERENCE="`reports_of /a/tiny.mkv 1`"
+    if [ -z "$REFERENCE" ]
+    then
+        exit 1
+    fi
+
+    # Other path and other user: the reports are copied, the report is given for the new path
+    DATA="`./mediaconch -c \"$CONFIG\" -u 2 -fx \"$DIR/b/copy.mkv\"`"
+    cmd_is_ok
+    xml_is_correct
+    if ! echo "$DATA" | grep -q "copy.mkv"
+    then
+        exit 1
+    fi
+
+    if [ "`reports_of /b/copy.mkv 2`" != "$REFERENCE" ]
+    then
+        exit 1
+    fi
+
+    # Other content: the file is parsed
+    DATA="`./mediaconch -c \"$CONFIG\" -u 1 -fx \"$DIR/a/changed.mkv\"`"
+    cmd_is_ok
+    xml_is_correct
+
+    CHANGED="`reports_of /a/changed.mkv 1`"
+    if [ -z "$CHANGED" ] || [ "$CHANGED" = "$REFERENCE" ]
+    then
+        exit 1
+    fi
+done
@@ -0,0 +1,78 @@
+#!/bin/sh
+
+PATH_SCRIPT=$(dirname "$0")
+. "$PATH_SCRIPT/utils.sh"
+
+POLICIES_DIRECTORY="$MC_ROOT_PATH/Tools/Policies"
+REFERENCE_FILE="$PATH_SCRIPT/SampleFiles/ImplementationTestFiles/Matroska/tiny.mkv"
+FFV1_DIRECTORY="$PATH_SCRIPT/SampleFiles/PolicyTestFiles/FFV1"
+
+# Several kinds of files: the Matroska one and the FFV1 policy test files
+FILES="$REFERENCE_FILE"
+for i in `ls "$FFV1_DIRECTORY" | grep -v '\.txt'`
+do
+    FILES="$FILES $FFV1_DIRECTORY/$i"
+done
+
+# Every sample policy, not their outputs
+POLICIES="`ls "$POLICIES_DIRECTORY" | grep '^sample_policy_[0-9].*\.xml$' | grep -v '_output\.xml$'`"
+if test -z "$POLICIES"
+then
+    exit 1
+fi
+
+# The reports of the native policy evaluation must be the same as the XSLT ones
+CONFIG="policy_xslt.rc"
+echo '[{"Policy_Native_Evaluation": false}]' > "$CONFIG"
+
+policy_fail()
+{
+    echo "$1: the native evaluation differs from the XSLT one for $2" >&9
+    rm -f "$CONFIG"
+    exit 1
+}
+
+for POLICY in $POLICIES
+do
+    REFERENCE=
+    case "$POLICY" in
+        *_comparison.xml)
+            # The comparison policies (2 and 3) need a reference file, they cannot be evaluated natively:
+            # the XSLT is used in both configurations, their reports are still compared
+            REFERENCE="--PolicyReferenceFile=$REFERENCE_FILE"
+            ;;
+    esac
+
+    for FILE in $FILES
+    do
+        NATIVE="`./mediaconch -fx $REFERENCE -p \"$POLICIES_DIRECTORY/$POLICY\" \"$FILE\"`"
+        cmd_is_ok
+
+        DATA="`./mediaconch -c \"$CONFIG\" -fx $REFERENCE -p \"$POLICIES_DIRECTORY/$POLICY\" \"$FILE\"`"
+        cmd_is_ok
+        xml_is_correct
+
+        if [ "$NATIVE" != "$DATA" ]
+        then
+            policy_fail "$POLICY" "$FILE"
+        fi
+    done
+
+    # All the files in one report, their MediaInfo reports are shared by the policies
+    if test -z "$REFERENCE"
+    then
+        NATIVE="`./mediaconch -fx -p \"$POLICIES_DIRECTORY/$POLICY\" $FILES`"
+        cmd_is_ok
+
+        DATA="`./mediaconch -c \"$CONFIG\" -fx -p \"$POLICIES_DIRECTORY/$POLICY\" $FILES`"
+        cmd_is_ok
+        xml_is_correct
+
+        if [ "$NATIVE" != "$DATA" ]
+        then
+            policy_fail "$POLICY" "all the files"
+        fi
+    fi
+done
+
+rm -f "$CONFIG"
@@ -90,6 +90,12 @@ SOURCES          += ../../Source/Common/MediaConchLib.cpp \
                     ../../Source/Common/PluginFileLog.cpp \
                     ../../Source/Common/WatchFoldersManager.cpp \
                     ../../Source/Common/WatchFolder.cpp \
+                    ../../Source/Common/FileFingerprint.cpp \
+                    ../../Source/Common/JsonWriter.cpp \
+                    ../../Source/Common/WatchFolderWatcher.cpp \
+                    ../../Source/Common/Compression.cpp \
+                    ../../Source/Common/PolicyEvaluator.cpp \
+                    ../../Source/Common/Condition.cpp \
                     ../../Source/GUI/Qt/main.cpp \
                     ../../Source/GUI/Qt/commonwebwindow.cpp \
                     ../../Source/GUI/Qt/helpwindow.cpp \
@@ -155,6 +161,12 @@ HEADERS          += ../../Source/Common/MediaConchLib.h \
                     ../../Source/Common/PluginLog.h \
                     ../../Source/Common/PluginFileLog.h \
                     ../../Source/Common/WatchFoldersManager.h \
+                    ../../Source/Common/FileFingerprint.h \
+                    ../../Source/Common/JsonWriter.h \
+                    ../../Source/Common/WatchFolderWatcher.h \
+                    ../../Source/Common/Compression.h \
+                    ../../Source/Common/PolicyEvaluator.h \
+                    ../../Source/Common/Condition.h \
                     ../../Source/GUI/Qt/commonwebwindow.h \
                     ../../Source/GUI/Qt/helpwindow.h \
                     ../../Source/GUI/Qt/WebPage.h \
@@ -314,6 +326,34 @@ contains(NO_LIBEVENT, yes|1) {
     }
 }
 
+contains(WITH_ZSTD, yes|1) {
+    DEFINES              += HAVE_ZSTD
+    unix:exists(../../../zstd/lib/libzstd.a) {
+        INCLUDEPATH      += ../../../zstd/lib
+        LIBS             += ../../../zstd/lib/libzstd.a
+        message("libzstd     : custom")
+    } else:unix {
+        PKGCONFIG        += libzstd
+        message("libzstd     : system")
+    }
+} else {
+    message("libzstd     : no")
+}
+
+contains(WITH_LZ4, yes|1) {
+    DEFINES              += HAVE_LZ4
+    unix:exists(../../../lz4/lib/liblz4.a) {
+        INCLUDEPATH      += ../../../lz4/lib
+        LIBS             += ../../../lz4/lib/liblz4.a
+        message("liblz4      : custom")
+    } else:unix {
+        PKGCONFIG        += liblz4
+        message("liblz4      : system")
+    }
+} else {
+    message("liblz4      : no")
+}
+
 macx:contains(MACSTORE, yes|1) {
     QMAKE_CFLAGS += -gdwarf-2
     QMAKE_CXXFLAGS += -gdwarf-2
@@ -11,6 +11,7 @@
 
 //---------------------------------------------------------------------------
 #include <algorithm>
+#include <set>
 #include "CLI.h"
 #include "CommandLine_Parser.h"
 #include "Help.h"
@@ -207,26 +208,58 @@ void Log_0(struct MediaInfo_Event_Log_0* Event)
         if (file_information)
             return run_file_information(err);
 
+        // Register all the files first, the scheduler analyzes them concurrently
+        std::vector<long> files_id;
+        std::vector<bool> registered;
+        std::vector<std::string> files_error;
+        if (MCL.checker_analyze(use_as_user, files, plugins, options, files_id, registered, files_error,
+                                err, force_analyze, mil_analyze) < 0)
+            return -1;
+
+        // The files not registered are given with their error, the others are analyzed
+        std::vector<long> analyzed_id;
         for (size_t i = 0; i < files.size(); ++i)
         {
-            bool registered = false;
-            long file_id = -1;
-            std::vector<long> file_ids;
-            int ret = MCL.checker_analyze(use_as_user, files[i], plugins, options, registered,
-                                          file_id, err, force_analyze, mil_analyze);
-            if (ret < 0)
-                return -1;
-
-            if (use_daemon && asynchronous && !registered)
+            if (files_id[i] >= 0)
             {
-                std::stringstream str;
-                str << "Registering ";
-                str << files[i];
-                str << " to analyze";
-                STRINGOUT(ZenLib::Ztring().From_UTF8(str.str()));
+                analyzed_id.push_back(files_id[i]);
+                continue;
             }
 
-            int ready = is_ready(file_id, file_ids, report_kind, err);
+            std::stringstream str;
+            str << "Cannot analyze " << files[i] << ": " << files_error[i];
+            STRINGOUT(ZenLib::Ztring().From_UTF8(str.str()));
+        }
+
+        size_t not_analyzed = files.size() - analyzed_id.size();
+        if (!analyzed_id.size())
+        {
+            err = "No file can be analyzed.";
+            return -1;
+        }
+
+        for (size_t i = 0; use_daemon && asynchronous && i < files.size(); ++i)
+        {
+            if (registered[i] || files_id[i] < 0)
+                continue;
+
+            std::stringstream str;
+            str << "Registering ";
+            str << files[i];
+            str << " to analyze";
+            STRINGOUT(ZenLib::Ztring().From_UTF8(str.str()));
+        }
+
+        // Status of all the files at once
+        std::vector<MediaConchLib::Checker_StatusRes> statuses;
+        if (wait_files_finished(analyzed_id, err) < 0 ||
+            MCL.checker_status(use_as_user, analyzed_id, statuses, err) < 0)
+            return -1;
+
+        for (size_t i = 0; i < analyzed_id.size(); ++i)
+        {
+            std::vector<long> file_ids;
+            int ready = is_ready(analyzed_id[i], file_ids, report_kind, err, &statuses[i]);
             if (ready == MediaConchLib::errorHttp_NONE)
                 continue;
             else if (ready < 0)
@@ -293,6 +326,15 @@ void Log_0(struct MediaInfo_Event_Log_0* Event)
         if (!LogFile_FileName.empty())
             LogFile_Action(report_mi);
 
+        // The reports of the other files are given, the run still fails
+        if (not_analyzed)
+        {
+            std::stringstream str;
+            str << not_analyzed << " file(s) cannot be analyzed.";
+            err = str.str();
+            return -1;
+        }
+
         return 0;
     }
 
@@ -657,6 +699,10 @@ void Log_0(struct MediaInfo_Event_Log_0* Event)
             mode = MediaConchLib::compression_None;
         else if (mode_str == "zlib")
             mode = MediaConchLib::compression_ZLib;
+        else if (mode_str == "zstd")
+            mode = MediaConchLib::compression_ZStd;
+        else if (mode_str == "lz4")
+            mode = MediaConchLib::compression_LZ4;
         else
             return Help();
 
@@ -711,11 +757,39 @@ void Log_0(struct MediaInfo_Event_Log_0* Event)
     }
 
     //--------------------------------------------------------------------------
-    int CLI::is_ready(long file_id, std::vector<long>& file_ids, MediaConchLib::report& report_kind, std::string& err)
+    int CLI::wait_files_finished(const std::vector<long>& files_id, std::string& err)
+    {
+        if (use_daemon && asynchronous)
+            return 0;
+
+        std::vector<long> pending(files_id);
+        long last_event = -1;
+        while (pending.size())
+        {
+            std::vector<long> finished;
+            if (MCL.checker_wait_finished(use_as_user, pending, finished, err, (size_t)-1, &last_event) < 0)
+                return -1;
+
+            std::set<long> done(finished.begin(), finished.end());
+            std::vector<long> still_pending;
+            for (size_t i = 0; i < pending.size(); ++i)
+                if (pending[i] >= 0 && done.find(pending[i]) == done.end())
+                    still_pending.push_back(pending[i]);
+            pending.swap(still_pending);
+        }
+
+        return 0;
+    }
+
+    //--------------------------------------------------------------------------
+    int CLI::is_ready(long file_id, std::vector<long>& file_ids, MediaConchLib::report& report_kind, std::string& err,
+                      const MediaConchLib::Checker_StatusRes* status)
     {
         MediaConchLib::Checker_StatusRes res;
-        int ret = MCL.checker_status(use_as_user, file_id, res, err);
-        if (ret < 0)
+        int ret = 0;
+        if (status)
+            res = *status;
+        else if ((ret = MCL.checker_status(use_as_user, file_id, res, err)) < 0)
             return -1;
 
         if (use_daemon && asynchronous)
@@ -743,11 +817,11 @@ void Log_0(struct MediaInfo_Event_Log_0* Event)
         {
             while (!res.finished)
             {
-#ifdef WINDOWS
-                ::Sleep((DWORD)5);
-#else
-                usleep(500000);
-#endif
+                std::vector<long> ids(1, file_id);
+                std::vector<long> finished;
+                if (MCL.checker_wait_finished(use_as_user, ids, finished, err) < 0)
+                    return -1;
+
                 if (MCL.checker_status(use_as_user, file_id, res, err) < 0)
                     return -1;
             }
@@ -71,7 +71,9 @@ namespace MediaConch
         int  run_plugins_list(std::string& err);
         int  run_watch_folders_list(std::string& err);
         int  run_watch_folder_cmd(std::string& err);
-        int  is_ready(long file_id, std::vector<long>& file_ids, MediaConchLib::report& report_kind, std::string& err);
+        int  is_ready(long file_id, std::vector<long>& file_ids, MediaConchLib::report& report_kind, std::string& err,
+                      const MediaConchLib::Checker_StatusRes* status=NULL);
+        int  wait_files_finished(const std::vector<long>& files_id, std::string& err);
         void add_files_recursively(const std::string& filename);
         void file_info_report(const MediaConchLib::Checker_FileInfo* info, std::string& report);
         int  run_list_files(std::string& err);
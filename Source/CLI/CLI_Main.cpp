@@ -75,10 +75,14 @@ int main(int argc, char* argv_ansi[])
         return 1;
     }
 
+    ret = 0;
     if (cli.run(err) < 0)
+    {
         STRINGOUT(ZenLib::Ztring().From_UTF8(err));
+        ret = 1;
+    }
 
     cli.finish();
 
-    return 0;
+    return ret;
 }
@@ -147,6 +147,8 @@ int Help_Advanced()
     TEXTOUT("    Compress report in database using [Mode]");
     TEXTOUT("    [Mode] can be None for no compression");
     TEXTOUT("    [Mode] can be ZLib to use zlib");
+    TEXTOUT("    [Mode] can be ZStd to use zstd, if available");
+    TEXTOUT("    [Mode] can be LZ4 to use lz4, if available");
     TEXTOUT("-cz");
     TEXTOUT("    Same as --Compression=ZLib");
     TEXTOUT("");
@@ -0,0 +1,531 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifdef __BORLANDC__
+    #pragma hdrstop
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Compression.h"
+#define ZLIB_CONST
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_LZ4
+#include <lz4frame.h>
+#endif
+#include <algorithm>
+#include <cctype>
+#include <string.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// Compression
+//***************************************************************************
+
+//***************************************************************************
+// Constructor/Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+Compression::Compression()
+{
+    for (size_t i = 0; i < MediaConchLib::compression_Max; ++i)
+        levels[i] = 0;
+    zstd_dictionary_id = 0;
+#ifdef HAVE_ZSTD
+    zstd_cdict = NULL;
+#endif
+}
+
+//---------------------------------------------------------------------------
+Compression::~Compression()
+{
+    free_zstd_dictionaries();
+}
+
+//***************************************************************************
+// Configuration
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void Compression::set_level(MediaConchLib::compression compress, int level)
+{
+    if (compress >= MediaConchLib::compression_Max)
+        return;
+
+    levels[compress] = level;
+
+    // The compression dictionary is built for a level
+    if (compress == MediaConchLib::compression_ZStd && zstd_dictionary.size())
+        create_zstd_dictionaries();
+}
+
+//---------------------------------------------------------------------------
+int Compression::set_zstd_dictionary(const std::string& dictionary, std::string& err)
+{
+#ifdef HAVE_ZSTD
+    zstd_dictionary = dictionary;
+    zstd_dictionary_id = dictionary.size() ? get_dictionary_id(dictionary) : 0;
+    create_zstd_dictionaries();
+    if (zstd_dictionary.size() && (!zstd_cdict || zstd_ddicts.find(zstd_dictionary_id) == zstd_ddicts.end()))
+    {
+        err = "Cannot load the zstd dictionary";
+        zstd_dictionary.clear();
+        zstd_dictionary_id = 0;
+        create_zstd_dictionaries();
+        return -1;
+    }
+    return 0;
+#else
+    if (dictionary.empty())
+        return 0;
+
+    err = "zstd is not available";
+    return -1;
+#endif
+}
+
+//---------------------------------------------------------------------------
+int Compression::add_zstd_previous_dictionary(const std::string& dictionary, std::string& err)
+{
+#ifdef HAVE_ZSTD
+    if (dictionary.empty())
+    {
+        err = "The zstd dictionary is empty";
+        return -1;
+    }
+
+    int id = get_dictionary_id(dictionary);
+    if (zstd_ddicts.find(id) != zstd_ddicts.end())
+        return 0;
+
+    ZSTD_DDict* ddict = ZSTD_createDDict(dictionary.c_str(), dictionary.size());
+    if (!ddict)
+    {
+        err = "Cannot load the zstd dictionary";
+        return -1;
+    }
+    zstd_ddicts[id] = ddict;
+    return 0;
+#else
+    (void)dictionary;
+    err = "zstd is not available";
+    return -1;
+#endif
+}
+
+//---------------------------------------------------------------------------
+int Compression::get_dictionary_id(const std::string& dictionary)
+{
+    // 0 is kept for the reports compressed without dictionary
+    int id = (int)(crc32(0L, (const Bytef*)dictionary.c_str(), (uInt)dictionary.size()) & 0x7FFFFFFF);
+    return id ? id : 1;
+}
+
+//---------------------------------------------------------------------------
+bool Compression::is_available(MediaConchLib::compression compress)
+{
+    switch (compress)
+    {
+        case MediaConchLib::compression_None:
+        case MediaConchLib::compression_ZLib:
+            return true;
+#ifdef HAVE_ZSTD
+        case MediaConchLib::compression_ZStd:
+            return true;
+#endif
+#ifdef HAVE_LZ4
+        case MediaConchLib::compression_LZ4:
+            return true;
+#endif
+        default:
+            break;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------
+int Compression::get_compression_from_name(const std::string& name, MediaConchLib::compression& compress)
+{
+    std::string str(name);
+    transform(str.begin(), str.end(), str.begin(), (int(*)(int))tolower); //(int(*)(int)) is a patch for unix
+
+    if (str == "none")
+        compress = MediaConchLib::compression_None;
+    else if (str == "zlib")
+        compress = MediaConchLib::compression_ZLib;
+    else if (str == "zstd")
+        compress = MediaConchLib::compression_ZStd;
+    else if (str == "lz4")
+        compress = MediaConchLib::compression_LZ4;
+    else
+        return -1;
+
+    return 0;
+}
+
+//***************************************************************************
+// Compression
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void Compression::compress(std::string& report, MediaConchLib::compression& compress, int& dictionary_id) const
+{
+    dictionary_id = 0;
+    if (compress == MediaConchLib::compression_None || compress >= MediaConchLib::compression_Max)
+    {
+        compress = MediaConchLib::compression_None;
+        return;
+    }
+
+    std::string dst;
+    compress_copy(dst, report.c_str(), report.length(), compress, dictionary_id);
+    if (compress != MediaConchLib::compression_None)
+        report.swap(dst);
+}
+
+//---------------------------------------------------------------------------
+void Compression::compress_copy(std::string& report, const char* src, size_t src_len,
+                                MediaConchLib::compression& compress, int& dictionary_id) const
+{
+    dictionary_id = 0;
+    if (!is_available(compress))
+        compress = MediaConchLib::compression_ZLib;
+
+    bool done = false;
+    switch (compress)
+    {
+        case MediaConchLib::compression_ZLib:
+            done = compress_zlib(report, src, src_len);
+            break;
+        case MediaConchLib::compression_ZStd:
+            done = compress_zstd(report, src, src_len, dictionary_id);
+            break;
+        case MediaConchLib::compression_LZ4:
+            done = compress_lz4(report, src, src_len);
+            break;
+        default:
+            break;
+    }
+
+    if (!done)
+    {
+        //Fallback to no compression
+        report = std::string(src, src_len);
+        compress = MediaConchLib::compression_None;
+        dictionary_id = 0;
+    }
+}
+
+//---------------------------------------------------------------------------
+int Compression::uncompress(std::string& report, MediaConchLib::compression compress, size_t uncompressed_size,
+                            int dictionary_id) const
+{
+    switch (compress)
+    {
+        case MediaConchLib::compression_None:
+            return 0;
+        case MediaConchLib::compression_ZLib:
+            return uncompress_zlib(report, uncompressed_size);
+        case MediaConchLib::compression_ZStd:
+            return uncompress_zstd(report, dictionary_id);
+        case MediaConchLib::compression_LZ4:
+            return uncompress_lz4(report);
+        default:
+            break;
+    }
+    return 0;
+}
+
+//***************************************************************************
+// ZLib
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool Compression::compress_zlib(std::string& report, const char* src, size_t src_len) const
+{
+    int level = levels[MediaConchLib::compression_ZLib];
+    if (level <= 0 || level > Z_BEST_COMPRESSION)
+        level = Z_BEST_COMPRESSION;
+
+    uLongf dst_len = (uLongf)src_len;
+    Bytef* dst = new Bytef[src_len + 1];
+
+    bool done = false;
+    if (compress2(dst, &dst_len, (const Bytef*)src, (uLong)src_len, level) == Z_OK && dst_len < src_len)
+    {
+        report = std::string((const char*)dst, dst_len);
+        done = true;
+    }
+    delete [] dst;
+    return done;
+}
+
+//---------------------------------------------------------------------------
+int Compression::uncompress_zlib(std::string& report, size_t uncompressed_size) const
+{
+    std::string dst;
+
+    // Size saved with the report, decompressed directly in its destination
+    if (uncompressed_size)
+    {
+        dst.resize(uncompressed_size);
+        uLongf dst_len = (uLongf)uncompressed_size;
+        if (::uncompress((Bytef*)&dst[0], &dst_len, (const Bytef*)report.c_str(), (uLong)report.length()) == Z_OK
+         && dst_len == uncompressed_size)
+        {
+            report.swap(dst);
+            return 0;
+        }
+    }
+
+    // Size unknown (reports saved before) or wrong, the destination grows while inflating
+    z_stream strm;
+    memset(&strm, 0, sizeof(strm));
+    if (inflateInit(&strm) != Z_OK)
+        return -1;
+
+    strm.next_in = (const Bytef*)report.c_str();
+    strm.avail_in = (uInt)report.length();
+    dst.resize(report.length() * 4 + 1024);
+
+    int ret;
+    size_t pos = 0;
+    do
+    {
+        if (pos == dst.size())
+            dst.resize(dst.size() * 2);
+
+        strm.next_out = (Bytef*)&dst[pos];
+        strm.avail_out = (uInt)(dst.size() - pos);
+        ret = inflate(&strm, Z_NO_FLUSH);
+        pos = dst.size() - strm.avail_out;
+    } while (ret == Z_OK);
+    inflateEnd(&strm);
+
+    if (ret != Z_STREAM_END)
+        return -1;
+
+    dst.resize(pos);
+    report.swap(dst);
+    return 0;
+}
+
+//***************************************************************************
+// ZStd
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool Compression::compress_zstd(std::string& report, const char* src, size_t src_len, int& dictionary_id) const
+{
+#ifdef HAVE_ZSTD
+    int level = levels[MediaConchLib::compression_ZStd];
+    if (!level)
+        level = ZSTD_CLEVEL_DEFAULT;
+
+    ZSTD_CCtx* ctx = ZSTD_createCCtx();
+    if (!ctx)
+        return false;
+
+    // Size of the report is written in the frame
+    char* dst = new char[src_len + 1];
+    size_t dst_len;
+    if (zstd_cdict)
+        dst_len = ZSTD_compress_usingCDict(ctx, dst, src_len, src, src_len, zstd_cdict);
+    else
+        dst_len = ZSTD_compressCCtx(ctx, dst, src_len, src, src_len, level);
+    ZSTD_freeCCtx(ctx);
+
+    bool done = false;
+    if (!ZSTD_isError(dst_len) && dst_len < src_len)
+    {
+        report = std::string(dst, dst_len);
+        dictionary_id = zstd_cdict ? zstd_dictionary_id : 0;
+        done = true;
+    }
+    delete [] dst;
+    return done;
+#else
+    (void)report;
+    (void)src;
+    (void)src_len;
+    (void)dictionary_id;
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+int Compression::uncompress_zstd(std::string& report, int dictionary_id) const
+{
+#ifdef HAVE_ZSTD
+    // The dictionary must be the one used by the compression
+    if (dictionary_id < 0)
+        dictionary_id = zstd_dictionary_id;
+
+    const ZSTD_DDict* ddict = NULL;
+    if (dictionary_id)
+    {
+        std::map<int, ZSTD_DDict*>::const_iterator it = zstd_ddicts.find(dictionary_id);
+        if (it == zstd_ddicts.end())
+            return -1;
+        ddict = it->second;
+    }
+
+    unsigned long long size = ZSTD_getFrameContentSize(report.c_str(), report.length());
+    if (size == ZSTD_CONTENTSIZE_ERROR || size == ZSTD_CONTENTSIZE_UNKNOWN || size != (size_t)size)
+        return -1;
+
+    ZSTD_DCtx* ctx = ZSTD_createDCtx();
+    if (!ctx)
+        return -1;
+
+    std::string dst;
+    dst.resize((size_t)size);
+    size_t dst_len;
+    if (ddict)
+        dst_len = ZSTD_decompress_usingDDict(ctx, &dst[0], dst.size(), report.c_str(), report.length(), ddict);
+    else
+        dst_len = ZSTD_decompressDCtx(ctx, &dst[0], dst.size(), report.c_str(), report.length());
+    ZSTD_freeDCtx(ctx);
+
+    if (ZSTD_isError(dst_len) || dst_len != dst.size())
+        return -1;
+
+    report.swap(dst);
+    return 0;
+#else
+    (void)report;
+    (void)dictionary_id;
+    return -1;
+#endif
+}
+
+//---------------------------------------------------------------------------
+void Compression::create_zstd_dictionaries()
+{
+#ifdef HAVE_ZSTD
+    // Only the compression dictionary depends on the level, the others are kept
+    if (zstd_cdict)
+        ZSTD_freeCDict(zstd_cdict);
+    zstd_cdict = NULL;
+    if (zstd_dictionary.empty())
+        return;
+
+    int level = levels[MediaConchLib::compression_ZStd];
+    if (!level)
+        level = ZSTD_CLEVEL_DEFAULT;
+
+    zstd_cdict = ZSTD_createCDict(zstd_dictionary.c_str(), zstd_dictionary.size(), level);
+    if (zstd_ddicts.find(zstd_dictionary_id) == zstd_ddicts.end())
+    {
+        ZSTD_DDict* ddict = ZSTD_createDDict(zstd_dictionary.c_str(), zstd_dictionary.size());
+        if (ddict)
+            zstd_ddicts[zstd_dictionary_id] = ddict;
+    }
+#endif
+}
+
+//---------------------------------------------------------------------------
+void Compression::free_zstd_dictionaries()
+{
+#ifdef HAVE_ZSTD
+    if (zstd_cdict)
+        ZSTD_freeCDict(zstd_cdict);
+    zstd_cdict = NULL;
+    std::map<int, ZSTD_DDict*>::iterator it = zstd_ddicts.begin();
+    for (; it != zstd_ddicts.end(); ++it)
+        ZSTD_freeDDict(it->second);
+    zstd_ddicts.clear();
+#endif
+}
+
+//***************************************************************************
+// LZ4
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool Compression::compress_lz4(std::string& report, const char* src, size_t src_len) const
+{
+#ifdef HAVE_LZ4
+    // Size of the report is written in the frame, level 3 and more use LZ4 HC
+    LZ4F_preferences_t prefs;
+    memset(&prefs, 0, sizeof(prefs));
+    prefs.frameInfo.contentSize = src_len;
+    prefs.compressionLevel = levels[MediaConchLib::compression_LZ4];
+
+    size_t bound = LZ4F_compressFrameBound(src_len, &prefs);
+    char* dst = new char[bound];
+    size_t dst_len = LZ4F_compressFrame(dst, bound, src, src_len, &prefs);
+
+    bool done = false;
+    if (!LZ4F_isError(dst_len) && dst_len < src_len)
+    {
+        report = std::string(dst, dst_len);
+        done = true;
+    }
+    delete [] dst;
+    return done;
+#else
+    (void)report;
+    (void)src;
+    (void)src_len;
+    return false;
+#endif
+}
+
+//---------------------------------------------------------------------------
+int Compression::uncompress_lz4(std::string& report) const
+{
+#ifdef HAVE_LZ4
+    LZ4F_dctx* ctx = NULL;
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION)))
+        return -1;
+
+    LZ4F_frameInfo_t info;
+    memset(&info, 0, sizeof(info));
+    size_t src_pos = report.length();
+    if (LZ4F_isError(LZ4F_getFrameInfo(ctx, &info, report.c_str(), &src_pos))
+     || !info.contentSize || info.contentSize != (size_t)info.contentSize)
+    {
+        LZ4F_freeDecompressionContext(ctx);
+        return -1;
+    }
+
+    std::string dst;
+    dst.resize((size_t)info.contentSize);
+    size_t dst_pos = 0;
+    size_t ret = 1;
+    while (ret && src_pos < report.length() && dst_pos < dst.size())
+    {
+        size_t dst_len = dst.size() - dst_pos;
+        size_t src_len = report.length() - src_pos;
+        ret = LZ4F_decompress(ctx, &dst[dst_pos], &dst_len, report.c_str() + src_pos, &src_len, NULL);
+        if (LZ4F_isError(ret))
+            break;
+        dst_pos += dst_len;
+        src_pos += src_len;
+    }
+    LZ4F_freeDecompressionContext(ctx);
+
+    if (LZ4F_isError(ret) || dst_pos != dst.size())
+        return -1;
+
+    report.swap(dst);
+    return 0;
+#else
+    (void)report;
+    return -1;
+#endif
+}
+
+}
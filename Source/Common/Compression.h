@@ -0,0 +1,89 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Compression of the reports saved in the database
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifndef CompressionH
+#define CompressionH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "MediaConchLib.h"
+#include <string>
+#include <map>
+//---------------------------------------------------------------------------
+
+#ifdef HAVE_ZSTD
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+#endif
+
+namespace MediaConch {
+
+//***************************************************************************
+// Class Compression
+//***************************************************************************
+
+// Codecs which are not available fall back to zlib, the mode used is
+// returned to be saved with the report.
+class Compression
+{
+public:
+    //Constructor/Destructor
+    Compression();
+    ~Compression();
+
+    // Configuration, 0 is the default level of the codec
+    void set_level(MediaConchLib::compression compress, int level);
+    int  set_zstd_dictionary(const std::string& dictionary, std::string& err);
+    // Dictionaries used before, only to uncompress the reports saved with them
+    int  add_zstd_previous_dictionary(const std::string& dictionary, std::string& err);
+
+    static bool is_available(MediaConchLib::compression compress);
+    static int  get_compression_from_name(const std::string& name, MediaConchLib::compression& compress);
+
+    // Compression, can be used by several threads
+    // The dictionary used (0 if none) is returned to be saved with the report
+    void compress(std::string& report, MediaConchLib::compression& compress, int& dictionary_id) const;
+    void compress_copy(std::string& report, const char* src, size_t src_len, MediaConchLib::compression& compress,
+                       int& dictionary_id) const;
+    // Size of the report before the compression, 0 if unknown
+    // Dictionary saved with the report, -1 if unknown (reports saved before) for the current one
+    int  uncompress(std::string& report, MediaConchLib::compression compress, size_t uncompressed_size=0,
+                    int dictionary_id=-1) const;
+
+private:
+    Compression(const Compression&);
+    Compression& operator=(const Compression&);
+
+    int                  levels[MediaConchLib::compression_Max];
+    std::string          zstd_dictionary;
+    int                  zstd_dictionary_id;
+#ifdef HAVE_ZSTD
+    struct ZSTD_CDict_s *zstd_cdict;
+    // Current and previous dictionaries, by id
+    std::map<int, struct ZSTD_DDict_s*> zstd_ddicts;
+#endif
+
+    static int get_dictionary_id(const std::string& dictionary);
+    bool compress_zlib(std::string& report, const char* src, size_t src_len) const;
+    bool compress_zstd(std::string& report, const char* src, size_t src_len, int& dictionary_id) const;
+    bool compress_lz4(std::string& report, const char* src, size_t src_len) const;
+    int  uncompress_zlib(std::string& report, size_t uncompressed_size) const;
+    int  uncompress_zstd(std::string& report, int dictionary_id) const;
+    int  uncompress_lz4(std::string& report) const;
+    void create_zstd_dictionaries();
+    void free_zstd_dictionaries();
+};
+
+}
+
+#endif
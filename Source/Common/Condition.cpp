@@ -0,0 +1,134 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifdef __BORLANDC__
+    #pragma hdrstop
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "Condition.h"
+#if !defined(_WIN32) && !defined(WIN32)
+#include <sys/time.h>
+#include <time.h>
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// Constructor/Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+Condition::Condition()
+{
+#if defined(_WIN32) || defined(WIN32)
+    InitializeCriticalSection(&mutex);
+    InitializeConditionVariable(&cond);
+#else
+    pthread_mutex_init(&mutex, NULL);
+    pthread_cond_init(&cond, NULL);
+#endif
+}
+
+//---------------------------------------------------------------------------
+Condition::~Condition()
+{
+#if defined(_WIN32) || defined(WIN32)
+    DeleteCriticalSection(&mutex);
+#else
+    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&mutex);
+#endif
+}
+
+//***************************************************************************
+// Lock
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void Condition::lock()
+{
+#if defined(_WIN32) || defined(WIN32)
+    EnterCriticalSection(&mutex);
+#else
+    pthread_mutex_lock(&mutex);
+#endif
+}
+
+//---------------------------------------------------------------------------
+void Condition::unlock()
+{
+#if defined(_WIN32) || defined(WIN32)
+    LeaveCriticalSection(&mutex);
+#else
+    pthread_mutex_unlock(&mutex);
+#endif
+}
+
+//***************************************************************************
+// Wait
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void Condition::wait()
+{
+#if defined(_WIN32) || defined(WIN32)
+    SleepConditionVariableCS(&cond, &mutex, INFINITE);
+#else
+    pthread_cond_wait(&cond, &mutex);
+#endif
+}
+
+//---------------------------------------------------------------------------
+bool Condition::wait_for(size_t timeout)
+{
+#if defined(_WIN32) || defined(WIN32)
+    if (!SleepConditionVariableCS(&cond, &mutex, (DWORD)timeout))
+        return GetLastError() != ERROR_TIMEOUT;
+    return true;
+#else
+    struct timeval now;
+    gettimeofday(&now, NULL);
+
+    struct timespec until;
+    until.tv_sec = now.tv_sec + (time_t)(timeout / 1000);
+    long nsec = now.tv_usec * 1000 + (long)(timeout % 1000) * 1000000;
+    until.tv_sec += nsec / 1000000000;
+    until.tv_nsec = nsec % 1000000000;
+
+    return pthread_cond_timedwait(&cond, &mutex, &until) == 0;
+#endif
+}
+
+//***************************************************************************
+// Notify
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void Condition::signal()
+{
+#if defined(_WIN32) || defined(WIN32)
+    WakeConditionVariable(&cond);
+#else
+    pthread_cond_signal(&cond);
+#endif
+}
+
+//---------------------------------------------------------------------------
+void Condition::broadcast()
+{
+#if defined(_WIN32) || defined(WIN32)
+    WakeAllConditionVariable(&cond);
+#else
+    pthread_cond_broadcast(&cond);
+#endif
+}
+
+}
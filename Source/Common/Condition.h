@@ -0,0 +1,84 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Condition functions
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifndef ConditionH
+#define ConditionH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#if defined(_WIN32) || defined(WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+#include <cstddef>
+//---------------------------------------------------------------------------
+
+namespace MediaConch {
+
+//***************************************************************************
+// Class Condition
+//***************************************************************************
+
+// Mutex and condition variable pair: wait() and wait_for() must be called
+// with the condition locked
+class Condition
+{
+public:
+    //Constructor/Destructor
+    Condition();
+    ~Condition();
+
+    void lock();
+    void unlock();
+
+    void wait();
+    // Return false if the timeout (in milliseconds) expired
+    bool wait_for(size_t timeout);
+
+    void signal();
+    void broadcast();
+
+private:
+    Condition(const Condition&);
+    Condition& operator=(const Condition&);
+
+#if defined(_WIN32) || defined(WIN32)
+    CRITICAL_SECTION   mutex;
+    CONDITION_VARIABLE cond;
+#else
+    pthread_mutex_t    mutex;
+    pthread_cond_t     cond;
+#endif
+};
+
+//***************************************************************************
+// Class ConditionLocker
+//***************************************************************************
+
+class ConditionLocker
+{
+public:
+    ConditionLocker(Condition& c) : condition(c) { condition.lock(); }
+    ~ConditionLocker() { condition.unlock(); }
+
+private:
+    ConditionLocker(const ConditionLocker&);
+    ConditionLocker& operator=(const ConditionLocker&);
+
+    Condition& condition;
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 #include "PluginLog.h"
 #include "Common/Xslt.h"
 #include "Common/WatchFoldersManager.h"
+#include "Common/FileFingerprint.h"
 #include "Common/PluginsManager.h"
 #include "Common/PluginsConfig.h"
 #include "Common/Plugin.h"
@@ -31,7 +32,6 @@
 #include "ZenLib/Ztring.h"
 #include "ZenLib/File.h"
 #include "ZenLib/Dir.h"
-#include <zlib.h>
 #include <algorithm>
 #include <sstream>
 #include <fstream>
@@ -79,6 +79,15 @@ Core::Core() : policies(this), reports(this)
     watch_folders_manager = new WatchFoldersManager(this);
     policies.create_values_from_csv();
     compression_mode = MediaConchLib::compression_ZLib;
+    for (size_t i = 0; i < MediaConchLib::report_Max; ++i)
+        report_compression_modes[i] = MediaConchLib::compression_Max;
+    database_batch_files = 1;
+    database_batch_pending = 0;
+    database_batch_opened = false;
+    db_readers_max = 4;
+    ecb.log = NULL;
+    ecb.analyze_finished = NULL;
+    ecb.analyze_finished_arg = NULL;
 }
 
 Core::~Core()
@@ -89,8 +98,15 @@ Core::~Core()
         delete scheduler;
     if (plugins_manager)
         delete plugins_manager;
+    // Not used to log the failure of the last batch
+    plugins_manager = NULL;
+    for (size_t i = 0; i < db_readers.size(); ++i)
+        delete db_readers[i];
     if (db)
+    {
+        flush_database_batch();
         delete db;
+    }
     delete MI;
     if (config)
         delete config;
@@ -133,6 +149,20 @@ void Core::load_configuration()
         scheduler->set_max_threads((size_t)scheduler_max_threads);
     }
 
+    long doc_cache_size = 0;
+    if (!config->get("Validation_Doc_Cache_Size", doc_cache_size) && doc_cache_size > 0)
+        reports.set_doc_cache_size((size_t)doc_cache_size);
+
+    long batch_files = 1;
+    if (!config->get("Database_Batch_Files", batch_files) && batch_files > 0)
+        database_batch_files = (size_t)batch_files;
+
+    long readers = 0;
+    if (!config->get("Database_Readers", readers) && readers >= 0)
+        db_readers_max = (size_t)readers;
+
+    load_compression_configuration();
+
     std::vector<Container::Value> plugins;
     if (!config->get("Plugins", plugins))
     {
@@ -142,6 +172,67 @@ void Core::load_configuration()
     }
 }
 
+//---------------------------------------------------------------------------
+void Core::load_compression_configuration()
+{
+    long level;
+    if (!config->get("Compression_Level_ZLib", level))
+        compressor.set_level(MediaConchLib::compression_ZLib, (int)level);
+    if (!config->get("Compression_Level_ZStd", level))
+        compressor.set_level(MediaConchLib::compression_ZStd, (int)level);
+    if (!config->get("Compression_Level_LZ4", level))
+        compressor.set_level(MediaConchLib::compression_LZ4, (int)level);
+
+    std::string dictionary_file;
+    if (!config->get("Compression_ZStd_Dictionary", dictionary_file))
+    {
+        std::ifstream file(dictionary_file.c_str(), std::ios_base::in | std::ios_base::binary);
+        std::stringstream dictionary;
+        dictionary << file.rdbuf();
+
+        std::string error;
+        if (!file.is_open() || compressor.set_zstd_dictionary(dictionary.str(), error) < 0)
+            plugin_add_log(PluginLog::LOG_LEVEL_ERROR, "Cannot use the zstd dictionary " + dictionary_file);
+    }
+
+    // Dictionaries replaced, still needed by the reports compressed with them
+    std::vector<Container::Value> previous_files;
+    if (!config->get("Compression_ZStd_Previous_Dictionaries", previous_files))
+    {
+        for (size_t i = 0; i < previous_files.size(); ++i)
+        {
+            if (previous_files[i].type != Container::Value::CONTAINER_TYPE_STRING)
+                continue;
+
+            std::ifstream file(previous_files[i].s.c_str(), std::ios_base::in | std::ios_base::binary);
+            std::stringstream dictionary;
+            dictionary << file.rdbuf();
+
+            std::string error;
+            if (!file.is_open() || compressor.add_zstd_previous_dictionary(dictionary.str(), error) < 0)
+                plugin_add_log(PluginLog::LOG_LEVEL_ERROR, "Cannot use the zstd dictionary " + previous_files[i].s);
+        }
+    }
+
+    // Per report kind, ex: {"MicroMediaTrace": "LZ4", "MediaInfo": "ZStd"}
+    std::map<std::string, Container::Value> modes;
+    if (config->get("Compression_Report_Modes", modes))
+        return;
+
+    const char* names[MediaConchLib::report_Max] = {"MediaConch", "MediaInfo", "MediaTrace", "VeraPDF", "DPFManager", "MicroMediaTrace"};
+    for (size_t i = 0; i < MediaConchLib::report_Max; ++i)
+    {
+        std::map<std::string, Container::Value>::iterator it = modes.find(names[i]);
+        if (it == modes.end() || it->second.type != Container::Value::CONTAINER_TYPE_STRING)
+            continue;
+
+        MediaConchLib::compression mode;
+        if (Compression::get_compression_from_name(it->second.s, mode) < 0)
+            continue;
+        report_compression_modes[i] = mode;
+    }
+}
+
 //---------------------------------------------------------------------------
 void Core::load_plugins_configuration()
 {
@@ -158,8 +249,13 @@ void Core::load_database()
     if (!config || config->get("SQLite_Path", db_path) < 0)
         db_path = get_database_path();
 
-    db = new SQLLiteReport;
+    SQLLiteReport *sqlite_db = new SQLLiteReport;
 
+    std::map<std::string, std::string> pragmas;
+    get_sqlite_pragmas(pragmas);
+    sqlite_db->set_pragmas(pragmas);
+
+    db = sqlite_db;
     ((Database*)db)->set_database_directory(db_path);
     db->set_database_filename(database_name);
     if (db->init_report() < 0)
@@ -167,6 +263,8 @@ void Core::load_database()
         delete db;
         db = NULL;
     }
+    else
+        open_database_readers();
 #endif
     if (!db)
     {
@@ -175,6 +273,48 @@ void Core::load_database()
     }
 }
 
+//---------------------------------------------------------------------------
+void Core::get_sqlite_pragmas(std::map<std::string, std::string>& pragmas) const
+{
+    std::string str;
+    long value;
+    if (config)
+    {
+        if (!config->get("SQLite_Journal_Mode", str))
+            pragmas["journal_mode"] = str;
+        if (!config->get("SQLite_Synchronous", str))
+            pragmas["synchronous"] = str;
+
+        if (!config->get("SQLite_Cache_Size", value))
+        {
+            std::stringstream size;
+            size << value;
+            pragmas["cache_size"] = size.str();
+        }
+        if (!config->get("SQLite_Mmap_Size", value))
+        {
+            std::stringstream size;
+            size << value;
+            pragmas["mmap_size"] = size.str();
+        }
+        if (!config->get("SQLite_Busy_Timeout", value))
+        {
+            std::stringstream timeout;
+            timeout << value;
+            pragmas["busy_timeout"] = timeout.str();
+        }
+    }
+
+    if (!db_readers_max)
+        return;
+
+    // With WAL, the readers are not blocked by the writer
+    if (pragmas.find("journal_mode") == pragmas.end())
+        pragmas["journal_mode"] = "WAL";
+    if (pragmas.find("busy_timeout") == pragmas.end())
+        pragmas["busy_timeout"] = "5000";
+}
+
 //---------------------------------------------------------------------------
 const std::map<std::string, std::string>& Core::get_implementation_options() const
 {
@@ -259,6 +399,14 @@ void Core::set_compression_mode(MediaConchLib::compression compress)
     compression_mode = compress;
 }
 
+//---------------------------------------------------------------------------
+MediaConchLib::compression Core::get_compression_mode(MediaConchLib::report report_kind) const
+{
+    if (report_kind < MediaConchLib::report_Max && report_compression_modes[report_kind] != MediaConchLib::compression_Max)
+        return report_compression_modes[report_kind];
+    return compression_mode;
+}
+
 //---------------------------------------------------------------------------
 int Core::get_ui_poll_request() const
 {
@@ -368,6 +516,48 @@ int Core::mediaconch_remove_watch_folder(const std::string& folder, std::string&
     return watch_folders_manager->remove_watch_folder(folder, error);
 }
 
+//---------------------------------------------------------------------------
+int Core::watch_folder_get_user(const std::string& folder, long& user, std::string& err)
+{
+    DatabaseReport* reader = get_db_reader();
+    int ret = reader->get_watch_folder_user(folder, user, err);
+    release_db_reader(reader);
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+int Core::watch_folder_get_files(int user, const std::string& folder, std::vector<DatabaseWatchFolderFile>& files,
+                                 std::string& err)
+{
+    DatabaseReport* reader = get_db_reader();
+    int ret = reader->get_watch_folder_files(user, folder, files, err);
+    release_db_reader(reader);
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+int Core::watch_folder_save_files(int user, const std::string& folder, const std::vector<DatabaseWatchFolderFile>& files,
+                                  const std::vector<std::string>& removed, std::string& err)
+{
+    db_mutex.Enter();
+    int ret = get_db()->save_watch_folder_files(user, folder, files, removed, err);
+    db_mutex.Leave();
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+int Core::watch_folder_remove_files(int user, const std::string& folder, std::string& err)
+{
+    db_mutex.Enter();
+    int ret = get_db()->remove_watch_folder(user, folder, err);
+    db_mutex.Leave();
+
+    return ret;
+}
+
 //***************************************************************************
 // Checker
 //***************************************************************************
@@ -375,9 +565,9 @@ int Core::mediaconch_remove_watch_folder(const std::string& folder, std::string&
 //---------------------------------------------------------------------------
 void Core::get_users_ids(std::vector<long>& ids, std::string& err)
 {
-    db_mutex.Enter();
-    get_db()->get_users_id(ids, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    reader->get_users_id(ids, err);
+    release_db_reader(reader);
 }
 
 //***************************************************************************
@@ -417,6 +607,7 @@ long Core::checker_analyze(int user, const std::string& file, bool& registered,
             std::vector<long> generated_id;
             db_mutex.Enter();
             get_db()->remove_report(user, id, err);
+            reports.reports_changed(user, id);
             id = get_db()->update_file(user, id, file_last_modification, options_str, err, generated_id);
             db_mutex.Leave();
             if (id < 0)
@@ -425,7 +616,9 @@ long Core::checker_analyze(int user, const std::string& file, bool& registered,
         registered = true;
     }
 
-    if (!analyzed && scheduler->add_element_to_queue(user, file, id, options, plugins, mil_analyze) < 0)
+    // The plugins may create other files, their analysis is not reused
+    if (!analyzed && scheduler->add_element_to_queue(user, file, id, options, plugins, mil_analyze, "",
+                                                     !force_analyze && plugins.empty() && mil_analyze) < 0)
         return -1;
 
     return id;
@@ -528,14 +721,14 @@ int Core::checker_status(int user, long file_id, MediaConchLib::Checker_StatusRe
         std::string generated_error_log;
         std::string options;
 
-        db_mutex.Enter();
-        ret = get_db()->get_file_information_from_id(user, file_id, filename, file_time,
-                                               res.generated_id, res.source_id, generated_time,
-                                               generated_log, generated_error_log, options, res.finished,
-                                               res.has_error, res.error_log, err);
+        DatabaseReport* reader = get_db_reader();
+        ret = reader->get_file_information_from_id(user, file_id, filename, file_time,
+                                                   res.generated_id, res.source_id, generated_time,
+                                                   generated_log, generated_error_log, options, res.finished,
+                                                   res.has_error, res.error_log, err);
         if (ret == 0 && res.finished)
-            ret = get_db()->get_element_report_kind(user, file_id, (MediaConchLib::report&)*res.tool, err);
-        db_mutex.Leave();
+            ret = reader->get_element_report_kind(user, file_id, (MediaConchLib::report&)*res.tool, err);
+        release_db_reader(reader);
     }
     else
     {
@@ -546,12 +739,38 @@ int Core::checker_status(int user, long file_id, MediaConchLib::Checker_StatusRe
     return ret;
 }
 
+//---------------------------------------------------------------------------
+int Core::checker_wait_finished(int user, const std::vector<long>& files, std::vector<long>& finished,
+                                std::string& err, size_t timeout)
+{
+    if (!scheduler)
+    {
+        err = "Scheduler is not initialized.";
+        return -1;
+    }
+
+    return scheduler->wait_elements_finished(user, files, finished, timeout);
+}
+
+//---------------------------------------------------------------------------
+int Core::checker_events(int user, long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res,
+                         std::string& err)
+{
+    if (!scheduler)
+    {
+        err = "Scheduler is not initialized.";
+        return -1;
+    }
+
+    return scheduler->get_events(user, last_event, timeout, res);
+}
+
 //---------------------------------------------------------------------------
 int Core::checker_file_from_id(int user, long id, std::string& file, std::string& err)
 {
-    db_mutex.Enter();
-    int ret = get_db()->get_file_name_from_id(user, id, file, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    int ret = reader->get_file_name_from_id(user, id, file, err);
+    release_db_reader(reader);
 
     return ret;
 }
@@ -564,9 +783,9 @@ long Core::checker_id_from_filename(int user, const std::string& filename,
     std::string time = get_last_modification_file(filename);
     std::string options_str = serialize_string_from_options_vec(options);
 
-    db_mutex.Enter();
-    long id = get_db()->get_file_id(user, filename, time, options_str, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    long id = reader->get_file_id(user, filename, time, options_str, err);
+    release_db_reader(reader);
 
     return id;
 }
@@ -576,18 +795,72 @@ int Core::checker_file_information(int user, long id, MediaConchLib::Checker_Fil
 {
     std::string options;
     int ret = 0;
-    db_mutex.Enter();
-    ret = get_db()->get_file_information_from_id(user, id, info.filename, info.file_last_modification,
-                                                 info.generated_id, info.source_id, info.generated_time,
-                                                 info.generated_log, info.generated_error_log, options,
-                                                 info.analyzed, info.has_error, info.error_log, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    ret = reader->get_file_information_from_id(user, id, info.filename, info.file_last_modification,
+                                               info.generated_id, info.source_id, info.generated_time,
+                                               info.generated_log, info.generated_error_log, options,
+                                               info.analyzed, info.has_error, info.error_log, err);
+    release_db_reader(reader);
 
     if (ret == 0)
         info.options = parse_options_vec_from_string(options);
     return ret;
 }
 
+//---------------------------------------------------------------------------
+int Core::checker_get_report_raw(int user, long id, MediaConchLib::report kind, bool accept_zlib,
+                                 std::string& report, MediaConchLib::compression& compress,
+                                 size_t& uncompressed_size, std::string& err)
+{
+    // The trace is saved in its micro format
+    if (kind == MediaConchLib::report_MediaTrace)
+        kind = MediaConchLib::report_MicroMediaTrace;
+
+    if (kind != MediaConchLib::report_MediaInfo && kind != MediaConchLib::report_MicroMediaTrace &&
+        kind != MediaConchLib::report_MediaVeraPdf && kind != MediaConchLib::report_MediaDpfManager)
+    {
+        err = "Report kind asked is not saved.";
+        return -1;
+    }
+
+    if (!get_db())
+    {
+        err = "The database is not correctly set.";
+        return -1;
+    }
+
+    if (kind == MediaConchLib::report_MicroMediaTrace)
+    {
+        std::vector<long> files(1, id);
+        if (checker_create_mediatrace(user, files, err) < 0)
+            return -1;
+    }
+
+    compress = MediaConchLib::compression_None;
+    uncompressed_size = 0;
+    int dictionary_id = -1;
+
+    DatabaseReport* reader = get_db_reader();
+    int ret = reader->get_report(user, id, kind, MediaConchLib::format_Xml, "", report, compress,
+                                 uncompressed_size, dictionary_id, err);
+    release_db_reader(reader);
+    if (ret < 0)
+        return -1;
+
+    // zlib is the deflate encoding of HTTP, the report is given as saved
+    if (compress == MediaConchLib::compression_ZLib && accept_zlib)
+        return 0;
+
+    if (compressor.uncompress(report, compress, uncompressed_size, dictionary_id) < 0)
+    {
+        err = "The report saved cannot be uncompressed.";
+        return -1;
+    }
+    compress = MediaConchLib::compression_None;
+    uncompressed_size = report.size();
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int Core::checker_list(int user, std::vector<std::string>& vec, std::string& err)
 {
@@ -596,9 +869,9 @@ int Core::checker_list(int user, std::vector<std::string>& vec, std::string& err
     if (ret < 0)
         return ret;
 
-    db_mutex.Enter();
-    ret = get_db()->get_elements(user, vec, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    ret = reader->get_elements(user, vec, err);
+    release_db_reader(reader);
     return ret;
 }
 
@@ -609,9 +882,9 @@ int Core::checker_list(int user, std::vector<long>& vec, std::string& err)
     if (ret < 0)
         return ret;
 
-    db_mutex.Enter();
-    ret = get_db()->get_elements(user, vec, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    ret = reader->get_elements(user, vec, err);
+    release_db_reader(reader);
 
     return ret;
 }
@@ -635,6 +908,7 @@ int Core::checker_clear(int user, const std::vector<long>& files, std::string& e
                 ret = -1;
             if (get_db()->remove_file(user, files[i], err) < 0)
                 ret = -1;
+            reports.reports_changed(user, files[i]);
         }
         db_mutex.Leave();
     }
@@ -645,6 +919,7 @@ int Core::checker_clear(int user, const std::vector<long>& files, std::string& e
             ret = -1;
         if (get_db()->remove_all_files(user, err) < 0)
             ret = -1;
+        reports.all_reports_changed();
         db_mutex.Leave();
     }
 
@@ -658,111 +933,59 @@ int Core::checker_stop(int user, const std::vector<long>& files, std::string& er
 }
 
 //---------------------------------------------------------------------------
-void Core::unify_no_https(std::string& str)
+int Core::checker_create_mediatrace(int user, const std::vector<long>& files, std::string& err)
 {
-    size_t pos;
-    while ((pos = str.find("https://")) != std::string::npos)
-        str.replace(pos + 4, 1, "");
-}
+    if (!mediatrace_on_demand_is_enabled() || !get_db())
+        return 0;
 
-//---------------------------------------------------------------------------
-bool Core::accepts_https()
-{
-    return MI->Option(__T("Https_Get")) != __T("0"); //With test on "0", we handle old version of MediaInfoLib which do not have this option
-}
+    std::vector<long> pending;
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        // Reports are registered at the end of the analysis
+        scheduler->wait_element_finished(user, files[i]);
+
+        bool registered = false;
+        DatabaseReport* reader = get_db_reader();
+        int ret = reader->report_is_registered(user, files[i], MediaConchLib::report_MicroMediaTrace,
+                                               MediaConchLib::format_Xml, "", registered, err);
+        release_db_reader(reader);
+        if (ret < 0)
+            return -1;
+        if (registered)
+            continue;
 
-//***************************************************************************
-// Compression
-//***************************************************************************
+        MediaConchLib::Checker_FileInfo info;
+        if (checker_file_information(user, files[i], info, err) < 0)
+            return -1;
 
-//---------------------------------------------------------------------------
-void Core::compress_report(std::string& report, MediaConchLib::compression& compress)
-{
-    if (compress == MediaConchLib::compression_None || compress >= MediaConchLib::compression_Max)
-        return;
+        if (!file_is_existing(info.filename))
+        {
+            err = "File is not existing anymore, its MediaTrace cannot be created.";
+            return -1;
+        }
 
-    if (compress == MediaConchLib::compression_ZLib)
-    {
-        uLongf dst_len, src_len;
+        scheduler->add_trace_to_queue(user, info.filename, files[i], info.options);
+        pending.push_back(files[i]);
+    }
 
-        src_len = report.length();
-        dst_len = src_len;
-        Bytef* dst = new Bytef [src_len + 1];
+    for (size_t i = 0; i < pending.size(); ++i)
+        scheduler->wait_element_finished(user, pending[i]);
 
-        if (compress2((Bytef*)dst, &dst_len, (const Bytef*)report.c_str(), src_len, Z_BEST_COMPRESSION) != Z_OK || src_len <= dst_len)
-            //Fallback to no compression
-            compress = MediaConchLib::compression_None;
-        else
-            report = std::string((const char *)dst, dst_len);
-        delete [] dst;
-    }
+    return 0;
 }
 
 //---------------------------------------------------------------------------
-void Core::compress_report_copy(std::string& report, const char* src, size_t src_len, MediaConchLib::compression& compress)
+void Core::unify_no_https(std::string& str)
 {
-    switch (compress)
-    {
-        case MediaConchLib::compression_ZLib:
-        {
-            uLongf dst_len;
-
-            dst_len = (uLongf)src_len;
-            Bytef* dst = new Bytef[src_len + 1];
-
-            if (compress2((Bytef*)dst, &dst_len, (const Bytef*)src, src_len, Z_BEST_COMPRESSION) != Z_OK || src_len <= dst_len)
-            {
-                //Fallback to no compression
-                report = std::string((const char *)src, src_len);
-                compress = MediaConchLib::compression_None;
-            }
-            else
-                report = std::string((const char *)dst, dst_len);
-            delete[] dst;
-        }
-        break;
-        default:
-            report = std::string((const char *)src, src_len);
-    }
+    size_t pos;
+    while ((pos = str.find("https://")) != std::string::npos)
+        str.replace(pos + 4, 1, "");
 }
 
 //---------------------------------------------------------------------------
-int Core::uncompress_report(std::string& report, MediaConchLib::compression compress)
+bool Core::accepts_https()
 {
-    switch (compress)
-    {
-        case MediaConchLib::compression_None:
-            break;
-        case MediaConchLib::compression_ZLib:
-            uLongf dst_len, src_len;
-
-            src_len = report.length();
-            dst_len = src_len;
-
-            do
-            {
-                Bytef* dst = new Bytef [dst_len + 1];
-
-                int ret;
-                if ((ret = uncompress(dst, &dst_len, (const Bytef*)report.c_str(), src_len)) != Z_OK)
-                {
-                    delete [] dst;
-                    if (ret == Z_BUF_ERROR)
-                    {
-                        dst_len <<= 1;
-                        continue;
-                    }
-                    return -1;
-                }
-                report = std::string((const char*)dst, dst_len);
-                delete [] dst;
-                break;
-            } while (1);
-            break;
-        default:
-            break;
-    }
-    return 0;
+    return MI->Option(__T("Https_Get")) != __T("0"); //With test on "0", we handle old version of MediaInfoLib which do not have this option
 }
 
 //***************************************************************************
@@ -783,62 +1006,69 @@ bool Core::file_is_existing(const std::string& filename)
 }
 
 //---------------------------------------------------------------------------
-void Core::register_report_xml_to_database(int user, long file, const std::string& report,
-                                           MediaConchLib::report report_kind, const std::string& options)
+void Core::add_report_xml_to_save(const std::string& report, MediaConchLib::report report_kind,
+                                  const std::string& options, std::vector<DatabaseReportEntry>& entries)
 {
-    MediaConchLib::compression mode = compression_mode;
-    std::string new_report(report);
-    compress_report(new_report, mode);
-
-    std::string err;
-    db_mutex.Enter();
-    get_db()->save_report(user, file, report_kind, MediaConchLib::format_Xml,
-                          options, new_report, mode, true, err);
-    db_mutex.Leave();
+    entries.push_back(DatabaseReportEntry());
+    DatabaseReportEntry& entry = entries.back();
+    entry.report_kind = report_kind;
+    entry.format = MediaConchLib::format_Xml;
+    entry.options = options;
+    entry.report = report;
+    entry.uncompressed_size = entry.report.size();
+    entry.compress = get_compression_mode(report_kind);
+    entry.mil_version = true;
+    compressor.compress(entry.report, entry.compress, entry.dictionary_id);
 }
 
 //---------------------------------------------------------------------------
-void Core::register_report_mediainfo_text_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* curMI)
+void Core::add_report_mediainfo_text_to_save(MediaInfoNameSpace::MediaInfo* curMI, std::vector<DatabaseReportEntry>& entries)
 {
     curMI->Option(__T("Details"), __T("0"));
     curMI->Option(__T("Inform"), String());
-    std::string report = Ztring(curMI->Inform()).To_UTF8();
-
-    MediaConchLib::compression mode = compression_mode;
-    compress_report(report, mode);
 
-    std::string err;
-    db_mutex.Enter();
-    get_db()->save_report(user, file, MediaConchLib::report_MediaInfo, MediaConchLib::format_Text,
-                          "", report, mode, true, err);
-    db_mutex.Leave();
+    entries.push_back(DatabaseReportEntry());
+    DatabaseReportEntry& entry = entries.back();
+    entry.report_kind = MediaConchLib::report_MediaInfo;
+    entry.format = MediaConchLib::format_Text;
+    entry.report = Ztring(curMI->Inform()).To_UTF8();
+    entry.uncompressed_size = entry.report.size();
+    entry.compress = get_compression_mode(MediaConchLib::report_MediaInfo);
+    entry.mil_version = true;
+    compressor.compress(entry.report, entry.compress, entry.dictionary_id);
 }
 
 //---------------------------------------------------------------------------
-void Core::register_report_mediainfo_xml_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* curMI)
+void Core::add_report_mediainfo_xml_to_save(MediaInfoNameSpace::MediaInfo* curMI, std::vector<DatabaseReportEntry>& entries)
 {
     curMI->Option(__T("Details"), __T("0"));
     curMI->Option(__T("Inform"), __T("MIXML"));
-    std::string report = Ztring(curMI->Inform()).To_UTF8();
-    MediaConchLib::compression mode = compression_mode;
-    compress_report(report, mode);
 
-    std::string err;
-    db_mutex.Enter();
-    get_db()->save_report(user, file, MediaConchLib::report_MediaInfo, MediaConchLib::format_Xml,
-                          "", report, mode, true, err);
-    db_mutex.Leave();
+    entries.push_back(DatabaseReportEntry());
+    DatabaseReportEntry& entry = entries.back();
+    entry.report_kind = MediaConchLib::report_MediaInfo;
+    entry.format = MediaConchLib::format_Xml;
+    entry.report = Ztring(curMI->Inform()).To_UTF8();
+    entry.uncompressed_size = entry.report.size();
+    entry.compress = get_compression_mode(MediaConchLib::report_MediaInfo);
+    entry.mil_version = true;
+    compressor.compress(entry.report, entry.compress, entry.dictionary_id);
 }
 
 //---------------------------------------------------------------------------
-void Core::register_report_micromediatrace_xml_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* curMI)
+void Core::add_report_micromediatrace_xml_to_save(MediaInfoNameSpace::MediaInfo* curMI, std::vector<DatabaseReportEntry>& entries)
 {
     curMI->Option(__T("Details"), __T("1"));
     curMI->Option(__T("Inform"), __T("MICRO_XML"));
 
+    entries.push_back(DatabaseReportEntry());
+    DatabaseReportEntry& entry = entries.back();
+    entry.report_kind = MediaConchLib::report_MicroMediaTrace;
+    entry.format = MediaConchLib::format_Xml;
+    entry.compress = get_compression_mode(MediaConchLib::report_MicroMediaTrace);
+    entry.mil_version = true;
+
     //Trying with direct access to the string from MediaInfoLib, then use the classic method if it failed 
-    std::string report;
-    MediaConchLib::compression mode = compression_mode;
     ZenLib::Ztring Temp = curMI->Option(__T("File_Details_StringPointer"), ZenLib::Ztring());
     if (Temp.find_first_not_of(__T("0123456789:")) == std::string::npos) //Form is "Pointer:Size"
     {
@@ -849,20 +1079,117 @@ void Core::register_report_micromediatrace_xml_to_database(int user, long file,
         {
             const char* report_buffer = (const char*)TempZL[0].To_int64u();
             size_t report_size = (size_t)TempZL[1].To_int64u();
-            compress_report_copy(report, report_buffer, report_size, mode);
+            entry.uncompressed_size = report_size;
+            compressor.compress_copy(entry.report, report_buffer, report_size, entry.compress, entry.dictionary_id);
         }
     }
-    if (report.empty())
+    if (entry.report.empty())
     {
-        std::string report = Ztring(curMI->Inform()).To_UTF8();
-        compress_report(report, mode);
+        entry.compress = get_compression_mode(MediaConchLib::report_MicroMediaTrace);
+        entry.report = Ztring(curMI->Inform()).To_UTF8();
+        entry.uncompressed_size = entry.report.size();
+        compressor.compress(entry.report, entry.compress, entry.dictionary_id);
     }
+}
 
+//---------------------------------------------------------------------------
+int Core::save_reports_to_database(int user, long file, const std::vector<DatabaseReportEntry>& entries)
+{
     std::string err;
     db_mutex.Enter();
-    get_db()->save_report(user, file, MediaConchLib::report_MicroMediaTrace, MediaConchLib::format_Xml,
-                          "", report, mode, true, err);
+    if (database_batch_files > 1 && !database_batch_opened)
+    {
+        bool opened = get_db()->begin_batch(err) == 0;
+        db_readers_mutex.Enter();
+        database_batch_opened = opened;
+        db_readers_mutex.Leave();
+    }
+
+    // Reports and analyzed flag are written in one transaction
+    int ret = get_db()->save_reports(user, file, entries, true, err);
+    std::string error_log;
+    if (ret < 0)
+    {
+        // The file is finished with the error, else its status is never finished
+        error_log = "The reports cannot be saved in the database: " + err;
+        std::string tmp;
+        get_db()->update_file_error(user, file, tmp, true, error_log);
+        get_db()->update_file_analyzed(user, file, tmp, true);
+    }
+
+    std::vector<std::pair<int, long> > batch_failed;
+    std::string batch_err;
+    if (database_batch_opened)
+    {
+        database_batch_saved.push_back(std::make_pair(user, file));
+        if (++database_batch_pending >= database_batch_files)
+            commit_database_batch(batch_failed, batch_err);
+    }
     db_mutex.Leave();
+
+    if (ret < 0)
+        plugin_add_log(PluginLog::LOG_LEVEL_ERROR, error_log);
+    reports.reports_changed(user, file);
+    database_batch_failed(batch_failed, batch_err);
+
+    for (size_t i = 0; ret >= 0 && i < batch_failed.size(); ++i)
+        if (batch_failed[i].first == user && batch_failed[i].second == file)
+            ret = -1;
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+void Core::commit_database_batch(std::vector<std::pair<int, long> >& failed, std::string& err)
+{
+    // Must be called with db_mutex locked
+    if (get_db()->commit_batch(err) < 0)
+    {
+        std::string tmp;
+        get_db()->rollback_batch(tmp);
+
+        // Nothing of the batch is saved, each file is finished with the error, else its status is never finished
+        err = "The reports cannot be saved in the database: " + err;
+        for (size_t i = 0; i < database_batch_saved.size(); ++i)
+        {
+            int user = database_batch_saved[i].first;
+            long file = database_batch_saved[i].second;
+            get_db()->update_file_error(user, file, tmp, true, err);
+            get_db()->update_file_analyzed(user, file, tmp, true);
+        }
+        failed.swap(database_batch_saved);
+    }
+    database_batch_saved.clear();
+    db_readers_mutex.Enter();
+    database_batch_opened = false;
+    db_readers_mutex.Leave();
+    database_batch_pending = 0;
+}
+
+//---------------------------------------------------------------------------
+void Core::database_batch_failed(const std::vector<std::pair<int, long> >& failed, const std::string& err)
+{
+    // Called without db_mutex locked
+    for (size_t i = 0; i < failed.size(); ++i)
+    {
+        std::stringstream log;
+        log << "File " << failed[i].second << ": " << err;
+        plugin_add_log(PluginLog::LOG_LEVEL_ERROR, log.str());
+        reports.reports_changed(failed[i].first, failed[i].second);
+    }
+}
+
+//---------------------------------------------------------------------------
+void Core::flush_database_batch()
+{
+    std::vector<std::pair<int, long> > failed;
+    std::string err;
+
+    db_mutex.Enter();
+    if (database_batch_opened)
+        commit_database_batch(failed, err);
+    db_mutex.Leave();
+
+    database_batch_failed(failed, err);
 }
 
 //---------------------------------------------------------------------------
@@ -877,47 +1204,64 @@ void Core::set_file_analyzed_to_database(int user, long id)
 //---------------------------------------------------------------------------
 void Core::register_reports_to_database(int user, long file, const std::string& report,
                                         MediaConchLib::report report_kind, const std::string& options,
-                                        MediaInfoNameSpace::MediaInfo* curMI)
+                                        MediaInfoNameSpace::MediaInfo* curMI, bool with_trace)
 {
+    std::vector<DatabaseReportEntry> entries;
+
     // Implementation
-    register_report_xml_to_database(user, file, report, report_kind, options);
+    add_report_xml_to_save(report, report_kind, options, entries);
 
     //MI and MT
-    register_reports_to_database(user, file, curMI);
+    add_report_mediainfo_text_to_save(curMI, entries);
+    add_report_mediainfo_xml_to_save(curMI, entries);
+    if (with_trace)
+        add_report_micromediatrace_xml_to_save(curMI, entries);
+
+    save_reports_to_database(user, file, entries);
 }
 
 //---------------------------------------------------------------------------
-void Core::register_reports_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* curMI)
+void Core::register_reports_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* curMI, bool with_trace)
 {
+    std::vector<DatabaseReportEntry> entries;
+
     // MediaInfo
-    register_report_mediainfo_text_to_database(user, file, curMI);
-    register_report_mediainfo_xml_to_database(user, file, curMI);
+    add_report_mediainfo_text_to_save(curMI, entries);
+    add_report_mediainfo_xml_to_save(curMI, entries);
 
-    // MicroMediaTrace
-    register_report_micromediatrace_xml_to_database(user, file, curMI);
+    // MicroMediaTrace, created later when it is parsed without the details
+    if (with_trace)
+        add_report_micromediatrace_xml_to_save(curMI, entries);
+
+    save_reports_to_database(user, file, entries);
 }
 
 //---------------------------------------------------------------------------
-void Core::register_reports_to_database(int user, long file)
+void Core::register_trace_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* curMI)
 {
-    // MediaInfo
-    register_report_mediainfo_text_to_database(user, file, MI);
-    register_report_mediainfo_xml_to_database(user, file, MI);
+    std::vector<DatabaseReportEntry> entries;
+    add_report_micromediatrace_xml_to_save(curMI, entries);
+    save_reports_to_database(user, file, entries);
+}
 
-    // MicroMediaTrace
-    register_report_micromediatrace_xml_to_database(user, file, MI);
+//---------------------------------------------------------------------------
+void Core::register_reports_to_database(int user, long file)
+{
+    register_reports_to_database(user, file, MI);
 }
 
 //---------------------------------------------------------------------------
 int Core::register_mediaconch_to_database(int user, long file, const std::string& options,
                                           std::string& report, std::string& err)
 {
-    MediaConchLib::compression mode = compression_mode;
-    compress_report(report, mode);
+    MediaConchLib::compression mode = get_compression_mode(MediaConchLib::report_MediaConch);
+    size_t uncompressed_size = report.size();
+    int dictionary_id = 0;
+    compressor.compress(report, mode, dictionary_id);
 
     db_mutex.Enter();
     int ret = get_db()->save_report(user, file, MediaConchLib::report_MediaConch, MediaConchLib::format_Xml,
-                                    options, report, mode, 0, err);
+                                    options, report, mode, uncompressed_size, 0, dictionary_id, err);
     db_mutex.Leave();
     return ret;
 }
@@ -986,23 +1330,161 @@ int Core::get_report_saved(int user, const std::vector<long>& files,
         return -1;
     }
 
+    if (reportKind == MediaConchLib::report_MicroMediaTrace && checker_create_mediatrace(user, files, err) < 0)
+        return -1;
+
     for (size_t i = 0; i < files.size(); ++i)
     {
         std::string raw;
         MediaConchLib::compression compress = MediaConchLib::compression_None;
+        size_t uncompressed_size = 0;
+        int dictionary_id = -1;
 
-        db_mutex.Enter();
-        if (get_db()->get_report(user, files[i], reportKind, f, options, raw, compress, err) < 0)
+        DatabaseReport* reader = get_db_reader();
+        if (reader->get_report(user, files[i], reportKind, f, options, raw, compress, uncompressed_size,
+                               dictionary_id, err) < 0)
         {
-            db_mutex.Leave();
+            release_db_reader(reader);
             return -1;
         }
 
+        release_db_reader(reader);
+        if (compressor.uncompress(raw, compress, uncompressed_size, dictionary_id) < 0)
+        {
+            err = "The report saved cannot be uncompressed.";
+            return -1;
+        }
+        if (report.empty())
+            report.swap(raw);
+        else
+            report += raw;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+bool Core::reuse_analysis_of_same_content(int user, const std::string& file, long id, bool lookup)
+{
+    // The file is parsed anyway, its fingerprint is not computed
+    if (!lookup)
+        return false;
+
+    FileFingerprint::Mode mode = FileFingerprint::mode_from_string(get_analysis_fingerprint_mode());
+    if (mode == FileFingerprint::MODE_NONE)
+        return false;
+
+    // The file is analyzed if its fingerprint cannot be computed
+    std::string fingerprint;
+    std::string err;
+    if (FileFingerprint::compute(file, mode, fingerprint, err) < 0)
+        return false;
+
+    bool reused = false;
+    db_mutex.Enter();
+    get_db()->update_file_fingerprint(user, id, fingerprint, err);
+    if (FileFingerprint::is_full(fingerprint))
+        get_db()->update_file_full_fingerprint(user, id, fingerprint, err);
+    db_mutex.Leave();
+
+    // Options as registered with the file
+    std::string filename;
+    std::string time;
+    std::string options;
+    int src_user = -1;
+    long src_id = -1;
+    if (get_file_name_time_options_from_id(user, id, filename, time, options) == 0)
+    {
+        db_mutex.Enter();
+        src_id = get_db()->get_file_id_from_fingerprint(fingerprint, options, id, src_user, err);
         db_mutex.Leave();
-        uncompress_report(raw, compress);
-        report += raw;
     }
 
+    // A sampled fingerprint only gives a candidate
+    if (src_id >= 0 && !FileFingerprint::is_full(fingerprint) && !same_content_is_confirmed(user, id, src_user, src_id))
+        return false;
+
+    db_mutex.Enter();
+    if (src_id >= 0 && get_db()->begin_batch(err) == 0)
+    {
+        reused = get_db()->copy_reports(src_user, src_id, user, id, err) == 0 &&
+                 get_db()->update_file_analyzed(user, id, err, true) == 0;
+
+        std::string tmp;
+        if (reused)
+            reused = get_db()->commit_batch(err) == 0;
+        else
+            get_db()->rollback_batch(tmp);
+    }
+
+    if (reused)
+        reports.reports_changed(user, id);
+    db_mutex.Leave();
+
+    return reused;
+}
+
+//---------------------------------------------------------------------------
+int Core::get_file_name_time_options_from_id(int user, long id, std::string& file, std::string& time,
+                                             std::string& options)
+{
+    std::vector<long> generated_id;
+    long source_id;
+    size_t generated_time;
+    std::string generated_log;
+    std::string generated_error_log;
+    bool analyzed;
+    bool has_error;
+    std::string error_log;
+    std::string err;
+
+    db_mutex.Enter();
+    int ret = get_db()->get_file_information_from_id(user, id, file, time, generated_id, source_id,
+                                                     generated_time, generated_log, generated_error_log, options,
+                                                     analyzed, has_error, error_log, err);
+    db_mutex.Leave();
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+bool Core::same_content_is_confirmed(int user, long id, int src_user, long src_id)
+{
+    std::string src_fingerprint;
+    std::string fingerprint;
+    if (get_full_fingerprint(src_user, src_id, src_fingerprint) < 0 || get_full_fingerprint(user, id, fingerprint) < 0)
+        return false;
+
+    return src_fingerprint == fingerprint;
+}
+
+//---------------------------------------------------------------------------
+int Core::get_full_fingerprint(int user, long id, std::string& fingerprint)
+{
+    std::string err;
+    db_mutex.Enter();
+    int ret = get_db()->get_file_full_fingerprint(user, id, fingerprint, err);
+    db_mutex.Leave();
+    if (ret < 0)
+        return -1;
+    if (fingerprint.size())
+        return 0;
+
+    // The file must be the one of the reports
+    std::string file;
+    std::string time;
+    std::string options;
+    if (get_file_name_time_options_from_id(user, id, file, time, options) < 0 || !file_is_existing(file) ||
+        get_last_modification_file(file) != time)
+        return -1;
+
+    // Read entirely once, outside of the database lock
+    if (FileFingerprint::compute(file, FileFingerprint::MODE_FULL, fingerprint, err) < 0)
+        return -1;
+
+    db_mutex.Enter();
+    get_db()->update_file_full_fingerprint(user, id, fingerprint, err);
+    db_mutex.Leave();
     return 0;
 }
 
@@ -1017,18 +1499,18 @@ long Core::file_is_registered_and_analyzed_in_db(int user, const std::string& fi
     if (is_existing)
         time = get_last_modification_file(filename);
 
-    db_mutex.Enter();
+    DatabaseReport* reader = get_db_reader();
 
-    long id = get_db()->get_file_id(user, filename, time, options, err);
+    long id = reader->get_file_id(user, filename, time, options, err);
     if (id < 0)
     {
         analyzed = false;
-        db_mutex.Leave();
+        release_db_reader(reader);
         return id;
     }
 
-    analyzed = get_db()->file_is_analyzed(user, id, err);
-    db_mutex.Leave();
+    analyzed = reader->file_is_analyzed(user, id, err);
+    release_db_reader(reader);
 
     if (!is_existing && !analyzed)
         return -1;
@@ -1064,10 +1546,10 @@ long Core::file_is_registered_and_analyzed(int user, const std::string& filename
 //---------------------------------------------------------------------------
 int Core::implem_report_is_registered(int user, long file, const std::string& options, bool& registered, std::string& err)
 {
-    db_mutex.Enter();
-    int ret = get_db()->report_is_registered(user, file, MediaConchLib::report_MediaConch,
-                                             MediaConchLib::format_Xml, options, registered, err);
-    db_mutex.Leave();
+    DatabaseReport* reader = get_db_reader();
+    int ret = reader->report_is_registered(user, file, MediaConchLib::report_MediaConch,
+                                           MediaConchLib::format_Xml, options, registered, err);
+    release_db_reader(reader);
     return ret;
 }
 
@@ -1493,6 +1975,48 @@ bool Core::database_is_enabled() const
     return enabled;
 }
 
+//---------------------------------------------------------------------------
+bool Core::policy_native_evaluation_is_enabled() const
+{
+    if (!config)
+        return true;
+    bool enabled = true;
+    if (config->get("Policy_Native_Evaluation", enabled))
+        return true;
+    return enabled;
+}
+
+//---------------------------------------------------------------------------
+bool Core::watch_folder_events_is_enabled() const
+{
+    if (!config)
+        return true;
+    bool enabled = true;
+    if (config->get("Watch_Folder_Events", enabled))
+        return true;
+    return enabled;
+}
+
+//---------------------------------------------------------------------------
+std::string Core::get_analysis_fingerprint_mode() const
+{
+    std::string mode;
+    if (config)
+        config->get("Analysis_Fingerprint", mode);
+    return mode;
+}
+
+//---------------------------------------------------------------------------
+bool Core::mediatrace_on_demand_is_enabled() const
+{
+    if (!config)
+        return false;
+    bool enabled = false;
+    if (config->get("MediaTrace_On_Demand", enabled))
+        return false;
+    return enabled;
+}
+
 //---------------------------------------------------------------------------
 DatabaseReport *Core::get_db()
 {
@@ -1502,18 +2026,77 @@ DatabaseReport *Core::get_db()
 }
 
 //---------------------------------------------------------------------------
-void Core::WaitRunIsFinished()
+void Core::open_database_readers()
+{
+    if (!db_readers_max)
+        return;
+
+    // Check once that the database can be read by another connection
+    std::string err;
+    DatabaseReport* reader = db->open_reader(err);
+    if (!reader)
+    {
+        db_readers_max = 0;
+        return;
+    }
+
+    db_readers.push_back(reader);
+}
+
+//---------------------------------------------------------------------------
+DatabaseReport *Core::get_db_reader()
+{
+    DatabaseReport* writer = get_db();
+    DatabaseReport* reader = NULL;
+
+    // Reports of an opened batch are only visible from the writer connection
+    db_readers_mutex.Enter();
+    bool use_writer = !db_readers_max || database_batch_opened;
+    if (!use_writer && db_readers.size())
+    {
+        reader = db_readers.back();
+        db_readers.pop_back();
+    }
+    db_readers_mutex.Leave();
+
+    if (!use_writer && !reader)
+    {
+        std::string err;
+        reader = writer->open_reader(err);
+    }
+
+    if (reader)
+        return reader;
+
+    db_mutex.Enter();
+    return writer;
+}
+
+//---------------------------------------------------------------------------
+void Core::release_db_reader(DatabaseReport* reader)
 {
-    while (1)
+    if (reader == db)
     {
-        if (scheduler->is_finished())
-            break;
-        #ifdef WINDOWS
-        ::Sleep((DWORD)50);
-        #else
-        usleep(50000);
-        #endif
+        db_mutex.Leave();
+        return;
     }
+
+    // Connections opened above the maximum are closed
+    db_readers_mutex.Enter();
+    if (db_readers.size() < db_readers_max)
+    {
+        db_readers.push_back(reader);
+        reader = NULL;
+    }
+    db_readers_mutex.Leave();
+
+    delete reader;
+}
+
+//---------------------------------------------------------------------------
+void Core::WaitRunIsFinished()
+{
+    scheduler->wait_all_finished();
 }
 
 //---------------------------------------------------------------------------
@@ -1534,6 +2117,32 @@ void Core::get_daemon_address(std::string& addr, int& port) const
         port = (int)port_l;
 }
 
+//---------------------------------------------------------------------------
+void Core::get_daemon_workers(size_t& workers, std::map<std::string, size_t>& limits) const
+{
+    long workers_l;
+    if (!config->get("Daemon_Workers", workers_l) && workers_l >= 0)
+        workers = (size_t)workers_l;
+
+    // Per command, ex: {"checker_report": 2, "checker_validate": 4}
+    std::map<std::string, Container::Value> endpoints;
+    if (config->get("Daemon_Endpoint_Limits", endpoints))
+        return;
+
+    std::map<std::string, Container::Value>::iterator it = endpoints.begin();
+    for (; it != endpoints.end(); ++it)
+        if (it->second.type == Container::Value::CONTAINER_TYPE_INTEGER && it->second.l >= 0)
+            limits[it->first] = (size_t)it->second.l;
+}
+
+//---------------------------------------------------------------------------
+void Core::get_daemon_max_body_size(size_t& size) const
+{
+    long size_l;
+    if (!config->get("Daemon_Max_Body_Size", size_l) && size_l >= 0)
+        size = (size_t)size_l;
+}
+
 //---------------------------------------------------------------------------
 bool Core::has_outcome_fail(const std::string& report)
 {
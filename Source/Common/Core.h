@@ -26,6 +26,7 @@
 #include "Policy.h"
 #include "Configuration.h"
 #include "Scheduler.h"
+#include "Compression.h"
 
 //---------------------------------------------------------------------------
 
@@ -33,6 +34,8 @@ namespace MediaConch {
 
 class Schema;
 class DatabaseReport;
+struct DatabaseReportEntry;
+struct DatabaseWatchFolderFile;
 class WatchFoldersManager;
 class PluginsManager;
 class Plugin;
@@ -82,6 +85,13 @@ public:
     int  mediaconch_edit_watch_folder(const std::string& folder, const std::string& folder_reports,
                                         std::string& error);
     int  mediaconch_remove_watch_folder(const std::string& folder, std::string& error);
+    // Catalog of the files of a watched folder, kept in the database
+    int  watch_folder_get_user(const std::string& folder, long& user, std::string& error);
+    int  watch_folder_get_files(int user, const std::string& folder, std::vector<DatabaseWatchFolderFile>& files,
+                                std::string& error);
+    int  watch_folder_save_files(int user, const std::string& folder, const std::vector<DatabaseWatchFolderFile>& files,
+                                 const std::vector<std::string>& removed, std::string& error);
+    int  watch_folder_remove_files(int user, const std::string& folder, std::string& error);
 
     //***************************************************************************
     // Users
@@ -102,8 +112,14 @@ public:
                                 const std::string& alias="");
 
     int         checker_status(int user, long file, MediaConchLib::Checker_StatusRes& res, std::string& error);
+    int         checker_wait_finished(int user, const std::vector<long>& files, std::vector<long>& finished,
+                                      std::string& error, size_t timeout=(size_t)-1);
+    int         checker_events(int user, long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res,
+                               std::string& error);
     int         checker_clear(int user, const std::vector<long>& files, std::string& error);
     int         checker_stop(int user, const std::vector<long>& files, std::string& error);
+    // Create the MediaTrace of the files analyzed without it, wait for the end of the creation
+    int         checker_create_mediatrace(int user, const std::vector<long>& files, std::string& error);
 
     int         checker_list(int user, std::vector<std::string>& vec, std::string& error);
     int         checker_list(int user, std::vector<long>& vec, std::string& error);
@@ -111,6 +127,9 @@ public:
     long        checker_id_from_filename(int user, const std::string& filename,
                                          const std::vector<std::pair<std::string,std::string> >& options, std::string& error);
     int         checker_file_information(int user, long id, MediaConchLib::Checker_FileInfo& info, std::string& error);
+    int         checker_get_report_raw(int user, long id, MediaConchLib::report kind, bool accept_zlib,
+                                       std::string& report, MediaConchLib::compression& compress,
+                                       size_t& uncompressed_size, std::string& error);
 
     //***************************************************************************
     // Checker Helper
@@ -164,12 +183,20 @@ public:
     void               set_implementation_verbosity(const std::string& verbosity);
     const std::string& get_implementation_verbosity();
     void               set_compression_mode(MediaConchLib::compression compress);
+    MediaConchLib::compression get_compression_mode(MediaConchLib::report report_kind) const;
     int                get_ui_poll_request() const;
     int                get_ui_database_path(std::string& path) const;
     bool               is_using_daemon() const;
     void               get_daemon_address(std::string& addr, int& port) const;
+    void               get_daemon_workers(size_t& workers, std::map<std::string, size_t>& limits) const;
+    void               get_daemon_max_body_size(size_t& size) const;
     void               load_database();
+    void               get_sqlite_pragmas(std::map<std::string, std::string>& pragmas) const;
     bool               database_is_enabled() const;
+    bool               policy_native_evaluation_is_enabled() const;
+    bool               watch_folder_events_is_enabled() const;
+    bool               mediatrace_on_demand_is_enabled() const;
+    std::string        get_analysis_fingerprint_mode() const;
     bool               accepts_https();
     static void        unify_no_https(std::string& str);
 
@@ -177,16 +204,22 @@ public:
     // Report Database access
     //***************************************************************************
     void set_file_analyzed_to_database(int user, long id);
-    void register_reports_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* MI);
+    void register_reports_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* MI, bool with_trace=true);
     void register_reports_to_database(int user, long file, const std::string& report,
                                       MediaConchLib::report report_kind, const std::string& options,
-                                      MediaInfoNameSpace::MediaInfo* curMI);
+                                      MediaInfoNameSpace::MediaInfo* curMI, bool with_trace=true);
+    void register_trace_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* MI);
+    // Fingerprint of the file saved, true if the reports of a file with the same content were copied
+    // Run by the scheduler workers, the file is read, nothing is done without lookup
+    bool reuse_analysis_of_same_content(int user, const std::string& file, long id, bool lookup);
     int  register_mediaconch_to_database(int user, long file, const std::string& options,
                                          std::string& report, std::string& err);
     int  implem_report_is_registered(int user, long file, const std::string& options, bool& registered,
                                      std::string& err);
+    // Commit the reports of the files grouped in the current batch
+    void flush_database_batch();
 
-    // TODO: removed and manage waiting time otherway
+    // Block until the scheduler has no more file to analyze
     void WaitRunIsFinished();
 
     //***************************************************************************
@@ -196,20 +229,15 @@ public:
     void plugin_add_log(int level, const std::string& log);
     void plugin_add_log_timestamp(int level, const std::string& log);
 
-    //***************************************************************************
-    // Helper Zlib
-    //***************************************************************************
-    static void compress_report(std::string& report, MediaConchLib::compression& compress);
-    static void compress_report_copy(std::string& report, const char* src, size_t src_len, MediaConchLib::compression& compress);
-    static int  uncompress_report(std::string& report, MediaConchLib::compression compress);
-
-
     //***************************************************************************
     // Event Callback
     //***************************************************************************
     struct EventCallBack
     {
         void (*log)(struct MediaInfo_Event_Log_0* Event);
+        // Called by the thread finishing an analysis
+        void (*analyze_finished)(void* arg);
+        void  *analyze_finished_arg;
     };
     EventCallBack ecb;
 
@@ -218,7 +246,10 @@ private:
 
     MediaInfoNameSpace::MediaInfo     *MI;
     DatabaseReport*                    db;
-    CriticalSection                    db_mutex;
+    CriticalSection                    db_mutex;         // Connection used to write
+    std::vector<DatabaseReport*>       db_readers;       // Connections free to read in parallel
+    CriticalSection                    db_readers_mutex;
+    size_t                             db_readers_max;   // 0 to read with the writer connection
     static const std::string           database_name;
     Configuration*                     config;
     std::string                        configuration_file;
@@ -228,6 +259,12 @@ private:
     PluginsManager                    *plugins_manager;
     WatchFoldersManager                *watch_folders_manager;
     MediaConchLib::compression         compression_mode;
+    MediaConchLib::compression         report_compression_modes[MediaConchLib::report_Max]; // compression_Max to use the default one
+    Compression                        compressor;
+    size_t                             database_batch_files; // Files saved in one transaction
+    size_t                             database_batch_pending;
+    bool                               database_batch_opened;
+    std::vector<std::pair<int, long> > database_batch_saved; // Files of the opened batch, by user and id
 
     bool has_outcome_fail(const std::string& report);
 
@@ -241,17 +278,32 @@ private:
     long   file_is_registered_in_queue(int user, const std::string& file, const std::string& options, std::string& err);
     std::string get_last_modification_file(const std::string& file);
     bool   file_is_existing(const std::string& filename);
+    int    get_file_name_time_options_from_id(int user, long id, std::string& file, std::string& time,
+                                              std::string& options);
+    // With a sampled fingerprint, the full fingerprints of both files are compared
+    bool   same_content_is_confirmed(int user, long id, int src_user, long src_id);
+    // Computed once and saved, the file must be unchanged since its registration
+    int    get_full_fingerprint(int user, long id, std::string& fingerprint);
+    void   load_compression_configuration();
 
     void register_reports_to_database(int user, long file);
-    void register_report_xml_to_database(int user, long file, const std::string& report,
-                                         MediaConchLib::report report_kind, const std::string& options);
-    void register_report_mediainfo_text_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* MI);
-    void register_report_mediainfo_xml_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* MI);
-    void register_report_micromediatrace_xml_to_database(int user, long file, MediaInfoNameSpace::MediaInfo* MI);
+    void add_report_xml_to_save(const std::string& report, MediaConchLib::report report_kind,
+                                const std::string& options, std::vector<DatabaseReportEntry>& entries);
+    void add_report_mediainfo_text_to_save(MediaInfoNameSpace::MediaInfo* MI, std::vector<DatabaseReportEntry>& entries);
+    void add_report_mediainfo_xml_to_save(MediaInfoNameSpace::MediaInfo* MI, std::vector<DatabaseReportEntry>& entries);
+    void add_report_micromediatrace_xml_to_save(MediaInfoNameSpace::MediaInfo* MI, std::vector<DatabaseReportEntry>& entries);
+    int  save_reports_to_database(int user, long file, const std::vector<DatabaseReportEntry>& entries);
+    // When the commit fails, the files of the batch are finished with the error and given in failed
+    void commit_database_batch(std::vector<std::pair<int, long> >& failed, std::string& err);
+    void database_batch_failed(const std::vector<std::pair<int, long> >& failed, const std::string& err);
 
     std::string get_config_file();
     std::string get_database_path();
     DatabaseReport *get_db();
+    // Locked connection to read, released with release_db_reader()
+    DatabaseReport *get_db_reader();
+    void            release_db_reader(DatabaseReport* reader);
+    void            open_database_readers();
     static bool sort_pair_options(const std::pair<std::string,std::string>& a, const std::pair<std::string,std::string>& b);
 };
 
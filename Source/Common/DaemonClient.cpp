@@ -17,6 +17,7 @@
 #include "Http.h"
 #include "LibEventHttp.h"
 #include "REST_API.h"
+#include <sstream>
 #ifdef _WIN32
 #include <ZenLib/Ztring.h>
 #include <Winsock2.h>
@@ -114,6 +115,28 @@ bool DaemonClient::is_init(std::string& err)
 // MediaConch
 //***************************************************************************
 
+//---------------------------------------------------------------------------
+int DaemonClient::wait_results(std::vector<std::string>& results, std::string& err)
+{
+    if (http_client->wait_requests(results, err) < 0)
+    {
+        if (http_client->get_http_code() == 0)
+            err = "Cannot connect to the daemon.";
+        return -1;
+    }
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        if (!results[i].length())
+        {
+            err = "HTTP answer is empty.";
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 #define COMMON_HTTP_REQ_RES(NAME, RES_ERR)                                                        \
     if (!is_init(err))                                                                            \
@@ -144,6 +167,77 @@ bool DaemonClient::is_init(std::string& err)
     if (!res)                                                                                     \
         return RES_ERR;                                                                           \
 
+//---------------------------------------------------------------------------
+// Files or ids sent in one request
+static const size_t checker_batch_size = 500;
+
+//---------------------------------------------------------------------------
+static std::string get_real_file(const std::string& file)
+{
+    std::string real_file(file);
+#ifdef _WIN32
+    ZenLib::Ztring path = ZenLib::Ztring().From_UTF8(real_file);
+
+    DWORD path_size = GetFullPathName(path.c_str(), 0, NULL, NULL);
+    ZenLib::Char* tmp = new ZenLib::Char[path_size + 1];
+    if (GetFullPathName(path.c_str(), path_size + 1, tmp, NULL))
+    {
+        path = ZenLib::Ztring(tmp);
+        real_file = path.To_UTF8();
+    }
+    delete [] tmp;
+#else
+    char *path = realpath(file.c_str(), NULL);
+    if (path)
+    {
+        real_file = std::string(path);
+        free(path);
+    }
+#endif //_WIN32
+    return real_file;
+}
+
+//---------------------------------------------------------------------------
+static void status_from_ok(const RESTAPI::Checker_Status_Ok *ok, MediaConchLib::Checker_StatusRes& st_res)
+{
+    st_res.finished = ok->finished;
+
+    if (ok->finished && ok->tool)
+    {
+        st_res.tool = new int;
+        if (*ok->tool == RESTAPI::VERAPDF)
+            *st_res.tool = (int)MediaConchLib::report_MediaVeraPdf;
+        else if (*ok->tool == RESTAPI::DPFMANAGER)
+            *st_res.tool = (int)MediaConchLib::report_MediaDpfManager;
+        else
+            *st_res.tool = (int)MediaConchLib::report_MediaConch;
+    }
+
+    if (ok->generated_id.size())
+    {
+        for (size_t i = 0; i < ok->generated_id.size(); ++i)
+            st_res.generated_id.push_back(ok->generated_id[i]);
+    }
+
+    if (ok->source_id >= 0)
+        st_res.source_id = ok->source_id;
+
+    if (ok->has_error)
+    {
+        st_res.has_error = true;
+        st_res.error_log = ok->error_log;
+    }
+
+    if (!ok->finished)
+    {
+        st_res.percent = new double;
+        if(ok->percent)
+            *st_res.percent = *ok->percent;
+        else
+            *st_res.percent = 0.0;
+    }
+}
+
 //***************************************************************************
 // MediaConch
 //***************************************************************************
@@ -396,6 +490,37 @@ int DaemonClient::checker_list_mediainfo_outputs(std::string& outputs, std::stri
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int DaemonClient::checker_events(int user, long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& events,
+                                 std::string& err)
+{
+    RESTAPI::Checker_Events_Req  req;
+    RESTAPI::Checker_Events_Res *res = NULL;
+
+    req.user = user;
+    req.last_event = last_event;
+    req.timeout = timeout;
+
+    COMMON_HTTP_REQ_RES(checker_events, -1)
+
+    int ret = -1;
+    if (res->nok)
+        err = res->nok->error;
+    else
+    {
+        events.last_event = res->last_event;
+        events.events_lost = res->events_lost;
+        events.finished = res->finished;
+        events.progress.clear();
+        for (size_t i = 0; i < res->progress.size(); ++i)
+            events.progress.push_back(std::make_pair(res->progress[i].id, res->progress[i].percent));
+        ret = 0;
+    }
+
+    delete res;
+    return ret;
+}
+
 //---------------------------------------------------------------------------
 int DaemonClient::default_values_for_type(const std::string& type, std::vector<std::string>& values, std::string& err)
 {
@@ -420,140 +545,214 @@ int DaemonClient::checker_analyze(int user, const std::string& file, const std::
                                   const std::vector<std::pair<std::string,std::string> >& options,
                                   bool& registered, bool force_analyze, bool mil_analyze, long& file_id, std::string& err)
 {
-    RESTAPI::Checker_Analyze_Req  req;
-    RESTAPI::Checker_Analyze_Arg  arg;
-    RESTAPI::Checker_Analyze_Res *res = NULL;
-
-    arg.user = user;
-    arg.id = 0;
-    arg.mil_analyze = mil_analyze;
+    std::vector<std::string> files(1, file);
+    std::vector<long> files_id;
+    std::vector<bool> files_registered;
+    std::vector<std::string> files_error;
+    if (checker_analyze(user, files, plugins, options, force_analyze, mil_analyze, files_id, files_registered,
+                        files_error, err) < 0)
+        return -1;
 
-    for (size_t i = 0; i < plugins.size(); ++i)
-        arg.plugins.push_back(plugins[i]);
+    if (files_id[0] < 0)
+    {
+        err = files_error[0];
+        return -1;
+    }
 
-    for (size_t i = 0; i < options.size(); ++i)
-        arg.options.push_back(std::make_pair(options[i].first, options[i].second));
+    registered = files_registered[0];
+    file_id = files_id[0];
+    return 0;
+}
 
-    std::string real_file(file);
-#ifdef _WIN32
-    ZenLib::Ztring path = ZenLib::Ztring().From_UTF8(real_file);
+//---------------------------------------------------------------------------
+int DaemonClient::checker_analyze(int user, const std::vector<std::string>& files, const std::vector<std::string>& plugins,
+                                  const std::vector<std::pair<std::string,std::string> >& options,
+                                  bool force_analyze, bool mil_analyze, std::vector<long>& files_id,
+                                  std::vector<bool>& registered, std::vector<std::string>& files_error,
+                                  std::string& err)
+{
+    if (!is_init(err) || http_client->start(err) < 0)
+        return -1;
 
-    DWORD path_size = GetFullPathName(path.c_str(), 0, NULL, NULL);
-    ZenLib::Char* tmp = new ZenLib::Char[path_size + 1];
-    if (GetFullPathName(path.c_str(), path_size + 1, tmp, NULL))
-    {
-        path = ZenLib::Ztring(tmp);
-        real_file = path.To_UTF8();
-    }
-    delete [] tmp;
-#else
-    char *path = realpath(file.c_str(), NULL);
-    if (path)
+    // All the batches are in flight at the same time
+    http_client->begin_requests();
+    for (size_t start = 0; start < files.size(); start += checker_batch_size)
     {
-        real_file = std::string(path);
-        free(path);
-    }
-#endif //_WIN32
+        RESTAPI::Checker_Analyze_Req req;
 
-    arg.file = real_file;
-    if (force_analyze)
-    {
-        arg.has_force_analyze = true;
-        arg.force_analyze = force_analyze;
-    }
-    req.args.push_back(arg);
+        size_t end = start + checker_batch_size;
+        if (end > files.size())
+            end = files.size();
 
-    COMMON_HTTP_REQ_RES(checker_analyze, -1)
+        for (size_t i = start; i < end; ++i)
+        {
+            RESTAPI::Checker_Analyze_Arg arg;
+            arg.user = user;
+            arg.id = i;
+            arg.mil_analyze = mil_analyze;
 
-    if (res->nok.size() != 0)
-    {
-        if (res->nok[0])
-            err = res->nok[0]->error;
-        else
-            err = "Internal error during analyze.";
-        delete res;
-        return -1;
+            for (size_t j = 0; j < plugins.size(); ++j)
+                arg.plugins.push_back(plugins[j]);
+
+            for (size_t j = 0; j < options.size(); ++j)
+                arg.options.push_back(std::make_pair(options[j].first, options[j].second));
+
+            arg.file = get_real_file(files[i]);
+            if (force_analyze)
+            {
+                arg.has_force_analyze = true;
+                arg.force_analyze = force_analyze;
+            }
+            req.args.push_back(arg);
+        }
+
+        if (http_client->send_request(req, err) < 0)
+        {
+            http_client->stop();
+            return -1;
+        }
     }
-    else if (res->ok.size() != 1)
+
+    std::vector<std::string> results;
+    if (wait_results(results, err) < 0)
+        return -1;
+
+    size_t first = files_id.size();
+    files_id.resize(first + files.size(), -1);
+    registered.resize(first + files.size(), false);
+    files_error.resize(first + files.size());
+
+    for (size_t batch = 0; batch < results.size(); ++batch)
     {
-        err = "Internal error during analyze.";
+        size_t start = batch * checker_batch_size;
+        size_t end = start + checker_batch_size;
+        if (end > files.size())
+            end = files.size();
+
+        RESTAPI rest;
+        RESTAPI::Checker_Analyze_Res *res = rest.parse_checker_analyze_res(results[batch], err);
+        if (!res)
+            return -1;
+
+        // A file not registered keeps the id -1 with its own error
+        for (size_t i = 0; i < res->nok.size(); ++i)
+        {
+            if (!res->nok[i] || !res->nok[i]->id)
+                continue;
+
+            long in_id = *res->nok[i]->id;
+            if (in_id < (long)start || in_id >= (long)end)
+                continue;
+
+            files_error[first + in_id] = res->nok[i]->error;
+        }
+
+        for (size_t i = 0; i < res->ok.size(); ++i)
+        {
+            long in_id = res->ok[i]->inId;
+            if (in_id < (long)start || in_id >= (long)end)
+                continue;
+
+            registered[first + in_id] = !res->ok[i]->create;
+            files_id[first + in_id] = res->ok[i]->outId;
+        }
         delete res;
-        return -1;
     }
 
-    registered = !res->ok[0]->create;
+    for (size_t i = first; i < files_id.size(); ++i)
+        if (files_id[i] < 0 && files_error[i].empty())
+            files_error[i] = "Internal error during analyze.";
 
-    file_id = res->ok[0]->outId;
-    delete res;
     return 0;
 }
 
 //---------------------------------------------------------------------------
 int DaemonClient::checker_status(int user, long file_id, MediaConchLib::Checker_StatusRes& st_res, std::string& err)
 {
-    RESTAPI::Checker_Status_Req  req;
-    RESTAPI::Checker_Status_Res *res = NULL;
-    req.user = user;
-    req.ids.push_back(file_id);
+    std::vector<long> files_id(1, file_id);
+    std::vector<MediaConchLib::Checker_StatusRes> res;
+    if (checker_status(user, files_id, res, err) < 0)
+        return -1;
 
-    COMMON_HTTP_REQ_RES(checker_status, -1)
+    st_res = res[0];
+    return 0;
+}
 
-    if (res->nok.size() != 0)
-    {
-        if (res->nok[0])
-            err = res->nok[0]->error;
-        else
-            err = "Internal error during analyze.";
-        delete res;
-        return -1;
-    }
-    else if (res->ok.size() != 1)
-    {
-        err = "Internal error during analyze.";
-        delete res;
+//---------------------------------------------------------------------------
+int DaemonClient::checker_status(int user, const std::vector<long>& files_id,
+                                 std::vector<MediaConchLib::Checker_StatusRes>& st_res, std::string& err)
+{
+    if (!is_init(err) || http_client->start(err) < 0)
         return -1;
-    }
 
-    RESTAPI::Checker_Status_Ok *ok = res->ok[0];
+    // All the batches are in flight at the same time
+    http_client->begin_requests();
+    for (size_t start = 0; start < files_id.size(); start += checker_batch_size)
+    {
+        RESTAPI::Checker_Status_Req req;
+        req.user = user;
 
-    st_res.finished = ok->finished;
+        size_t end = start + checker_batch_size;
+        if (end > files_id.size())
+            end = files_id.size();
 
-    if (ok->finished && ok->tool)
-    {
-        st_res.tool = new int;
-        if (*ok->tool == RESTAPI::VERAPDF)
-            *st_res.tool = (int)MediaConchLib::report_MediaVeraPdf;
-        else if (*ok->tool == RESTAPI::DPFMANAGER)
-            *st_res.tool = (int)MediaConchLib::report_MediaDpfManager;
-        else
-            *st_res.tool = (int)MediaConchLib::report_MediaConch;
-    }
+        for (size_t i = start; i < end; ++i)
+            req.ids.push_back(files_id[i]);
 
-    if (ok->generated_id.size())
-    {
-        for (size_t i = 0; i < ok->generated_id.size(); ++i)
-            st_res.generated_id.push_back(ok->generated_id[i]);
+        if (http_client->send_request(req, err) < 0)
+        {
+            http_client->stop();
+            return -1;
+        }
     }
 
-    if (ok->source_id >= 0)
-        st_res.source_id = ok->source_id;
+    std::vector<std::string> results;
+    if (wait_results(results, err) < 0)
+        return -1;
 
-    if (ok->has_error)
+    for (size_t batch = 0; batch < results.size(); ++batch)
     {
-        st_res.has_error = true;
-        st_res.error_log = ok->error_log;
-    }
+        size_t start = batch * checker_batch_size;
+        size_t end = start + checker_batch_size;
+        if (end > files_id.size())
+            end = files_id.size();
+
+        RESTAPI rest;
+        RESTAPI::Checker_Status_Res *res = rest.parse_checker_status_res(results[batch], err);
+        if (!res)
+            return -1;
+
+        std::map<long, RESTAPI::Checker_Status_Ok*> oks;
+        for (size_t i = 0; i < res->ok.size(); ++i)
+            if (res->ok[i])
+                oks[res->ok[i]->id] = res->ok[i];
+
+        std::map<long, std::string> noks;
+        for (size_t i = 0; i < res->nok.size(); ++i)
+            if (res->nok[i] && res->nok[i]->id)
+                noks[*res->nok[i]->id] = res->nok[i]->error;
+
+        // A file unknown by the daemon is finished with its error, the others are not blocked
+        for (size_t i = start; i < end; ++i)
+        {
+            MediaConchLib::Checker_StatusRes status;
+            status.id = files_id[i];
 
-    if (!ok->finished)
-    {
-        st_res.percent = new double;
-        if(ok->percent)
-            *st_res.percent = *ok->percent;
-        else
-            *st_res.percent = 0.0;
+            std::map<long, RESTAPI::Checker_Status_Ok*>::iterator it = oks.find(files_id[i]);
+            if (it != oks.end())
+                status_from_ok(it->second, status);
+            else
+            {
+                std::map<long, std::string>::iterator it_nok = noks.find(files_id[i]);
+                status.finished = true;
+                status.has_error = true;
+                status.error_log = it_nok != noks.end() ? it_nok->second : "File status not given by the daemon.";
+            }
+            st_res.push_back(status);
+        }
+        delete res;
     }
 
-    delete res;
     return 0;
 }
 
@@ -716,6 +915,99 @@ int DaemonClient::checker_get_report(CheckerReport& cr, MediaConchLib::Checker_R
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int DaemonClient::checker_get_report_raw(int user, long id, MediaConchLib::report kind, bool accept_compressed,
+                                         size_t offset, size_t length, MediaConchLib::Checker_ReportRawRes& result,
+                                         std::string& err)
+{
+    RESTAPI::Checker_Report_Raw_Req req;
+
+    req.user = user;
+    req.id = id;
+
+    // REPORT KIND
+    if (kind == MediaConchLib::report_MediaInfo)
+        req.report = RESTAPI::MEDIAINFO;
+    else if (kind == MediaConchLib::report_MediaTrace || kind == MediaConchLib::report_MicroMediaTrace)
+        req.report = RESTAPI::MEDIATRACE;
+    else if (kind == MediaConchLib::report_MediaVeraPdf)
+        req.report = RESTAPI::VERAPDF;
+    else if (kind == MediaConchLib::report_MediaDpfManager)
+        req.report = RESTAPI::DPFMANAGER;
+    else
+    {
+        err = "Report kind asked is not saved.";
+        return -1;
+    }
+
+    req.accept_deflate = accept_compressed;
+    if (offset || length)
+    {
+        std::stringstream range;
+        range << "bytes=" << offset << "-";
+        if (length)
+            range << offset + length - 1;
+        req.range = range.str();
+    }
+
+    if (!is_init(err))
+        return -1;
+
+    if (http_client->start(err) < 0)
+        return -1;
+
+    if (http_client->send_request(req, err) < 0)
+    {
+        if (http_client->get_http_code() == 0)
+            err = "Cannot connect to the daemon.";
+        return -1;
+    }
+
+    std::string content_type, content_encoding, content_range, size;
+    http_client->get_result_header("Content-Type", content_type);
+    http_client->get_result_header("Content-Encoding", content_encoding);
+    http_client->get_result_header("Content-Range", content_range);
+    http_client->get_result_header("X-App-MediaConch-Uncompressed-Size", size);
+    http_client->take_result(result.report);
+    http_client->stop();
+
+    // The errors are sent in JSON
+    if (content_type == "application/json")
+    {
+        RESTAPI rest;
+        RESTAPI::Checker_Report_Raw_Res *res = rest.parse_checker_report_raw_res(result.report, err);
+        result.report.clear();
+        if (!res)
+            return -1;
+
+        if (res->nok)
+            err = res->nok->error;
+        delete res;
+        return -1;
+    }
+
+    result.compress = MediaConchLib::compression_None;
+    result.uncompressed_size = result.report.size();
+    if (content_encoding == "deflate")
+    {
+        result.compress = MediaConchLib::compression_ZLib;
+        result.uncompressed_size = size.size() ? (size_t)strtoull(size.c_str(), NULL, 10) : 0;
+    }
+
+    // Content-Range: bytes first-last/total
+    result.offset = 0;
+    result.total_size = result.report.size();
+    if (content_range.find("bytes ") == 0)
+    {
+        result.offset = (size_t)strtoull(content_range.c_str() + 6, NULL, 10);
+        size_t slash = content_range.find("/");
+        if (slash != std::string::npos)
+            result.total_size = (size_t)strtoull(content_range.c_str() + slash + 1, NULL, 10);
+    }
+
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int DaemonClient::checker_validate(int user, MediaConchLib::report report,
                                    const std::vector<long>& files,
@@ -77,13 +77,23 @@ public:
     // default_values_for_type
     int default_values_for_type(const std::string& type, std::vector<std::string>& values, std::string& error);
 
-    // Analyze
+    // Analyze, the files are sent by batches
     int checker_analyze(int user, const std::string& file, const std::vector<std::string>& plugins,
                         const std::vector<std::pair<std::string,std::string> >& options,
                         bool& registered, bool force_analyze, bool mil_analyze, long& file_id, std::string& error);
+    int checker_analyze(int user, const std::vector<std::string>& files, const std::vector<std::string>& plugins,
+                        const std::vector<std::pair<std::string,std::string> >& options,
+                        bool force_analyze, bool mil_analyze, std::vector<long>& files_id,
+                        std::vector<bool>& registered, std::vector<std::string>& files_error, std::string& error);
 
-    // Status
+    // Status, the ids are sent by batches
     int checker_status(int user, long file_id, MediaConchLib::Checker_StatusRes& res, std::string& error);
+    int checker_status(int user, const std::vector<long>& files_id,
+                       std::vector<MediaConchLib::Checker_StatusRes>& res, std::string& error);
+
+    // Events, the daemon answers when a file is finished or when the timeout (in ms) expired
+    int checker_events(int user, long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res,
+                       std::string& error);
 
     // Clear
     int checker_clear(int user, const std::vector<long>& files, std::string& error);
@@ -93,6 +103,10 @@ public:
 
     // Report
     int checker_get_report(CheckerReport& c_report, MediaConchLib::Checker_ReportRes* result, std::string& error);
+    // Report saved sent as raw body, deflate is accepted when accept_compressed, a part is asked when length is not 0
+    int checker_get_report_raw(int user, long id, MediaConchLib::report kind, bool accept_compressed,
+                               size_t offset, size_t length, MediaConchLib::Checker_ReportRawRes& result,
+                               std::string& error);
     int checker_validate(int user, MediaConchLib::report report, const std::vector<long>& files,
                          const std::vector<size_t>& policies_ids,
                          const std::vector<std::string>& policies_contents,
@@ -183,6 +197,8 @@ private:
     MediaConchLib *mcl;
     Http          *http_client;
 
+    int wait_results(std::vector<std::string>& results, std::string& err);
+
     DaemonClient(const DaemonClient&);
     DaemonClient& operator=(const DaemonClient&);
 };
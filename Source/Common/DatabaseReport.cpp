@@ -49,6 +49,90 @@ void DatabaseReport::set_database_filename(const std::string& filename)
     Database::set_database_filename(filename);
 }
 
+//---------------------------------------------------------------------------
+int DatabaseReport::save_reports(int user, long file_id, const std::vector<DatabaseReportEntry>& entries,
+                                 bool analyzed, std::string& err)
+{
+    if (begin_batch(err) < 0)
+        return -1;
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const DatabaseReportEntry& e = entries[i];
+        if (save_report(user, file_id, e.report_kind, e.format, e.options, e.report, e.compress, e.uncompressed_size,
+                        e.mil_version, e.dictionary_id, err) < 0)
+        {
+            std::string tmp;
+            rollback_batch(tmp);
+            return -1;
+        }
+    }
+
+    if (analyzed && update_file_analyzed(user, file_id, err, true) < 0)
+    {
+        std::string tmp;
+        rollback_batch(tmp);
+        return -1;
+    }
+
+    return commit_batch(err);
+}
+
+//---------------------------------------------------------------------------
+int DatabaseReport::save_watch_folder_files(int user, const std::string& folder,
+                                            const std::vector<DatabaseWatchFolderFile>& files,
+                                            const std::vector<std::string>& removed, std::string& err)
+{
+    if (begin_batch(err) < 0)
+        return -1;
+
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        if (save_watch_folder_file(user, folder, files[i], err) < 0)
+        {
+            std::string tmp;
+            rollback_batch(tmp);
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < removed.size(); ++i)
+    {
+        if (remove_watch_folder_file(user, folder, removed[i], err) < 0)
+        {
+            std::string tmp;
+            rollback_batch(tmp);
+            return -1;
+        }
+    }
+
+    return commit_batch(err);
+}
+
+//---------------------------------------------------------------------------
+int DatabaseReport::begin_batch(std::string&)
+{
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int DatabaseReport::commit_batch(std::string&)
+{
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int DatabaseReport::rollback_batch(std::string&)
+{
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+DatabaseReport* DatabaseReport::open_reader(std::string&)
+{
+    return NULL;
+}
+
 //---------------------------------------------------------------------------
 void DatabaseReport::get_sql_query_for_create_report_table(std::string& q)
 {
@@ -179,6 +263,94 @@ void DatabaseReport::get_sql_query_for_update_report_table_v6(std::string& q)
     q = create.str();
 }
 
+//---------------------------------------------------------------------------
+void DatabaseReport::get_sql_query_for_update_report_table_v7(std::string& q)
+{
+    std::stringstream create;
+    // Only keep the last saved report if a report was saved twice
+    create << "DELETE FROM MEDIACONCH_REPORT WHERE rowid NOT IN";
+    create << " (SELECT MAX(rowid) FROM MEDIACONCH_REPORT GROUP BY FILE_ID, TOOL, FORMAT, OPTIONS);";
+
+    create << "CREATE UNIQUE INDEX IF NOT EXISTS MEDIACONCH_REPORT_IDENTITY";
+    create << " ON MEDIACONCH_REPORT (FILE_ID, TOOL, FORMAT, OPTIONS);";
+
+    create << "CREATE INDEX IF NOT EXISTS MEDIACONCH_FILE_LOOKUP";
+    create << " ON MEDIACONCH_FILE (FILENAME, USER, OPTIONS, FILE_LAST_MODIFICATION);";
+
+    create << "CREATE INDEX IF NOT EXISTS MEDIACONCH_FILE_USER";
+    create << " ON MEDIACONCH_FILE (USER);";
+
+    q = create.str();
+}
+
+//---------------------------------------------------------------------------
+void DatabaseReport::get_sql_query_for_update_report_table_v8(std::string& q)
+{
+    std::stringstream create;
+    // 0 if unknown (reports saved before)
+    create << "ALTER TABLE MEDIACONCH_REPORT";
+    create << " ADD UNCOMPRESSED_SIZE INT DEFAULT 0 NOT NULL;";
+
+    q = create.str();
+}
+
+//---------------------------------------------------------------------------
+void DatabaseReport::get_sql_query_for_update_report_table_v9(std::string& q)
+{
+    std::stringstream create;
+    // Catalog of the watched folders, one line by file
+    create << "CREATE TABLE IF NOT EXISTS MEDIACONCH_WATCH_FOLDER_FILE ";
+    create << "(USER INT NOT NULL,";
+    create << " FOLDER TEXT NOT NULL,";
+    create << " FILENAME TEXT NOT NULL,";
+    create << " FILE_LAST_MODIFICATION TEXT NOT NULL,";
+    create << " FILE_SIZE INT DEFAULT 0 NOT NULL,";
+    create << " STATE INT DEFAULT 0 NOT NULL,";
+    create << " FILE_ID INT DEFAULT -1 NOT NULL,";
+    create << " PRIMARY KEY (USER, FOLDER, FILENAME));";
+
+    q = create.str();
+}
+
+//---------------------------------------------------------------------------
+void DatabaseReport::get_sql_query_for_update_report_table_v10(std::string& q)
+{
+    std::stringstream create;
+    // Empty if not computed
+    create << "ALTER TABLE MEDIACONCH_FILE";
+    create << " ADD FINGERPRINT TEXT DEFAULT \"\" NOT NULL;";
+
+    create << "CREATE INDEX IF NOT EXISTS MEDIACONCH_FILE_FINGERPRINT";
+    create << " ON MEDIACONCH_FILE (FINGERPRINT, OPTIONS);";
+
+    q = create.str();
+}
+
+//---------------------------------------------------------------------------
+void DatabaseReport::get_sql_query_for_update_report_table_v11(std::string& q)
+{
+    std::stringstream create;
+    // Dictionary of the compression, 0 if none, -1 if unknown (reports saved before)
+    create << "ALTER TABLE MEDIACONCH_REPORT";
+    create << " ADD DICTIONARY_ID INT DEFAULT -1 NOT NULL;";
+
+    q = create.str();
+}
+
+//---------------------------------------------------------------------------
+void DatabaseReport::get_sql_query_for_update_report_table_v12(std::string& q)
+{
+    std::stringstream create;
+    // Empty if not computed
+    create << "ALTER TABLE MEDIACONCH_FILE";
+    create << " ADD FULL_FINGERPRINT TEXT DEFAULT \"\" NOT NULL;";
+
+    // The fingerprints are SHA-256 hashes, the ones saved before are not used
+    create << "UPDATE MEDIACONCH_FILE SET FINGERPRINT = \"\";";
+
+    q = create.str();
+}
+
 void DatabaseReport::longs_to_string(const std::vector<long>& arr, std::string& str)
 {
     std::stringstream ss;
@@ -23,6 +23,43 @@
 
 namespace MediaConch {
 
+//***************************************************************************
+// Struct DatabaseReportEntry
+//***************************************************************************
+
+// Report of a file saved with the other reports of the file
+struct DatabaseReportEntry
+{
+    DatabaseReportEntry() : report_kind(MediaConchLib::report_Max), format(MediaConchLib::format_Max),
+                            compress(MediaConchLib::compression_None), uncompressed_size(0), mil_version(0),
+                            dictionary_id(0) {}
+
+    MediaConchLib::report      report_kind;
+    MediaConchLib::format      format;
+    std::string                options;
+    std::string                report;
+    MediaConchLib::compression compress;
+    size_t                     uncompressed_size;
+    int                        mil_version;
+    int                        dictionary_id;
+};
+
+//***************************************************************************
+// Struct DatabaseWatchFolderFile
+//***************************************************************************
+
+// File of a watched folder, kept to resume the watch after a restart
+struct DatabaseWatchFolderFile
+{
+    DatabaseWatchFolderFile() : file_size(0), state(0), file_id(-1) {}
+
+    std::string                filename;
+    std::string                file_last_modification;
+    size_t                     file_size;
+    int                        state;
+    long                       file_id;
+};
+
 //***************************************************************************
 // Class Database
 //***************************************************************************
@@ -71,16 +108,28 @@ public:
     virtual int  update_file_error(int user, long id, std::string& err,
                                    bool has_error=true, const std::string& error_log="") = 0;
 
+    // Fingerprint of the content, the reports of an analyzed file with the same content and options are copied
+    virtual int  update_file_fingerprint(int user, long id, const std::string& fingerprint, std::string& err) = 0;
+    // Fingerprint of the whole file, kept when the fingerprint is sampled
+    virtual int  update_file_full_fingerprint(int user, long id, const std::string& fingerprint, std::string& err) = 0;
+    virtual int  get_file_full_fingerprint(int user, long id, std::string& fingerprint, std::string& err) = 0;
+    virtual long get_file_id_from_fingerprint(const std::string& fingerprint, const std::string& options, long exclude_id,
+                                              int& user, std::string& err) = 0;
+    virtual int  copy_reports(int src_user, long src_id, int user, long id, std::string& err) = 0;
+
     // Report
     virtual int  save_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                              const std::string& options,
-                             const std::string& report, MediaConchLib::compression,
-                             int mil_version, std::string& err) = 0;
+                             const std::string& report, MediaConchLib::compression, size_t uncompressed_size,
+                             int mil_version, int dictionary_id, std::string& err) = 0;
+    virtual int  save_reports(int user, long file_id, const std::vector<DatabaseReportEntry>& entries,
+                              bool analyzed, std::string& err);
     virtual int  remove_report(int user, long file_id, std::string& err) = 0;
     virtual int  remove_all_reports(int user, std::string& err) = 0;
     virtual int  get_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                             const std::string& options,
-                            std::string& report, MediaConchLib::compression&, std::string& err) = 0;
+                            std::string& report, MediaConchLib::compression&, size_t& uncompressed_size,
+                            int& dictionary_id, std::string& err) = 0;
     virtual int  report_is_registered(int user, long file_id, MediaConchLib::report reportKind,
                                       MediaConchLib::format format, const std::string& options,
                                       bool& registered, std::string& err) = 0;
@@ -89,8 +138,29 @@ public:
     virtual int  get_elements(int user, std::vector<long>& vec, std::string& err) = 0;
     virtual int  get_element_report_kind(int user, long file_id, MediaConchLib::report& report_kind, std::string& err) = 0;
 
+    // Watch folder
+    virtual int  get_watch_folder_user(const std::string& folder, long& user, std::string& err) = 0;
+    virtual int  get_watch_folder_files(int user, const std::string& folder,
+                                        std::vector<DatabaseWatchFolderFile>& files, std::string& err) = 0;
+    virtual int  save_watch_folder_file(int user, const std::string& folder, const DatabaseWatchFolderFile& file,
+                                        std::string& err) = 0;
+    virtual int  save_watch_folder_files(int user, const std::string& folder,
+                                         const std::vector<DatabaseWatchFolderFile>& files,
+                                         const std::vector<std::string>& removed, std::string& err);
+    virtual int  remove_watch_folder_file(int user, const std::string& folder, const std::string& filename,
+                                          std::string& err) = 0;
+    virtual int  remove_watch_folder(int user, const std::string& folder, std::string& err) = 0;
+
     virtual int init_report() = 0;
 
+    // Batch: writes between begin and commit are done in one transaction, batches can be nested
+    virtual int  begin_batch(std::string& err);
+    virtual int  commit_batch(std::string& err);
+    virtual int  rollback_batch(std::string& err);
+
+    // New connection to the same database to read while this one writes, NULL if not supported
+    virtual DatabaseReport* open_reader(std::string& err);
+
 protected:
     // Database dependant
     void        get_sql_query_for_create_report_table(std::string& q);
@@ -101,6 +171,12 @@ protected:
     void        get_sql_query_for_update_report_table_v4(std::string& q);
     void        get_sql_query_for_update_report_table_v5(std::string& q);
     void        get_sql_query_for_update_report_table_v6(std::string& q);
+    void        get_sql_query_for_update_report_table_v7(std::string& q);
+    void        get_sql_query_for_update_report_table_v8(std::string& q);
+    void        get_sql_query_for_update_report_table_v9(std::string& q);
+    void        get_sql_query_for_update_report_table_v10(std::string& q);
+    void        get_sql_query_for_update_report_table_v11(std::string& q);
+    void        get_sql_query_for_update_report_table_v12(std::string& q);
 
     // Helpers
     void        longs_to_string(const std::vector<long>&, std::string&);
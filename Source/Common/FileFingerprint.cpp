@@ -0,0 +1,253 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Fingerprint of the content of the files
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#include "FileFingerprint.h"
+#include "ZenLib/File.h"
+#include "ZenLib/Ztring.h"
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <sstream>
+#include <string.h>
+#include <vector>
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// Helpers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// SHA-256 (FIPS 180-4), the files linked by their fingerprint share their reports
+struct Sha256
+{
+    ZenLib::int32u state[8];
+    ZenLib::int8u  block[64];
+    size_t         block_size;
+    ZenLib::int64u total;
+
+    Sha256();
+    void update(const ZenLib::int8u* data, size_t size);
+    std::string final_hex();
+
+private:
+    void transform(const ZenLib::int8u* data);
+};
+
+static const ZenLib::int32u sha256_k[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define SHA256_ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+//---------------------------------------------------------------------------
+Sha256::Sha256() : block_size(0), total(0)
+{
+    state[0] = 0x6a09e667;
+    state[1] = 0xbb67ae85;
+    state[2] = 0x3c6ef372;
+    state[3] = 0xa54ff53a;
+    state[4] = 0x510e527f;
+    state[5] = 0x9b05688c;
+    state[6] = 0x1f83d9ab;
+    state[7] = 0x5be0cd19;
+}
+
+//---------------------------------------------------------------------------
+void Sha256::transform(const ZenLib::int8u* data)
+{
+    ZenLib::int32u w[64];
+    for (size_t i = 0; i < 16; ++i)
+        w[i] = ((ZenLib::int32u)data[i * 4] << 24) | ((ZenLib::int32u)data[i * 4 + 1] << 16)
+             | ((ZenLib::int32u)data[i * 4 + 2] << 8) | (ZenLib::int32u)data[i * 4 + 3];
+    for (size_t i = 16; i < 64; ++i)
+    {
+        ZenLib::int32u s0 = SHA256_ROTR(w[i - 15], 7) ^ SHA256_ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        ZenLib::int32u s1 = SHA256_ROTR(w[i - 2], 17) ^ SHA256_ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    ZenLib::int32u a = state[0], b = state[1], c = state[2], d = state[3];
+    ZenLib::int32u e = state[4], f = state[5], g = state[6], h = state[7];
+    for (size_t i = 0; i < 64; ++i)
+    {
+        ZenLib::int32u t1 = h + (SHA256_ROTR(e, 6) ^ SHA256_ROTR(e, 11) ^ SHA256_ROTR(e, 25))
+                          + ((e & f) ^ (~e & g)) + sha256_k[i] + w[i];
+        ZenLib::int32u t2 = (SHA256_ROTR(a, 2) ^ SHA256_ROTR(a, 13) ^ SHA256_ROTR(a, 22))
+                          + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+//---------------------------------------------------------------------------
+void Sha256::update(const ZenLib::int8u* data, size_t size)
+{
+    total += size;
+    while (size)
+    {
+        if (!block_size && size >= 64)
+        {
+            transform(data);
+            data += 64;
+            size -= 64;
+            continue;
+        }
+
+        size_t len = std::min(size, (size_t)64 - block_size);
+        memcpy(block + block_size, data, len);
+        block_size += len;
+        data += len;
+        size -= len;
+        if (block_size == 64)
+        {
+            transform(block);
+            block_size = 0;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+std::string Sha256::final_hex()
+{
+    // Padding and size in bits, big endian
+    ZenLib::int64u bits = total * 8;
+    ZenLib::int8u pad[72];
+    size_t pad_size = (block_size < 56 ? 56 : 120) - block_size;
+    memset(pad, 0, sizeof(pad));
+    pad[0] = 0x80;
+    for (size_t i = 0; i < 8; ++i)
+        pad[pad_size + i] = (ZenLib::int8u)(bits >> (56 - i * 8));
+    update(pad, pad_size + 8);
+
+    std::stringstream ss;
+    ss << std::hex << std::setfill('0');
+    for (size_t i = 0; i < 8; ++i)
+        ss << std::setw(8) << state[i];
+    return ss.str();
+}
+
+#undef SHA256_ROTR
+
+//***************************************************************************
+// FileFingerprint
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+FileFingerprint::Mode FileFingerprint::mode_from_string(const std::string& mode)
+{
+    std::string str(mode);
+    std::transform(str.begin(), str.end(), str.begin(), (int(*)(int))tolower);
+
+    if (str == "sampled")
+        return MODE_SAMPLED;
+    if (str == "full")
+        return MODE_FULL;
+    return MODE_NONE;
+}
+
+//---------------------------------------------------------------------------
+int FileFingerprint::compute(const std::string& filename, Mode mode, std::string& fingerprint, std::string& err)
+{
+    if (mode == MODE_NONE)
+    {
+        err = "No fingerprint mode.";
+        return -1;
+    }
+
+    ZenLib::File file;
+    if (!file.Open(ZenLib::Ztring().From_UTF8(filename)))
+    {
+        err = "File cannot be read for its fingerprint.";
+        return -1;
+    }
+
+    ZenLib::int64u size = file.Size_Get();
+    Sha256 hash;
+    std::vector<ZenLib::int8u> buffer(BLOCK_SIZE);
+
+    // Small files are always read entirely, their fingerprint is a full one
+    if (size <= (ZenLib::int64u)BLOCK_SIZE * SAMPLED_BLOCKS)
+        mode = MODE_FULL;
+
+    if (mode == MODE_FULL)
+    {
+        size_t read;
+        ZenLib::int64u total = 0;
+        while ((read = file.Read(&buffer[0], buffer.size())) > 0)
+        {
+            hash.update(&buffer[0], read);
+            total += read;
+        }
+
+        if (total != size)
+        {
+            err = "File changed while its fingerprint was computed.";
+            return -1;
+        }
+    }
+    else
+    {
+        // First and last blocks, the others spread between them
+        ZenLib::int64u step = (size - BLOCK_SIZE) / (SAMPLED_BLOCKS - 1);
+        for (size_t i = 0; i < SAMPLED_BLOCKS; ++i)
+        {
+            ZenLib::int64u offset = i == SAMPLED_BLOCKS - 1 ? size - BLOCK_SIZE : step * i;
+            if (!file.GoTo((ZenLib::int64s)offset) || file.Read(&buffer[0], BLOCK_SIZE) != BLOCK_SIZE)
+            {
+                err = "File changed while its fingerprint was computed.";
+                return -1;
+            }
+            hash.update(&buffer[0], BLOCK_SIZE);
+        }
+    }
+    file.Close();
+
+    // Mode is kept, the fingerprints of both modes are never equal
+    std::stringstream ss;
+    ss << (mode == MODE_FULL ? "full:" : "sampled:") << size << ":" << hash.final_hex();
+    fingerprint = ss.str();
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+bool FileFingerprint::is_full(const std::string& fingerprint)
+{
+    return fingerprint.compare(0, 5, "full:") == 0;
+}
+
+}
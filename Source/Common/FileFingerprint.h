@@ -0,0 +1,57 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Fingerprint of the content of the files
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifndef FILEFINGERPRINTH
+#define FILEFINGERPRINTH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include <string>
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// Class FileFingerprint
+//***************************************************************************
+
+// Size and SHA-256 of the content, files with the same fingerprint are analyzed once
+class FileFingerprint
+{
+public:
+    enum Mode
+    {
+        MODE_NONE,
+        // Blocks read at regular offsets, the file is not read entirely (small files are read entirely)
+        MODE_SAMPLED,
+        // The whole file is read
+        MODE_FULL,
+    };
+
+    static Mode mode_from_string(const std::string& mode);
+    static int  compute(const std::string& filename, Mode mode, std::string& fingerprint, std::string& err);
+    // False if the fingerprint only gives a candidate, the file was not read entirely
+    static bool is_full(const std::string& fingerprint);
+
+private:
+    FileFingerprint();
+    FileFingerprint(const FileFingerprint&);
+    FileFingerprint& operator=(const FileFingerprint&);
+
+    static const size_t BLOCK_SIZE = 65536;
+    static const size_t SAMPLED_BLOCKS = 16;
+};
+
+}
+
+#endif // !FILEFINGERPRINTH
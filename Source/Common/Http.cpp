@@ -13,6 +13,7 @@
 //---------------------------------------------------------------------------
 #include "Http.h"
 #include <sstream>
+#include <ctype.h>
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -29,7 +30,7 @@ int Http::current_daemon_id = -1;
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-Http::Http() : address("0.0.0.0"), port(80)
+Http::Http() : address("0.0.0.0"), port(80), http_code(0), pipelining(false)
 {
 }
 
@@ -38,6 +39,20 @@ Http::~Http()
 {
 }
 
+//---------------------------------------------------------------------------
+void Http::get_result_header(const std::string& name, std::string& value)
+{
+    std::string key(name);
+    for (size_t i = 0; i < key.size(); ++i)
+        key[i] = tolower(key[i]);
+
+    std::map<std::string, std::string>::iterator it = result_headers.find(key);
+    if (it != result_headers.end())
+        value = it->second;
+    else
+        value.clear();
+}
+
 //***************************************************************************
 // send_request generator
 //***************************************************************************
@@ -125,6 +140,27 @@ SEND_REQUEST_POST(Checker_File_From_Id_Req, checker_file_from_id);
 SEND_REQUEST_POST(Checker_Id_From_Filename_Req, checker_id_from_filename);
 SEND_REQUEST_POST(Checker_File_Information_Req, checker_file_information);
 SEND_REQUEST_GET(Checker_List_MediaInfo_Outputs_Req, checker_list_mediainfo_outputs);
+SEND_REQUEST_GET(Checker_Events_Req, checker_events);
+
+//---------------------------------------------------------------------------
+int Http::send_request(RESTAPI::Checker_Report_Raw_Req& req, std::string& err)
+{
+    std::string query;
+    if (rest.serialize_checker_report_raw_req(req, query, err) < 0)
+        return -1;
+
+    std::stringstream uri;
+    uri << "/" << RESTAPI::API_VERSION << "/checker_report_raw" << query;
+    std::string uri_str = uri.str();
+
+    // The encoding and the range are given by the headers
+    if (req.accept_deflate)
+        request_headers.push_back(std::make_pair(std::string("Accept-Encoding"), std::string("deflate")));
+    if (req.range.size())
+        request_headers.push_back(std::make_pair(std::string("Range"), req.range));
+
+    return send_request_get(uri_str, err);
+}
 SEND_REQUEST_GET(Default_Values_For_Type_Req, default_values_for_type);
 
 //***************************************************************************
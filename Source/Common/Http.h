@@ -17,6 +17,8 @@
 #include "REST_API.h"
 #include "MediaConchLib.h"
 #include <string>
+#include <vector>
+#include <map>
 //---------------------------------------------------------------------------
 
 namespace MediaConch {
@@ -55,6 +57,8 @@ public:
     int send_request(RESTAPI::Checker_File_From_Id_Req& req, std::string& err);
     int send_request(RESTAPI::Checker_Id_From_Filename_Req& req, std::string& err);
     int send_request(RESTAPI::Checker_List_MediaInfo_Outputs_Req& req, std::string& err);
+    int send_request(RESTAPI::Checker_Events_Req& req, std::string& err);
+    int send_request(RESTAPI::Checker_Report_Raw_Req& req, std::string& err);
     int send_request(RESTAPI::Checker_File_Information_Req& req, std::string& err);
     int send_request(RESTAPI::Default_Values_For_Type_Req& req, std::string& err);
 
@@ -90,7 +94,15 @@ public:
     void reset_daemon_id() { current_daemon_id = -1; }
 
     void get_result(std::string& res) { res = result; }
+    void take_result(std::string& res) { res.swap(result); result.clear(); }
     int  get_http_code() { return http_code; }
+    // Header of the last answer, the name is not case sensitive
+    void get_result_header(const std::string& name, std::string& value);
+
+    // The requests sent after begin_requests are in flight together, their answers are
+    // given by wait_requests in the order of the requests
+    void begin_requests() { pipelining = true; }
+    virtual int wait_requests(std::vector<std::string>& results, std::string& err) = 0;
 
 protected:
     RESTAPI                  rest;
@@ -98,6 +110,10 @@ protected:
     int                      port;
     std::string              result;
     int                      http_code;
+    bool                     pipelining;
+    // Headers added to the next request, and headers of the last answer by lowercase name
+    std::vector<std::pair<std::string, std::string> > request_headers;
+    std::map<std::string, std::string>                result_headers;
 
     static int               current_daemon_id;
 
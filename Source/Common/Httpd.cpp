@@ -26,7 +26,7 @@ namespace MediaConch {
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-Httpd::Httpd(void *p) : port(80), address("0.0.0.0"), parent(p)
+Httpd::Httpd(void *p) : port(80), address("0.0.0.0"), workers_nb(0), max_body_size(0), parent(p)
 {
 }
 
@@ -59,6 +59,24 @@ const std::string& Httpd::get_address() const
     return this->address;
 }
 
+//---------------------------------------------------------------------------
+void Httpd::set_workers(size_t workers)
+{
+    this->workers_nb = workers;
+}
+
+//---------------------------------------------------------------------------
+void Httpd::set_endpoint_limit(const std::string& endpoint, size_t limit)
+{
+    endpoint_limits[endpoint] = limit;
+}
+
+//---------------------------------------------------------------------------
+void Httpd::set_max_body_size(size_t size)
+{
+    max_body_size = size;
+}
+
 //---------------------------------------------------------------------------
 int Httpd::send_result()
 {
@@ -114,6 +132,8 @@ int Httpd::send_result()
     MAKE_URI_REQ_FUNC(checker_clear, Checker_Clear)
     MAKE_URI_REQ_FUNC(checker_list, Checker_List)
     MAKE_URI_REQ_FUNC(checker_list_mediainfo_outputs, Checker_List_MediaInfo_Outputs)
+    MAKE_URI_REQ_FUNC(checker_events, Checker_Events)
+    MAKE_URI_REQ_FUNC(checker_report_raw, Checker_Report_Raw)
     MAKE_URI_REQ_FUNC(default_values_for_type, Default_Values_For_Type)
 
     MAKE_URI_REQ_FUNC(xslt_policy_create, XSLT_Policy_Create)
@@ -16,6 +16,7 @@
 //---------------------------------------------------------------------------
 #include "REST_API.h"
 #include <string>
+#include <map>
 //---------------------------------------------------------------------------
 
 namespace MediaConch {
@@ -38,6 +39,8 @@ public:
     virtual int finish() = 0;
 
     virtual int send_result(int ret_code, const std::string& ret_msg, void *arg) = 0;
+    // Can be called by any thread, the requests of events waiting are checked
+    virtual void analyze_finished() = 0;
 
 #define REQ_FUNC(type) \
     void get_request(std::string& json, RESTAPI::type##_Req** req);
@@ -71,6 +74,8 @@ public:
     URI_REQ_FUNC(Checker_Clear);
     URI_REQ_FUNC(Checker_List);
     URI_REQ_FUNC(Checker_List_MediaInfo_Outputs);
+    URI_REQ_FUNC(Checker_Events);
+    URI_REQ_FUNC(Checker_Report_Raw);
     URI_REQ_FUNC(Default_Values_For_Type);
 
     URI_REQ_FUNC(XSLT_Policy_Create);
@@ -100,6 +105,12 @@ public:
     int  get_port() const;
     void set_address(std::string& address);
     const std::string& get_address() const;
+    // Commands run by a pool of workers, 0 to run all on the server thread
+    void set_workers(size_t workers);
+    // Maximum of a command running at the same time, 0 for no limit
+    void set_endpoint_limit(const std::string& endpoint, size_t limit);
+    // Larger bodies are refused before being read, 0 for no limit
+    void set_max_body_size(size_t size);
 
     std::string get_error() const;
     std::string get_result() const;
@@ -138,6 +149,10 @@ public:
                                                        RESTAPI::Checker_File_Information_Res& res, void* arg);
     typedef int (*on_checker_list_mediainfo_outputs_command)(const RESTAPI::Checker_List_MediaInfo_Outputs_Req* req,
                                                              RESTAPI::Checker_List_MediaInfo_Outputs_Res& res, void* arg);
+    typedef int (*on_checker_events_command)(const RESTAPI::Checker_Events_Req* req,
+                                             RESTAPI::Checker_Events_Res& res, void* arg);
+    typedef int (*on_checker_report_raw_command)(const RESTAPI::Checker_Report_Raw_Req* req,
+                                                 RESTAPI::Checker_Report_Raw_Res& res, void* arg);
     typedef int (*on_default_values_for_type_command)(const RESTAPI::Default_Values_For_Type_Req* req,
                                                       RESTAPI::Default_Values_For_Type_Res& res, void* arg);
 
@@ -199,8 +214,8 @@ public:
                      checker_clear_cb(NULL), checker_stop_cb(NULL), checker_list_cb(NULL),
                      checker_validate_cb(NULL), checker_file_from_id_cb(NULL),
                      checker_id_from_filename_cb(NULL), checker_file_information_cb(NULL),
-                     checker_list_mediainfo_outputs_cb(NULL),
-                     default_values_for_type_cb(NULL),
+                     checker_list_mediainfo_outputs_cb(NULL), checker_events_cb(NULL),
+                     checker_report_raw_cb(NULL), default_values_for_type_cb(NULL),
                      xslt_policy_create_cb(NULL),
                      policy_import_cb(NULL),
                      policy_remove_cb(NULL),
@@ -246,6 +261,8 @@ public:
         on_checker_id_from_filename_command       checker_id_from_filename_cb;
         on_checker_file_information_command       checker_file_information_cb;
         on_checker_list_mediainfo_outputs_command checker_list_mediainfo_outputs_cb;
+        on_checker_events_command                 checker_events_cb;
+        on_checker_report_raw_command             checker_report_raw_cb;
         on_default_values_for_type_command        default_values_for_type_cb;
 
         // policy
@@ -281,6 +298,9 @@ protected:
     int            port;
     std::string    address;
     RESTAPI        rest;
+    size_t         workers_nb;
+    std::map<std::string, size_t> endpoint_limits;
+    size_t         max_body_size;
     void          *parent;
 
     std::string error;
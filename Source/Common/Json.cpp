@@ -44,7 +44,7 @@ int Json::parse(const std::string& data, Value &v)
     json_error_t err;
     json_t       *elements = NULL;
 
-    elements = json_loads(data.c_str(), 0, &err);
+    elements = json_loadb(data.c_str(), data.size(), 0, &err);
 
     if (!elements)
     {
@@ -159,14 +159,14 @@ int Json::parse_node(Value &v)
         const char *key = NULL;
         json_t *value = NULL;
         json_object_foreach(current_node, key, value) {
-            Value new_node;
+            // Parsed in place, the large strings of the children are not copied again
+            Value& new_node = v.obj[std::string(key)];
             json_t *tmp = current_node;
             current_node = value;
 
             if (parse_node(new_node))
                 return -1;
 
-            v.obj[std::string(key)] = new_node;
             current_node = tmp;
         }
         return 0;
@@ -175,15 +175,14 @@ int Json::parse_node(Value &v)
     if (json_is_array(current_node))
     {
         v.type = Value::CONTAINER_TYPE_ARRAY;
-        for (size_t i = 0; i < json_array_size(current_node); ++i)
+        v.array.resize(json_array_size(current_node));
+        for (size_t i = 0; i < v.array.size(); ++i)
         {
-            Value new_node;
             json_t *tmp = current_node;
 
             current_node = json_array_get(current_node, i);
-            if (parse_node(new_node))
+            if (parse_node(v.array[i]))
                 return -1;
-            v.array.push_back(new_node);
             current_node = tmp;
         }
         return 0;
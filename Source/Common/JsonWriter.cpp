@@ -0,0 +1,305 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// JSON written directly in the output, without tree
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifdef __BORLANDC__
+    #pragma hdrstop
+#endif
+
+//---------------------------------------------------------------------------
+#include "JsonWriter.h"
+#include <stdio.h>
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// JsonWriter
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+// Input escaped at each reserve, the longest escape is \u00XX
+static const size_t escape_chunk = 64 * 1024;
+static const size_t escape_max = 6;
+
+//***************************************************************************
+// Constructor/Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+JsonWriter::JsonWriter() : failed(false)
+{
+}
+
+//---------------------------------------------------------------------------
+JsonWriter::~JsonWriter()
+{
+}
+
+//***************************************************************************
+// Values
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void JsonWriter::start_object()
+{
+    start_value();
+    write("{", 1);
+    has_member.push_back(false);
+    in_array.push_back(false);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::end_object()
+{
+    if (has_member.size())
+    {
+        has_member.pop_back();
+        in_array.pop_back();
+    }
+    write("}", 1);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::start_array()
+{
+    start_value();
+    write("[", 1);
+    has_member.push_back(false);
+    in_array.push_back(true);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::end_array()
+{
+    if (has_member.size())
+    {
+        has_member.pop_back();
+        in_array.pop_back();
+    }
+    write("]", 1);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_key(const std::string& key)
+{
+    if (has_member.size())
+    {
+        if (has_member.back())
+            write(", ", 2);
+        has_member.back() = true;
+    }
+
+    write("\"", 1);
+    write_escaped(key.c_str(), key.size());
+    write("\": ", 3);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_string(const std::string& str)
+{
+    start_value();
+    write("\"", 1);
+    write_escaped(str.c_str(), str.size());
+    write("\"", 1);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_integer(long l)
+{
+    char buffer[32];
+#ifdef _MSC_VER
+    int len = _snprintf_s(buffer, sizeof(buffer), _TRUNCATE, "%ld", l);
+#else //_MSC_VER
+    int len = snprintf(buffer, sizeof(buffer), "%ld", l);
+#endif //_MSC_VER
+    if (len < 0)
+        len = 0;
+
+    start_value();
+    write(buffer, len);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_real(double d)
+{
+    // NaN and infinities are not numbers in JSON
+    if (d != d || d - d != 0)
+    {
+        add_null();
+        return;
+    }
+
+    char buffer[32];
+#ifdef _MSC_VER
+    int len = _snprintf_s(buffer, sizeof(buffer), _TRUNCATE, "%.17g", d);
+#else //_MSC_VER
+    int len = snprintf(buffer, sizeof(buffer), "%.17g", d);
+#endif //_MSC_VER
+    if (len < 0)
+        len = 0;
+
+    start_value();
+    write(buffer, len);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_bool(bool b)
+{
+    start_value();
+    if (b)
+        write("true", 4);
+    else
+        write("false", 5);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_null()
+{
+    start_value();
+    write("null", 4);
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::add_value(const Container::Value& v)
+{
+    switch (v.type)
+    {
+        case Container::Value::CONTAINER_TYPE_INTEGER:
+            add_integer(v.l);
+            break;
+        case Container::Value::CONTAINER_TYPE_REAL:
+            add_real(v.d);
+            break;
+        case Container::Value::CONTAINER_TYPE_STRING:
+            add_string(v.s);
+            break;
+        case Container::Value::CONTAINER_TYPE_BOOL:
+            add_bool(v.b);
+            break;
+        case Container::Value::CONTAINER_TYPE_NULL:
+            add_null();
+            break;
+        case Container::Value::CONTAINER_TYPE_ARRAY:
+            start_array();
+            for (size_t i = 0; i < v.array.size(); ++i)
+                add_value(v.array[i]);
+            end_array();
+            break;
+        case Container::Value::CONTAINER_TYPE_OBJECT:
+        {
+            start_object();
+            std::map<std::string, Container::Value>::const_iterator it = v.obj.begin();
+            for (; it != v.obj.end(); ++it)
+            {
+                add_key(it->first);
+                add_value(it->second);
+            }
+            end_object();
+            break;
+        }
+    }
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::start_value()
+{
+    // Elements of an array are separated here, members of an object by their key
+    if (!in_array.size() || !in_array.back())
+        return;
+
+    if (has_member.back())
+        write(", ", 2);
+    has_member.back() = true;
+}
+
+//---------------------------------------------------------------------------
+void JsonWriter::write_escaped(const char* data, size_t len)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    size_t pos = 0;
+    while (pos < len)
+    {
+        size_t size = len - pos;
+        if (size > escape_chunk)
+            size = escape_chunk;
+
+        size_t available = 0;
+        char *out = reserve(size + escape_max, available);
+        if (!out)
+        {
+            set_failed();
+            return;
+        }
+
+        size_t used = 0;
+        while (pos < len && used + escape_max <= available)
+        {
+            unsigned char c = (unsigned char)data[pos++];
+            if (c >= 0x20 && c != '"' && c != '\\')
+            {
+                out[used++] = (char)c;
+                continue;
+            }
+
+            out[used++] = '\\';
+            switch (c)
+            {
+                case '"':  out[used++] = '"'; break;
+                case '\\': out[used++] = '\\'; break;
+                case '\b': out[used++] = 'b'; break;
+                case '\f': out[used++] = 'f'; break;
+                case '\n': out[used++] = 'n'; break;
+                case '\r': out[used++] = 'r'; break;
+                case '\t': out[used++] = 't'; break;
+                default:
+                    out[used++] = 'u';
+                    out[used++] = '0';
+                    out[used++] = '0';
+                    out[used++] = hex[c >> 4];
+                    out[used++] = hex[c & 0xF];
+                    break;
+            }
+        }
+
+        commit(used);
+    }
+}
+
+//***************************************************************************
+// JsonStringWriter
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void JsonStringWriter::write(const char* data, size_t len)
+{
+    out.append(data, len);
+}
+
+//---------------------------------------------------------------------------
+char *JsonStringWriter::reserve(size_t size, size_t& available)
+{
+    reserved = out.size();
+    out.resize(reserved + size);
+    available = size;
+    return &out[reserved];
+}
+
+//---------------------------------------------------------------------------
+void JsonStringWriter::commit(size_t size)
+{
+    out.resize(reserved + size);
+}
+
+}
@@ -0,0 +1,98 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// JSON written directly in the output, without tree
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifndef JsonWriterH
+#define JsonWriterH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include "Container.h"
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// Class JsonWriter
+//***************************************************************************
+
+// Used for the large values (reports), they are escaped in the output without other copy
+class JsonWriter
+{
+public:
+    //Constructor/Destructor
+    JsonWriter();
+    virtual ~JsonWriter();
+
+    void start_object();
+    void end_object();
+    void start_array();
+    void end_array();
+    // Member of the current object, followed by its value
+    void add_key(const std::string& key);
+    void add_string(const std::string& str);
+    void add_integer(long l);
+    void add_real(double d);
+    void add_bool(bool b);
+    void add_null();
+    // Small values built with the container
+    void add_value(const Container::Value& v);
+
+    // The output is incomplete, it must not be sent
+    bool has_failed() const { return failed; }
+
+protected:
+    virtual void  write(const char* data, size_t len) = 0;
+    // Space of at least size bytes at the end of the output, its length is given in available, NULL on failure
+    virtual char *reserve(size_t size, size_t& available) = 0;
+    // Bytes used in the last reserved space
+    virtual void  commit(size_t size) = 0;
+    // Called by the output when it cannot be written
+    void          set_failed() { failed = true; }
+
+private:
+    // By level, true if a member or an element is already written
+    std::vector<bool> has_member;
+    std::vector<bool> in_array;
+    bool              failed;
+
+    void start_value();
+    void write_escaped(const char* data, size_t len);
+
+    JsonWriter(const JsonWriter&);
+    JsonWriter& operator=(const JsonWriter&);
+};
+
+//***************************************************************************
+// Class JsonStringWriter
+//***************************************************************************
+
+class JsonStringWriter : public JsonWriter
+{
+public:
+    JsonStringWriter(std::string& o) : out(o), reserved(0) {}
+
+protected:
+    void  write(const char* data, size_t len);
+    char *reserve(size_t size, size_t& available);
+    void  commit(size_t size);
+
+private:
+    std::string& out;
+    size_t       reserved;
+};
+
+}
+
+#endif // !JsonWriterH
@@ -17,6 +17,7 @@
 #include "LibEventHttp.h"
 #include <sstream>
 #include <stdlib.h>
+#include <ctype.h>
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -27,7 +28,7 @@ namespace MediaConch {
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-LibEventHttp::LibEventHttp() : Http(), base(NULL), connection(NULL)
+LibEventHttp::LibEventHttp() : Http(), base(NULL), next_connection(0), in_flight(0)
 {
 }
 
@@ -52,13 +53,21 @@ int LibEventHttp::init(std::string& err)
 //---------------------------------------------------------------------------
 int LibEventHttp::start(std::string& err)
 {
-    connection = evhttp_connection_base_new(base, NULL, address.c_str(), port);
-    if (!connection)
+    if (connections.size())
+        return 0;
+
+    for (size_t i = 0; i < max_connections; ++i)
     {
-        std::stringstream ss;
-        ss << "Cannot connect to " << address << ":" << port;
-        err = ss.str();
-        return -1;
+        struct evhttp_connection *connection = evhttp_connection_base_new(base, NULL, address.c_str(), port);
+        if (!connection)
+        {
+            std::stringstream ss;
+            ss << "Cannot connect to " << address << ":" << port;
+            err = ss.str();
+            finish_connections();
+            return -1;
+        }
+        connections.push_back(connection);
     }
 
     return 0;
@@ -67,18 +76,16 @@ int LibEventHttp::start(std::string& err)
 //---------------------------------------------------------------------------
 int LibEventHttp::stop()
 {
-    if (connection)
-    {
-        evhttp_connection_free(connection);
-        connection = NULL;
-    }
+    // The connections are kept alive for the next requests
+    clear_requests();
     return 0;
 }
 
 //---------------------------------------------------------------------------
 int LibEventHttp::finish()
 {
-    stop();
+    clear_requests();
+    finish_connections();
     if (base)
     {
         event_base_free(base);
@@ -118,15 +125,79 @@ int LibEventHttp::send_request(std::string& uri, std::string& str, enum evhttp_c
 {
     // clean result
     result.clear();
-    error.clear();
+    result_headers.clear();
     http_code = 0;
 
-    struct evhttp_request *req = evhttp_request_new(result_coming, this);
+    if (start(err) < 0)
+        return -1;
+
+    LibEventHttpRequest *request = new LibEventHttpRequest(this);
+    request->uri = uri;
+    request->body = str;
+    request->type = type;
+    request->headers.swap(request_headers);
+    request_headers.clear();
+    request->connection = connections[next_connection];
+    next_connection = (next_connection + 1) % connections.size();
+    requests.push_back(request);
+
+    if (make_request(request, err) < 0)
+    {
+        clear_requests();
+        return -1;
+    }
+
+    if (pipelining)
+        return 0;
+
+    std::vector<std::string> results;
+    if (wait_requests(results, err) < 0)
+        return -1;
+
+    result = results[0];
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int LibEventHttp::wait_requests(std::vector<std::string>& results, std::string& err)
+{
+    pipelining = false;
+
+    if (in_flight && event_base_dispatch(base) < 0)
+    {
+        err = "HTTP (LibEvent) cannot be dispatched.";
+        clear_requests();
+        return -1;
+    }
+
+    int ret = 0;
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (!ret && requests[i]->error.size())
+        {
+            err = requests[i]->error;
+            http_code = requests[i]->http_code;
+            ret = -1;
+        }
+        results.push_back(requests[i]->result);
+    }
+    if (requests.size())
+        result_headers.swap(requests.back()->result_headers);
+    clear_requests();
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+int LibEventHttp::make_request(LibEventHttpRequest *request, std::string& err)
+{
+    struct evhttp_request *req = evhttp_request_new(result_coming, request);
     if (!req)
     {
         err = "Cannot create HTTP (LibEvent) request.";
         return -1;
     }
+    evhttp_request_set_error_cb(req, request_error);
 
     struct evkeyvalq *evOutHeaders;
     evOutHeaders = evhttp_request_get_output_headers(req);
@@ -136,63 +207,118 @@ int LibEventHttp::send_request(std::string& uri, std::string& str, enum evhttp_c
     ss << current_daemon_id;
     evhttp_add_header(evOutHeaders, "X-App-MediaConch-Instance-ID", ss.str().c_str());
 
-    if (str.length())
+    for (size_t i = 0; i < request->headers.size(); ++i)
+        evhttp_add_header(evOutHeaders, request->headers[i].first.c_str(), request->headers[i].second.c_str());
+
+    if (request->body.length())
     {
         struct evbuffer *evOutBuf = evhttp_request_get_output_buffer(req);;
         if (!evOutBuf)
         {
+            evhttp_request_free(req);
             err = "Cannot create output HTTP (LibEvent) buffer.";
             return -1;
         }
 
-        evbuffer_add(evOutBuf, str.c_str(), str.length());
+        evbuffer_add(evOutBuf, request->body.c_str(), request->body.length());
 
         std::stringstream len_str;
-        len_str << str.length();
+        len_str << request->body.length();
         evhttp_add_header(evOutHeaders, "Content-Length", len_str.str().c_str());
         evhttp_add_header(evOutHeaders, "Content-Type", "application/json");
     }
 
-    int r = evhttp_make_request(connection, req, type, uri.c_str());
+    // The request is freed by LibEvent once answered
+    int r = evhttp_make_request(request->connection, req, request->type, request->uri.c_str());
     if (r)
     {
         err = "The HTTP (LibEvent) request created has invalid data.";
         return -1;
     }
 
-    if (event_base_dispatch(base) < 0 || error.size())
-    {
-        err = error;
-        return -1;
-    }
-
+    ++in_flight;
     return 0;
 }
 
+//---------------------------------------------------------------------------
+void LibEventHttp::request_done()
+{
+    if (in_flight && !--in_flight)
+        event_base_loopexit(base, NULL);
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttp::finish_connections()
+{
+    for (size_t i = 0; i < connections.size(); ++i)
+        evhttp_connection_free(connections[i]);
+    connections.clear();
+    next_connection = 0;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttp::clear_requests()
+{
+    // Requests not answered are cancelled with their connection
+    if (in_flight)
+        finish_connections();
+
+    for (size_t i = 0; i < requests.size(); ++i)
+        delete requests[i];
+    requests.clear();
+    in_flight = 0;
+    pipelining = false;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttp::request_error(enum evhttp_request_error, void *arg)
+{
+    // Called before result_coming, not called when the connection cannot be made
+    LibEventHttpRequest *request = (LibEventHttpRequest*)arg;
+    request->failed_while_sent = true;
+}
+
 //---------------------------------------------------------------------------
 void LibEventHttp::result_coming(struct evhttp_request *req, void *arg)
 {
-    LibEventHttp *evHttp = (LibEventHttp*)arg;
+    LibEventHttpRequest *request = (LibEventHttpRequest*)arg;
+    LibEventHttp *evHttp = request->http;
+
+    // Connection not made, the request was never written and is sent again once
+    // The others may have been run by the daemon, they are not sent again
+    if (req && !evhttp_request_get_response_code(req) && !request->failed_while_sent && !request->retried)
+    {
+        std::string err;
+        request->retried = true;
+        --evHttp->in_flight;
+        if (evHttp->make_request(request, err) == 0)
+            return;
+        ++evHttp->in_flight;
+    }
 
     if (!req)
     {
-        evHttp->error = "Invalid request";
+        request->error = "Invalid request";
+        evHttp->request_done();
         return;
     }
 
+    // Partial content is asked by the range of a raw report
     int code = evhttp_request_get_response_code(req);
-    if (code != HTTP_OK)
+    if (code != HTTP_OK && code != 206)
     {
         if (code == 410)
-            evHttp->error = "Daemon restarted";
+            request->error = "Daemon restarted";
+        else if (code == 416)
+            request->error = "Range not satisfiable";
         else if (code >= 400 && code < 500)
-            evHttp->error = "Invalid Data in request";
+            request->error = "Invalid Data in request";
         else
         {
-            evHttp->http_code = code;
-            evHttp->error = "Internal error: HTTP (LibEvent) connection failed";
+            request->http_code = code;
+            request->error = "Internal error: HTTP (LibEvent) connection failed";
         }
-        event_base_loopexit(evHttp->base, NULL);
+        evHttp->request_done();
         return;
     }
 
@@ -201,27 +327,30 @@ void LibEventHttp::result_coming(struct evhttp_request *req, void *arg)
     {
         for (struct evkeyval *header = headers->tqh_first; header; header = header->next.tqe_next)
         {
-            if (header->key && std::string(header->key) == "X-App-MediaConch-Instance-ID")
+            if (!header->key)
+                continue;
+
+            if (std::string(header->key) == "X-App-MediaConch-Instance-ID")
                 current_daemon_id = header->value ? strtol(header->value, NULL, 10) : -1;
+
+            std::string key(header->key);
+            for (size_t i = 0; i < key.size(); ++i)
+                key[i] = tolower(key[i]);
+            request->result_headers[key] = header->value ? header->value : "";
         }
     }
 
-    std::string data;
+    // Read in the result, large reports are not copied again
     struct evbuffer *evInputBuf = evhttp_request_get_input_buffer(req);
-    int len = evbuffer_get_length(evInputBuf);
+    size_t len = evbuffer_get_length(evInputBuf);
     if (len > 0)
     {
-        char* buff=new char[len + 1];
-        int n = evbuffer_remove(evInputBuf, buff, len);
-
-        buff[n >= 0 ? n : 0] = '\0';
-        data = std::string(buff, n);
-
-        delete[] buff;
+        request->result.resize(len);
+        ev_ssize_t n = evbuffer_remove(evInputBuf, &request->result[0], len);
+        request->result.resize(n > 0 ? (size_t)n : 0);
     }
 
-    evHttp->result = data;
-    event_base_loopexit(evHttp->base, 0);
+    evHttp->request_done();
 }
 
 }
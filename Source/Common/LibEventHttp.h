@@ -19,6 +19,7 @@
 
 #include "Http.h"
 #include <string>
+#include <vector>
 
 #include <event2/event.h>
 #include <event2/http.h>
@@ -30,8 +31,35 @@
 
 namespace MediaConch {
 
+class LibEventHttp;
+
+//***************************************************************************
+// Struct LibEventHttpRequest
+//***************************************************************************
+
+struct LibEventHttpRequest
+{
+    LibEventHttpRequest(LibEventHttp *h) : http(h), type(EVHTTP_REQ_GET), connection(NULL), retried(false),
+                                           failed_while_sent(false), http_code(0) {}
+
+    LibEventHttp             *http;
+    std::string               uri;
+    std::string               body;
+    enum evhttp_cmd_type      type;
+    struct evhttp_connection *connection;
+    bool                      retried;
+    // Error reported by LibEvent once the connection was made, the request may have been received
+    bool                      failed_while_sent;
+    std::vector<std::pair<std::string, std::string> > headers;
+
+    std::string               result;
+    std::string               error;
+    int                       http_code;
+    std::map<std::string, std::string> result_headers;
+};
+
 //***************************************************************************
-// Class Httpd
+// Class LibEventHttp
 //***************************************************************************
 
 class LibEventHttp : public Http
@@ -46,12 +74,23 @@ public:
     int stop();
     int finish();
 
+    virtual int wait_requests(std::vector<std::string>& results, std::string& err);
+
 private:
-    struct event_base          *base;
-    struct evhttp_connection   *connection;
-    std::string                 error;
+    // Kept alive between the requests, reconnected by LibEvent when closed by the daemon
+    static const size_t                    max_connections = 4;
+    struct event_base                     *base;
+    std::vector<struct evhttp_connection*> connections;
+    size_t                                 next_connection;
+    std::vector<LibEventHttpRequest*>      requests;
+    size_t                                 in_flight;
 
     static void result_coming(struct evhttp_request *req, void *arg);
+    static void request_error(enum evhttp_request_error error, void *arg);
+    int make_request(LibEventHttpRequest *request, std::string& err);
+    void request_done();
+    void clear_requests();
+    void finish_connections();
 
     virtual int send_request_get(std::string& uri, std::string& err);
     virtual int send_request_post(std::string& uri, std::string& str, std::string& err);
@@ -22,9 +22,11 @@
 #include <process.h>
 #else
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #endif
 #include <event2/keyvalq_struct.h>
+#include <event2/util.h>
 
 //---------------------------------------------------------------------------
 namespace MediaConch {
@@ -33,18 +35,104 @@ namespace MediaConch {
 // Httpd
 //***************************************************************************
 int LibEventHttpd::pid = -1;
+
+//---------------------------------------------------------------------------
+// Longest wait of a request of events, in milliseconds
+static const size_t events_timeout_max = 30000;
+
+//---------------------------------------------------------------------------
+// Commands changing the policies, run when no other command is running
+static const char* exclusive_endpoints[] =
+{
+    "xslt_policy_create",
+    "policy_import",
+    "policy_remove",
+    "policy_save",
+    "policy_duplicate",
+    "policy_move",
+    "policy_change_info",
+    "policy_change_type",
+    "policy_change_is_public",
+    "policy_clear_policies",
+    "xslt_policy_create_from_file",
+    "xslt_policy_rule_create",
+    "xslt_policy_rule_edit",
+    "xslt_policy_rule_duplicate",
+    "xslt_policy_rule_move",
+    "xslt_policy_rule_delete",
+    NULL
+};
+
+//***************************************************************************
+// LibEventHttpdWorker
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+LibEventHttpdWorker::LibEventHttpdWorker(LibEventHttpd *h) : httpd(h)
+{
+    handler = new LibEventHttpd(h->parent);
+    handler->commands = h->commands;
+    handler->set_address(h->address);
+}
+
+//---------------------------------------------------------------------------
+LibEventHttpdWorker::~LibEventHttpdWorker()
+{
+    delete handler;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpdWorker::Entry()
+{
+    httpd->worker_loop(handler);
+}
+
+//***************************************************************************
+// LibEventHttpdJsonWriter
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+void LibEventHttpdJsonWriter::write(const char* data, size_t len)
+{
+    if (evbuffer_add(buffer, data, len) < 0)
+        set_failed();
+}
+
+//---------------------------------------------------------------------------
+char *LibEventHttpdJsonWriter::reserve(size_t size, size_t& available)
+{
+    // One extent of at least size bytes
+    if (evbuffer_reserve_space(buffer, size, &extent, 1) < 1)
+        return NULL;
+
+    available = extent.iov_len;
+    return (char*)extent.iov_base;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpdJsonWriter::commit(size_t size)
+{
+    extent.iov_len = size;
+    if (evbuffer_commit_space(buffer, &extent, 1) < 0)
+        set_failed();
+}
+
 //***************************************************************************
 // Constructor/Destructor
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-LibEventHttpd::LibEventHttpd(void* arg) : Httpd(arg), base(NULL), http(NULL), handle(NULL)
+LibEventHttpd::LibEventHttpd(void* arg) : Httpd(arg), base(NULL), http(NULL), handle(NULL),
+                                          jobs_running(0), exclusive_running(false), workers_running(0), stopping(false),
+                                          jobs_event(NULL), job(NULL), result_buffer(NULL), waiters_event(NULL)
 {
     #ifdef _WIN32
     pid = _getpid();
     #else
     pid = getpid();
     #endif
+    jobs_notify[0] = -1;
+    jobs_notify[1] = -1;
 }
 
 //---------------------------------------------------------------------------
@@ -70,6 +158,10 @@ int LibEventHttpd::init(std::string& err)
         return -1;
     }
 
+    // Checked with the Content-Length and while reading a chunked body, answered by 413
+    if (max_body_size)
+        evhttp_set_max_body_size(http, (ev_ssize_t)max_body_size);
+
     evhttp_set_gencb(http, request_coming, this);
     return 0;
 }
@@ -91,6 +183,9 @@ int LibEventHttpd::bind(std::string& err)
 //---------------------------------------------------------------------------
 int LibEventHttpd::start(std::string& err)
 {
+    if (start_notification(err) < 0 || start_workers(err) < 0)
+        return -1;
+
     int ret = event_base_dispatch(base);
     if (ret < 0)
         err = "HTTP (LibEvent) cannot be dispatached";
@@ -100,6 +195,9 @@ int LibEventHttpd::start(std::string& err)
 //---------------------------------------------------------------------------
 int LibEventHttpd::finish()
 {
+    stop_workers();
+    free_waiters();
+    stop_notification();
     if (handle)
     {
         evhttp_del_accept_socket(http, handle);
@@ -121,6 +219,22 @@ int LibEventHttpd::finish()
 //---------------------------------------------------------------------------
 int LibEventHttpd::send_result(int ret_code, const std::string& ret_msg, void *arg)
 {
+    // In a worker, the reply is sent by the server thread
+    if (job)
+    {
+        job->code = ret_code;
+        job->ret_msg = ret_msg;
+        job->error.swap(error);
+        job->result.swap(result);
+        job->result_buffer = result_buffer;
+        result_buffer = NULL;
+        job->result_headers.swap(result_headers);
+        result_headers.clear();
+        error.clear();
+        result.clear();
+        return 0;
+    }
+
     struct evhttp_request *req = (struct evhttp_request *)arg;
     struct evbuffer *evOutBuf = evbuffer_new();
 
@@ -133,31 +247,200 @@ int LibEventHttpd::send_result(int ret_code, const std::string& ret_msg, void *a
         ss << pid;
         evhttp_add_header(evOutHeaders, "X-App-MediaConch-Instance-ID", ss.str().c_str());
 
-        ss.str("");
         if (error.length())
-        {
-            ss << error.length();
             evbuffer_add_printf(evOutBuf, "%s\n", error.c_str());
+        else if (result_headers.size())
+        {
+            // Raw reply, sent as it is
+            for (size_t i = 0; i < result_headers.size(); ++i)
+                evhttp_add_header(evOutHeaders, result_headers[i].first.c_str(), result_headers[i].second.c_str());
+            if (result_buffer)
+                evbuffer_add_buffer(evOutBuf, result_buffer);
+        }
+        else if (result_buffer && evbuffer_get_length(result_buffer))
+        {
+            // Chains moved, the reply is not copied
+            evhttp_add_header(evOutHeaders, "Content-Type", "application/json");
+            evbuffer_add_buffer(evOutBuf, result_buffer);
+            evbuffer_add(evOutBuf, "\n", 1);
         }
         else if (result.length())
         {
-            ss << result.length();
             evhttp_add_header(evOutHeaders, "Content-Type", "application/json");
-            evbuffer_add_printf(evOutBuf, "%s\n", result.c_str());
+            evbuffer_add(evOutBuf, result.c_str(), result.length());
+            evbuffer_add(evOutBuf, "\n", 1);
         }
-        else
-            ss << 0;
+
+        // Exact size of the body, the connections are kept alive
+        ss.str("");
+        ss << evbuffer_get_length(evOutBuf);
         evhttp_add_header(evOutHeaders, "Content-Length", ss.str().c_str());
     }
     evhttp_send_reply(req, ret_code, ret_msg.c_str(), evOutBuf);
     if (evOutBuf)
         evbuffer_free(evOutBuf);
+    if (result_buffer)
+    {
+        evbuffer_free(result_buffer);
+        result_buffer = NULL;
+    }
+    result_headers.clear();
 
     // clean error
     error.clear();
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int LibEventHttpd::set_raw_result(const RESTAPI::Checker_Report_Raw_Req *r, RESTAPI::Checker_Report_Raw_Res& res,
+                                  std::string& ret_msg)
+{
+    std::stringstream total;
+    total << res.report.size();
+
+    result_headers.push_back(std::make_pair(std::string("Content-Type"), std::string("application/xml")));
+    result_headers.push_back(std::make_pair(std::string("Accept-Ranges"), std::string("bytes")));
+    if (res.deflate)
+    {
+        std::stringstream size;
+        size << res.uncompressed_size;
+        result_headers.push_back(std::make_pair(std::string("Content-Encoding"), std::string("deflate")));
+        result_headers.push_back(std::make_pair(std::string("X-App-MediaConch-Uncompressed-Size"), size.str()));
+    }
+
+    // The range is in the bytes sent, compressed or not
+    size_t first = 0;
+    size_t last = 0;
+    int range = parse_range(r->range, res.report.size(), first, last);
+    if (range < 0)
+    {
+        result_headers.push_back(std::make_pair(std::string("Content-Range"), "bytes */" + total.str()));
+        ret_msg = "Range Not Satisfiable";
+        return 416;
+    }
+
+    int code = HTTP_OK;
+    if (range > 0)
+    {
+        std::stringstream content_range;
+        content_range << "bytes " << first << "-" << last << "/" << total.str();
+        result_headers.push_back(std::make_pair(std::string("Content-Range"), content_range.str()));
+        ret_msg = "Partial Content";
+        code = 206;
+    }
+
+    if (!res.report.size())
+        return code;
+
+    result_buffer = evbuffer_new();
+    if (!result_buffer)
+        return code;
+
+    // The report is referenced by the buffer, it is not copied
+    std::string *report = new std::string;
+    report->swap(res.report);
+    size_t offset = range > 0 ? first : 0;
+    size_t len = range > 0 ? last - first + 1 : report->size();
+    if (evbuffer_add_reference(result_buffer, report->c_str() + offset, len, free_raw_result, report) < 0)
+    {
+        delete report;
+        evbuffer_free(result_buffer);
+        result_buffer = NULL;
+    }
+    return code;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::free_raw_result(const void*, size_t, void *arg)
+{
+    delete (std::string*)arg;
+}
+
+//---------------------------------------------------------------------------
+bool LibEventHttpd::accepts_encoding(const char *accept_encoding, const std::string& coding)
+{
+    if (!accept_encoding)
+        return false;
+
+    // Codings separated by a comma, with an optional weight: "gzip, deflate;q=0.5"
+    std::string accept(accept_encoding);
+    size_t start = 0;
+    while (start < accept.size())
+    {
+        size_t end = accept.find(",", start);
+        if (end == std::string::npos)
+            end = accept.size();
+
+        std::string item = accept.substr(start, end - start);
+        start = end + 1;
+
+        size_t params = item.find(";");
+        std::string name = item.substr(0, params);
+        size_t name_start = name.find_first_not_of(" \t");
+        size_t name_end = name.find_last_not_of(" \t");
+        if (name_start == std::string::npos)
+            continue;
+        name = name.substr(name_start, name_end - name_start + 1);
+
+        if (name != coding && name != "*")
+            continue;
+
+        if (params == std::string::npos)
+            return true;
+
+        size_t q = item.find("q=", params);
+        return q == std::string::npos || strtod(item.c_str() + q + 2, NULL) > 0;
+    }
+    return false;
+}
+
+//---------------------------------------------------------------------------
+// 1 if a range is asked, 0 if the whole content is sent, -1 if the range cannot be satisfied
+int LibEventHttpd::parse_range(const std::string& range, size_t total, size_t& first, size_t& last)
+{
+    // Only one range is sent, the others requests get the whole content
+    if (range.find("bytes=") != 0 || range.find(",") != std::string::npos)
+        return 0;
+
+    std::string spec = range.substr(6);
+    size_t dash = spec.find("-");
+    if (dash == std::string::npos)
+        return 0;
+
+    std::string first_str = spec.substr(0, dash);
+    std::string last_str = spec.substr(dash + 1);
+    if (first_str.find_first_not_of("0123456789") != std::string::npos ||
+        last_str.find_first_not_of("0123456789") != std::string::npos ||
+        (!first_str.size() && !last_str.size()))
+        return 0;
+
+    if (!first_str.size())
+    {
+        // Suffix: the last bytes
+        unsigned long long suffix = strtoull(last_str.c_str(), NULL, 10);
+        if (!suffix || !total)
+            return -1;
+        first = suffix < total ? total - (size_t)suffix : 0;
+        last = total - 1;
+        return 1;
+    }
+
+    unsigned long long first_pos = strtoull(first_str.c_str(), NULL, 10);
+    if (first_pos >= total)
+        return -1;
+    first = (size_t)first_pos;
+    last = total - 1;
+    if (last_str.size())
+    {
+        unsigned long long last_pos = strtoull(last_str.c_str(), NULL, 10);
+        if (last_pos < first_pos)
+            return 0;
+        if (last_pos < total)
+            last = (size_t)last_pos;
+    }
+    return 1;
+}
+
 //---------------------------------------------------------------------------
 void LibEventHttpd::request_get_coming(struct evhttp_request *req, std::string& err)
 {
@@ -285,6 +568,76 @@ void LibEventHttpd::request_get_coming(struct evhttp_request *req, std::string&
             error = rest.get_error();
     }
 
+    else if (!std::string("/checker_events").compare(uri_path))
+    {
+        std::string query;
+        RESTAPI::Checker_Events_Req *r = NULL;
+        if (query_str)
+            query = std::string(query_str);
+        get_uri_request(query, &r);
+        if (!r)
+        {
+            ret_msg = "NOVALIDCONTENT";
+            code = HTTP_BADREQUEST;
+            goto send;
+        }
+
+        RESTAPI::Checker_Events_Res res;
+        if (!commands.checker_events_cb || commands.checker_events_cb(r, res, parent) < 0)
+        {
+            delete r;
+            ret_msg = "NOVALIDCONTENT";
+            code = HTTP_BADREQUEST;
+            goto send;
+        }
+
+        // Nothing finished yet, the reply is sent by the timer
+        if (!res.nok && !res.events_lost && res.finished.empty() && r->last_event >= 0 && r->timeout &&
+            wait_events(req, r))
+            return;
+
+        delete r;
+        if (rest.serialize_checker_events_res(res, result, err) < 0)
+            error = rest.get_error();
+    }
+
+    else if (query_str && !std::string("/checker_report_raw").compare(uri_path))
+    {
+        std::string query(query_str);
+        RESTAPI::Checker_Report_Raw_Req *r = NULL;
+        get_uri_request(query, &r);
+        if (!r)
+        {
+            ret_msg = "NOVALIDCONTENT";
+            code = HTTP_BADREQUEST;
+            goto send;
+        }
+
+        const struct evkeyvalq *headers = evhttp_request_get_input_headers(req);
+        r->accept_deflate = accepts_encoding(evhttp_find_header(headers, "Accept-Encoding"), "deflate");
+        const char *range = evhttp_find_header(headers, "Range");
+        if (range)
+            r->range = std::string(range);
+
+        RESTAPI::Checker_Report_Raw_Res res;
+        if (!commands.checker_report_raw_cb || commands.checker_report_raw_cb(r, res, parent) < 0)
+        {
+            delete r;
+            ret_msg = "NOVALIDCONTENT";
+            code = HTTP_BADREQUEST;
+            goto send;
+        }
+
+        if (res.nok)
+        {
+            if (rest.serialize_checker_report_raw_res(res, result, err) < 0)
+                error = rest.get_error();
+        }
+        else
+            code = set_raw_result(r, res, ret_msg);
+        delete r;
+    }
+
     else if (query_str && !std::string("/default_values_for_type").compare(uri_path))
     {
         std::string query(query_str);
@@ -879,7 +1232,24 @@ void LibEventHttpd::request_post_coming(struct evhttp_request *req, std::string&
         }
 
         delete r;
-        if (rest.serialize_checker_report_res(res, result, err) < 0)
+
+        // Large reports, the JSON is written in the reply without tree nor intermediate string
+        result_buffer = evbuffer_new();
+        if (result_buffer)
+        {
+            LibEventHttpdJsonWriter writer(result_buffer);
+            if (rest.serialize_checker_report_res(res, writer, err) < 0)
+            {
+                // Not sent truncated
+                evbuffer_free(result_buffer);
+                result_buffer = NULL;
+                error = err;
+                ret_msg = "Internal Server Error";
+                code = HTTP_INTERNAL;
+                goto send;
+            }
+        }
+        else if (rest.serialize_checker_report_res(res, result, err) < 0)
             error = rest.get_error();
     }
 
@@ -1195,7 +1565,6 @@ send:
 void LibEventHttpd::request_coming(struct evhttp_request *req, void *arg)
 {
     LibEventHttpd    *evHttp = (LibEventHttpd*)arg;
-    std::string       ret_msg("OK");
 
     evHttp->error.clear();
     evHttp->result.clear();
@@ -1208,27 +1577,444 @@ void LibEventHttpd::request_coming(struct evhttp_request *req, void *arg)
         return;
     }
 
+    if (evHttp->dispatch_request(req))
+        return;
+
+    evHttp->handle_request(req);
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::handle_request(struct evhttp_request *req)
+{
+    std::string ret_msg("OK");
+
     switch (evhttp_request_get_command(req))
     {
         case EVHTTP_REQ_GET:
-            evHttp->request_get_coming(req, evHttp->error);
+            request_get_coming(req, error);
             break;
         case EVHTTP_REQ_POST:
-            evHttp->request_post_coming(req, evHttp->error);
+            request_post_coming(req, error);
             break;
         case EVHTTP_REQ_PUT:
-            evHttp->request_put_coming(req, evHttp->error);
+            request_put_coming(req, error);
             break;
         case EVHTTP_REQ_DELETE:
-            evHttp->request_delete_coming(req, evHttp->error);
+            request_delete_coming(req, error);
             break;
         default:
-            evHttp->error = "HTTP Request command not supported";
-            evHttp->send_result(HTTP_BADREQUEST, ret_msg, req);
+            error = "HTTP Request command not supported";
+            send_result(HTTP_BADREQUEST, ret_msg, req);
             return;
     }
 }
 
+//***************************************************************************
+// Workers
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+int LibEventHttpd::start_workers(std::string& err)
+{
+    if (!workers_nb || !workers.empty())
+        return 0;
+
+    // Heavy commands are always run by the workers
+    if (endpoint_limits.find("checker_report") == endpoint_limits.end())
+        endpoint_limits["checker_report"] = 0;
+    if (endpoint_limits.find("checker_validate") == endpoint_limits.end())
+        endpoint_limits["checker_validate"] = 0;
+    if (endpoint_limits.find("checker_report_raw") == endpoint_limits.end())
+        endpoint_limits["checker_report_raw"] = 0;
+
+    jobs_cond.lock();
+    stopping = false;
+    for (size_t i = 0; i < workers_nb; ++i)
+    {
+        LibEventHttpdWorker *worker = new LibEventHttpdWorker(this);
+        if (worker->Run() != ZenLib::Thread::Ok)
+        {
+            delete worker;
+            continue;
+        }
+        workers.push_back(worker);
+        ++workers_running;
+    }
+    jobs_cond.unlock();
+
+    if (workers.empty())
+    {
+        err = "Cannot start the workers.";
+        return -1;
+    }
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::stop_workers()
+{
+    // Workers finish their current job before leaving
+    jobs_cond.lock();
+    stopping = true;
+    jobs_cond.broadcast();
+    while (workers_running)
+        jobs_cond.wait();
+    jobs_cond.unlock();
+
+    // ZenLib threads are detached, only their exit is left to wait for
+    for (size_t i = 0; i < workers.size(); ++i)
+    {
+        while (!workers[i]->IsExited())
+            ZenLib::Thread::Yield();
+        delete workers[i];
+    }
+    workers.clear();
+
+    // Requests not answered are freed with the connections
+    std::list<LibEventHttpdJob*>::iterator it = jobs_pending.begin();
+    for (; it != jobs_pending.end(); ++it)
+        delete *it;
+    jobs_pending.clear();
+    for (size_t i = 0; i < jobs_done.size(); ++i)
+        delete jobs_done[i];
+    jobs_done.clear();
+    endpoint_running.clear();
+    jobs_running = 0;
+    exclusive_running = false;
+}
+
+//---------------------------------------------------------------------------
+int LibEventHttpd::start_notification(std::string& err)
+{
+    if (jobs_event)
+        return 0;
+
+#ifdef _WIN32
+    int family = AF_INET;
+#else
+    int family = AF_UNIX;
+#endif
+    evutil_socket_t fds[2];
+    if (evutil_socketpair(family, SOCK_STREAM, 0, fds) < 0)
+    {
+        err = "cannot create the notification socket of the server";
+        return -1;
+    }
+    evutil_make_socket_nonblocking(fds[0]);
+    evutil_make_socket_nonblocking(fds[1]);
+
+    jobs_cond.lock();
+    jobs_notify[0] = fds[0];
+    jobs_notify[1] = fds[1];
+    jobs_cond.unlock();
+
+    jobs_event = event_new(base, jobs_notify[0], EV_READ | EV_PERSIST, jobs_done_coming, this);
+    if (!jobs_event || event_add(jobs_event, NULL) < 0)
+    {
+        err = "cannot create the notification event of the server";
+        return -1;
+    }
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::stop_notification()
+{
+    if (jobs_event)
+    {
+        event_free(jobs_event);
+        jobs_event = NULL;
+    }
+
+    jobs_cond.lock();
+    for (size_t i = 0; i < 2; ++i)
+    {
+        if (jobs_notify[i] == -1)
+            continue;
+        evutil_closesocket(jobs_notify[i]);
+        jobs_notify[i] = -1;
+    }
+    jobs_cond.unlock();
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::analyze_finished()
+{
+    jobs_cond.lock();
+    if (jobs_notify[1] != -1)
+        send(jobs_notify[1], "", 1, 0);
+    jobs_cond.unlock();
+}
+
+//---------------------------------------------------------------------------
+bool LibEventHttpd::dispatch_request(struct evhttp_request *req)
+{
+    if (workers.empty())
+        return false;
+
+    const char *path = evhttp_uri_get_path(evhttp_request_get_evhttp_uri(req));
+    std::string prefix("/" + RESTAPI::API_VERSION + "/");
+    if (!path || std::string(path).find(prefix) != 0)
+        return false;
+
+    std::string endpoint = std::string(path).substr(prefix.length());
+    bool exclusive = false;
+    for (size_t i = 0; exclusive_endpoints[i]; ++i)
+        if (endpoint == exclusive_endpoints[i])
+            exclusive = true;
+
+    // The policies are read by the workers, the other light commands stay on the server thread
+    if (!exclusive && endpoint_limits.find(endpoint) == endpoint_limits.end() &&
+        endpoint.find("policy_") != 0 && endpoint.find("xslt_policy_") != 0)
+        return false;
+
+    LibEventHttpdJob *j = new LibEventHttpdJob;
+    j->req = req;
+    j->endpoint = endpoint;
+    j->exclusive = exclusive;
+
+    // The body is read here, the workers do not use the buffers of the connection
+    j->has_body = read_body(req, j->body, j->ret_msg) == 0;
+
+    jobs_cond.lock();
+    jobs_pending.push_back(j);
+    jobs_cond.signal();
+    jobs_cond.unlock();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+// Called with jobs_cond locked
+LibEventHttpdJob* LibEventHttpd::next_job()
+{
+    std::list<LibEventHttpdJob*>::iterator it = jobs_pending.begin();
+    for (; it != jobs_pending.end(); ++it)
+    {
+        // Keep the order with the commands changing the policies
+        if (exclusive_running)
+            return NULL;
+
+        if ((*it)->exclusive)
+        {
+            if (jobs_running)
+                return NULL;
+            break;
+        }
+
+        std::map<std::string, size_t>::iterator limit = endpoint_limits.find((*it)->endpoint);
+        if (limit == endpoint_limits.end() || !limit->second || endpoint_running[(*it)->endpoint] < limit->second)
+            break;
+    }
+
+    if (it == jobs_pending.end())
+        return NULL;
+
+    LibEventHttpdJob *j = *it;
+    jobs_pending.erase(it);
+    ++jobs_running;
+    ++endpoint_running[j->endpoint];
+    if (j->exclusive)
+        exclusive_running = true;
+    return j;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::worker_loop(LibEventHttpd *handler)
+{
+    jobs_cond.lock();
+    while (true)
+    {
+        LibEventHttpdJob *j = NULL;
+        while (!stopping && (j = next_job()) == NULL)
+            jobs_cond.wait();
+
+        if (!j)
+            break;
+        jobs_cond.unlock();
+
+        handler->job = j;
+        handler->error.clear();
+        handler->result.clear();
+        handler->handle_request(j->req);
+        handler->job = NULL;
+
+        jobs_cond.lock();
+        --jobs_running;
+        --endpoint_running[j->endpoint];
+        if (j->exclusive)
+            exclusive_running = false;
+        jobs_done.push_back(j);
+
+        // Jobs waiting for a limit or for the end of a command changing the policies
+        jobs_cond.broadcast();
+        send(jobs_notify[1], "", 1, 0);
+    }
+
+    --workers_running;
+    jobs_cond.broadcast();
+    jobs_cond.unlock();
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::jobs_done_coming(evutil_socket_t fd, short, void *arg)
+{
+    LibEventHttpd *evHttp = (LibEventHttpd*)arg;
+
+    char buffer[64];
+    while (recv(fd, buffer, sizeof(buffer), 0) > 0)
+        ;
+
+    std::vector<LibEventHttpdJob*> done;
+    evHttp->jobs_cond.lock();
+    done.swap(evHttp->jobs_done);
+    evHttp->jobs_cond.unlock();
+
+    for (size_t i = 0; i < done.size(); ++i)
+    {
+        evHttp->error.swap(done[i]->error);
+        evHttp->result.swap(done[i]->result);
+        evHttp->result_buffer = done[i]->result_buffer;
+        done[i]->result_buffer = NULL;
+        evHttp->result_headers.swap(done[i]->result_headers);
+        evHttp->send_result(done[i]->code, done[i]->ret_msg, done[i]->req);
+        evHttp->result.clear();
+        delete done[i];
+    }
+
+    // Woken up by an analysis finished too
+    if (!evHttp->waiters.empty())
+        evHttp->send_waiters_events();
+}
+
+//***************************************************************************
+// Events
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+bool LibEventHttpd::wait_events(struct evhttp_request *req, RESTAPI::Checker_Events_Req *r)
+{
+    // Only the server thread keeps the requests
+    if (job || !base)
+        return false;
+
+    // Woken up by the analyses finished
+    if (!jobs_event)
+        return false;
+
+    if (!waiters_event)
+    {
+        waiters_event = event_new(base, -1, 0, waiters_timer_coming, this);
+        if (!waiters_event)
+            return false;
+    }
+
+    LibEventHttpdWaiter *w = new LibEventHttpdWaiter;
+    w->req = req;
+    w->events_req = r;
+    w->deadline = get_time_ms() + (r->timeout < events_timeout_max ? r->timeout : events_timeout_max);
+    waiters.push_back(w);
+    set_waiters_timer();
+    return true;
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::set_waiters_timer()
+{
+    if (waiters.empty())
+    {
+        event_del(waiters_event);
+        return;
+    }
+
+    // Next deadline
+    size_t deadline = waiters.front()->deadline;
+    std::list<LibEventHttpdWaiter*>::iterator it = waiters.begin();
+    for (; it != waiters.end(); ++it)
+        if ((*it)->deadline < deadline)
+            deadline = (*it)->deadline;
+
+    size_t now = get_time_ms();
+    size_t delay = deadline > now ? deadline - now : 0;
+    struct timeval interval = {(long)(delay / 1000), (long)(delay % 1000) * 1000};
+    event_add(waiters_event, &interval);
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::waiters_timer_coming(evutil_socket_t, short, void *arg)
+{
+    LibEventHttpd *evHttp = (LibEventHttpd*)arg;
+    evHttp->send_waiters_events();
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::send_waiters_events()
+{
+    size_t now = get_time_ms();
+
+    std::list<LibEventHttpdWaiter*>::iterator it = waiters.begin();
+    while (it != waiters.end())
+    {
+        LibEventHttpdWaiter *w = *it;
+
+        RESTAPI::Checker_Events_Res res;
+        int ret = commands.checker_events_cb(w->events_req, res, parent);
+        if (ret >= 0 && !res.nok && !res.events_lost && res.finished.empty() && now < w->deadline)
+        {
+            ++it;
+            continue;
+        }
+
+        int code = HTTP_OK;
+        std::string ret_msg("OK");
+        error.clear();
+        result.clear();
+        if (ret < 0)
+        {
+            ret_msg = "NOVALIDCONTENT";
+            code = HTTP_BADREQUEST;
+        }
+        else if (rest.serialize_checker_events_res(res, result, error) < 0)
+            error = rest.get_error();
+
+        send_result(code, ret_msg, w->req);
+        result.clear();
+
+        delete w->events_req;
+        delete w;
+        it = waiters.erase(it);
+    }
+
+    set_waiters_timer();
+}
+
+//---------------------------------------------------------------------------
+void LibEventHttpd::free_waiters()
+{
+    // The requests not answered are freed with the connections
+    std::list<LibEventHttpdWaiter*>::iterator it = waiters.begin();
+    for (; it != waiters.end(); ++it)
+    {
+        delete (*it)->events_req;
+        delete *it;
+    }
+    waiters.clear();
+
+    if (waiters_event)
+    {
+        event_free(waiters_event);
+        waiters_event = NULL;
+    }
+}
+
+//---------------------------------------------------------------------------
+size_t LibEventHttpd::get_time_ms()
+{
+    struct timeval now;
+    evutil_gettimeofday(&now, NULL);
+    return (size_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+//---------------------------------------------------------------------------
 int LibEventHttpd::get_mediaconch_instance(const struct evkeyvalq *headers)
 {
     if (!headers)
@@ -1256,31 +2042,57 @@ int LibEventHttpd::get_mediaconch_instance(const struct evkeyvalq *headers)
 
 //---------------------------------------------------------------------------
 int LibEventHttpd::get_body(struct evhttp_request *req, std::string& json, std::string& ret_msg)
+{
+    int ret;
+    if (job)
+    {
+        // Already read by the server thread
+        ret = job->has_body ? 0 : -1;
+        if (!ret)
+            json.swap(job->body);
+        else
+            ret_msg = job->ret_msg;
+    }
+    else
+        ret = read_body(req, json, ret_msg);
+
+    if (ret < 0)
+    {
+        error = std::string("body of the request should contain the command");
+        send_result(HTTP_BADREQUEST, ret_msg, req);
+        return -1;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int LibEventHttpd::read_body(struct evhttp_request *req, std::string& json, std::string& ret_msg)
 {
     struct evbuffer *evBuf = evhttp_request_get_input_buffer(req);
     if (!evBuf)
     {
-        error = std::string("body of the request should contain the command");
         ret_msg = "NOCONTENT";
-        send_result(HTTP_BADREQUEST, ret_msg, req);
         return -1;
     }
 
-    int len = evbuffer_get_length(evBuf);
-    char* tmpBuf = new char[len + 1];
-    int n = evbuffer_remove(evBuf, tmpBuf, len);
-    if (n <= 0)
+    // Copied once from the chains of the buffer
+    size_t len = evbuffer_get_length(evBuf);
+    if (!len)
     {
-        delete[] tmpBuf;
-        error = std::string("body of the request should contain the command");
         ret_msg = "NOVALIDCONTENT";
-        send_result(HTTP_BADREQUEST, ret_msg, req);
         return -1;
     }
-    tmpBuf[n] = '\0';
 
-    json = std::string(tmpBuf);
-    delete[] tmpBuf;
+    json.resize(len);
+    ev_ssize_t n = evbuffer_remove(evBuf, &json[0], len);
+    if (n <= 0)
+    {
+        json.clear();
+        ret_msg = "NOVALIDCONTENT";
+        return -1;
+    }
+    json.resize((size_t)n);
 
     return 0;
 }
@@ -18,7 +18,11 @@
 #define LibEventHttpdH
 
 #include "Httpd.h"
+#include "Condition.h"
+#include "ZenLib/Thread.h"
 #include <string>
+#include <list>
+#include <vector>
 
 #include <event2/event.h>
 #include <event2/http.h>
@@ -30,6 +34,87 @@ namespace MediaConch
 {
 
 class MediaConchLib;
+class LibEventHttpd;
+
+//***************************************************************************
+// Struct LibEventHttpdJob
+//***************************************************************************
+
+// Request handled by a worker, the reply is sent by the server thread
+struct LibEventHttpdJob
+{
+    LibEventHttpdJob() : req(NULL), exclusive(false), has_body(false), code(HTTP_OK), ret_msg("OK"),
+                         result_buffer(NULL) {}
+    ~LibEventHttpdJob() { if (result_buffer) evbuffer_free(result_buffer); }
+
+    struct evhttp_request *req;
+    std::string            endpoint;
+    bool                   exclusive;
+    bool                   has_body;
+    std::string            body;
+
+    int                    code;
+    std::string            ret_msg;
+    std::string            error;
+    std::string            result;
+    struct evbuffer       *result_buffer;
+    std::vector<std::pair<std::string, std::string> > result_headers;
+};
+
+//***************************************************************************
+// Class LibEventHttpdJsonWriter
+//***************************************************************************
+
+// Reply written in the buffer sent, the large strings are escaped in its chains
+class LibEventHttpdJsonWriter : public JsonWriter
+{
+public:
+    LibEventHttpdJsonWriter(struct evbuffer *b) : buffer(b) {}
+
+protected:
+    void  write(const char* data, size_t len);
+    char *reserve(size_t size, size_t& available);
+    void  commit(size_t size);
+
+private:
+    struct evbuffer       *buffer;
+    struct evbuffer_iovec  extent;
+};
+
+//***************************************************************************
+// Struct LibEventHttpdWaiter
+//***************************************************************************
+
+// Request of events kept until an analysis is finished or the timeout expired
+struct LibEventHttpdWaiter
+{
+    LibEventHttpdWaiter() : req(NULL), events_req(NULL), deadline(0) {}
+
+    struct evhttp_request        *req;
+    RESTAPI::Checker_Events_Req  *events_req;
+    size_t                        deadline;
+};
+
+//***************************************************************************
+// Class LibEventHttpdWorker
+//***************************************************************************
+
+class LibEventHttpdWorker : public ZenLib::Thread
+{
+public:
+    LibEventHttpdWorker(LibEventHttpd *h);
+    ~LibEventHttpdWorker();
+
+    void Entry();
+
+private:
+    LibEventHttpdWorker(const LibEventHttpdWorker&);
+    LibEventHttpdWorker& operator=(const LibEventHttpdWorker&);
+
+    LibEventHttpd *httpd;
+    // Own parser and result of the requests
+    LibEventHttpd *handler;
+};
 
 //***************************************************************************
 // Class LibEventHttpd
@@ -48,22 +133,71 @@ public:
     int finish();
 
     virtual int send_result(int ret_code, const std::string& ret_msg, void *arg);
+    virtual void analyze_finished();
 
 private:
+    friend class LibEventHttpdWorker;
+
     struct event_base          *base;
     struct evhttp              *http;
     struct evhttp_bound_socket *handle;
 
     static int                  pid;
 
+    // Workers, the lists and the counters are protected by jobs_cond
+    std::vector<LibEventHttpdWorker*> workers;
+    std::list<LibEventHttpdJob*>      jobs_pending;
+    std::vector<LibEventHttpdJob*>    jobs_done;
+    std::map<std::string, size_t>     endpoint_running;
+    size_t                            jobs_running;
+    bool                              exclusive_running;
+    // Workers not out of worker_loop
+    size_t                            workers_running;
+    bool                              stopping;
+    Condition                         jobs_cond;
+    // Wakes up the server thread when jobs or analyses are done, protected by jobs_cond
+    evutil_socket_t                   jobs_notify[2];
+    struct event                     *jobs_event;
+    // Job run by the handler of a worker
+    LibEventHttpdJob                 *job;
+    // Reply already serialized in a buffer, sent instead of the result
+    struct evbuffer                  *result_buffer;
+    // Headers of a raw reply, the buffer is not JSON
+    std::vector<std::pair<std::string, std::string> > result_headers;
+    // Requests of events waiting, checked on the server thread when an analysis is finished
+    // The timer answers them at the deadline
+    std::list<LibEventHttpdWaiter*>   waiters;
+    struct event                     *waiters_event;
+
     static void request_coming(struct evhttp_request *req, void *arg);
+    static void jobs_done_coming(evutil_socket_t fd, short what, void *arg);
+    static void waiters_timer_coming(evutil_socket_t fd, short what, void *arg);
+    void handle_request(struct evhttp_request *req);
+    int  start_notification(std::string& err);
+    void stop_notification();
+    int  start_workers(std::string& err);
+    void stop_workers();
+    bool dispatch_request(struct evhttp_request *req);
+    LibEventHttpdJob* next_job();
+    void worker_loop(LibEventHttpd *handler);
+    bool wait_events(struct evhttp_request *req, RESTAPI::Checker_Events_Req *r);
+    void send_waiters_events();
+    void set_waiters_timer();
+    void free_waiters();
+    static size_t get_time_ms();
     int get_body(struct evhttp_request *req, std::string& json, std::string& ret_msg);
+    int read_body(struct evhttp_request *req, std::string& json, std::string& ret_msg);
     void request_get_coming(struct evhttp_request *req, std::string& err);
     void request_post_coming(struct evhttp_request *req, std::string& err);
     void request_put_coming(struct evhttp_request *req, std::string& err);
     void request_delete_coming(struct evhttp_request *req, std::string& err);
     int  uri_api_version_is_valid(std::string& uri, struct evhttp_request *req);
     int  get_mediaconch_instance(const struct evkeyvalq *headers);
+    int  set_raw_result(const RESTAPI::Checker_Report_Raw_Req *r, RESTAPI::Checker_Report_Raw_Res& res,
+                        std::string& ret_msg);
+    static bool accepts_encoding(const char *accept_encoding, const std::string& coding);
+    static int  parse_range(const std::string& range, size_t total, size_t& first, size_t& last);
+    static void free_raw_result(const void *data, size_t len, void *arg);
 
     LibEventHttpd (const LibEventHttpd&);
     LibEventHttpd& operator=(const LibEventHttpd&);
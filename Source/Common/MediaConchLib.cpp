@@ -10,6 +10,7 @@
 #endif
 
 //---------------------------------------------------------------------------
+#include <set>
 #include <ZenLib/Dir.h>
 #include <ZenLib/Ztring.h>
 #include <ZenLib/ZtringList.h>
@@ -27,6 +28,12 @@
 #include "generated/PolicySample7.h"
 #include "generated/PolicySample8.h"
 
+#if defined(WINDOWS)
+    #include <windows.h>
+#else
+    #include <unistd.h>
+#endif //defined(WINDOWS)
+
 namespace MediaConch {
 
 //***************************************************************************
@@ -265,14 +272,61 @@ int MediaConchLib::checker_analyze(int user, const std::vector<std::string>& fil
                                    const std::vector<std::pair<std::string,std::string> >& options,
                                    std::vector<long>& files_id, std::string& error, bool force_analyze, bool mil_analyze)
 {
-    bool registered = false;
+    std::vector<bool> registered;
+    std::vector<std::string> files_error;
+    int ret = checker_analyze(user, files, plugins, options, files_id, registered, files_error, error,
+                              force_analyze, mil_analyze);
+    if (ret < 0)
+        return ret;
+
+    // The error of the first file not registered is given
+    for (size_t i = 0; i < files_error.size(); ++i)
+        if (files_id[i] < 0)
+        {
+            error = files_error[i];
+            return -1;
+        }
+
+    return errorHttp_NONE;
+}
+
+//---------------------------------------------------------------------------
+int MediaConchLib::checker_analyze(int user, const std::vector<std::string>& files,
+                                   const std::vector<std::string>& plugins,
+                                   const std::vector<std::pair<std::string,std::string> >& options,
+                                   std::vector<long>& files_id, std::vector<bool>& registered,
+                                   std::vector<std::string>& files_error, std::string& error,
+                                   bool force_analyze, bool mil_analyze)
+{
     for (size_t i = 0; i < files.size(); ++i)
+        if (!files[i].length())
+            return errorHttp_INVALID_DATA;
+
+    // Few requests for all the files
+    if (use_daemon)
     {
-        long file_id;
-        int ret = checker_analyze(user, files[i], plugins, options, registered, file_id, error, force_analyze, mil_analyze);
-        if (ret < 0)
-            return ret;
+        if (daemon_client->checker_analyze(user, files, plugins, options, force_analyze, mil_analyze,
+                                           files_id, registered, files_error, error) < 0)
+            return -1;
+        return errorHttp_NONE;
+    }
+
+    // A file not registered keeps the id -1 with its error, the others are still registered
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        bool file_registered = false;
+        long file_id = -1;
+        std::string file_error;
+        if (checker_analyze(user, files[i], plugins, options, file_registered, file_id, file_error,
+                            force_analyze, mil_analyze) < 0)
+        {
+            file_id = -1;
+            if (file_error.empty())
+                file_error = "Internal error during analyze.";
+        }
         files_id.push_back(file_id);
+        registered.push_back(file_registered);
+        files_error.push_back(file_error);
     }
 
     return errorHttp_NONE;
@@ -303,6 +357,28 @@ int MediaConchLib::checker_status(int user, const std::vector<long>& files_id, s
 {
     int done = errorHttp_TRUE;
 
+    if (use_daemon)
+    {
+        // Few requests for all the ids, the invalid ones are not sent
+        std::vector<long> ids;
+        for (size_t i = 0; i < files_id.size(); ++i)
+            if (files_id[i] >= 0)
+                ids.push_back(files_id[i]);
+
+        std::vector<Checker_StatusRes> ids_res;
+        if (daemon_client->checker_status(user, ids, ids_res, error) < 0)
+            return -1;
+
+        for (size_t i = 0, j = 0; i < files_id.size(); ++i)
+        {
+            if (files_id[i] < 0)
+                res.push_back(Checker_StatusRes());
+            else
+                res.push_back(ids_res[j++]);
+        }
+        return done;
+    }
+
     for (size_t i = 0; i < files_id.size(); ++i)
     {
         Checker_StatusRes r;
@@ -328,6 +404,103 @@ int MediaConchLib::checker_status(int user, long file_id, Checker_StatusRes& res
     return core->checker_status(user, file_id, res, error);
 }
 
+//---------------------------------------------------------------------------
+int MediaConchLib::checker_wait_finished(int user, const std::vector<long>& files_id, std::vector<long>& finished,
+                                         std::string& error, size_t timeout, long* last_event)
+{
+    if (!use_daemon)
+        return core->checker_wait_finished(user, files_id, finished, error, timeout);
+
+    // Resume after the last event seen, or subscribe before the status so a file finished in between is seen
+    Checker_EventsRes events;
+    bool resume = last_event && *last_event >= 0;
+    if (resume)
+        events.last_event = *last_event;
+    if (resume || daemon_client->checker_events(user, -1, 0, events, error) >= 0)
+    {
+        std::set<long> pending(files_id.begin(), files_id.end());
+        std::vector<long> to_check;
+        if (!resume)
+            to_check = files_id;
+
+        for (size_t waited = 0; ; )
+        {
+            if (to_check.size())
+            {
+                std::vector<Checker_StatusRes> res;
+                if (checker_status(user, to_check, res, error) < 0)
+                    return -1;
+
+                for (size_t i = 0; i < to_check.size(); ++i)
+                    if (res[i].finished)
+                        finished.push_back(to_check[i]);
+            }
+
+            if (finished.size() || pending.empty())
+                break;
+
+            // Only the files the daemon reports finished are checked, all of them if events were lost
+            to_check.clear();
+            while (!to_check.size() && waited < timeout)
+            {
+                size_t wait = timeout - waited < 30000 ? timeout - waited : 30000;
+                if (daemon_client->checker_events(user, events.last_event, wait, events, error) < 0)
+                    return -1;
+
+                if (events.events_lost)
+                    to_check = files_id;
+                else
+                    for (size_t i = 0; i < events.finished.size(); ++i)
+                        if (pending.find(events.finished[i]) != pending.end())
+                            to_check.push_back(events.finished[i]);
+
+                if (!events.finished.size() && !events.events_lost)
+                    waited += wait;
+            }
+
+            if (!to_check.size())
+                break;
+        }
+
+        if (last_event)
+            *last_event = events.last_event;
+        return 0;
+    }
+
+    // Daemon without events, poll the whole batch
+    for (size_t waited = 0; ; waited += 500)
+    {
+        std::vector<Checker_StatusRes> res;
+        if (checker_status(user, files_id, res, error) < 0)
+            return -1;
+
+        for (size_t i = 0; i < files_id.size(); ++i)
+            if (res[i].finished)
+                finished.push_back(files_id[i]);
+
+        if (finished.size() || !files_id.size() || waited >= timeout)
+            break;
+
+#ifdef WINDOWS
+        ::Sleep((DWORD)500);
+#else
+        usleep(500000);
+#endif
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int MediaConchLib::checker_events(int user, long last_event, size_t timeout, Checker_EventsRes& res,
+                                  std::string& error)
+{
+    if (use_daemon)
+        return daemon_client->checker_events(user, last_event, timeout, res, error);
+
+    return core->checker_events(user, last_event, timeout, res, error);
+}
+
 //---------------------------------------------------------------------------
 int MediaConchLib::checker_list(int user, std::vector<std::string>& vec, std::string& error)
 {
@@ -394,6 +567,34 @@ int MediaConchLib::checker_get_report(CheckerReport& c_report, Checker_ReportRes
     return core->reports.checker_get_report(c_report, result, error);
 }
 
+//---------------------------------------------------------------------------
+int MediaConchLib::checker_get_report_raw(int user, long id, report kind, bool accept_compressed,
+                                          Checker_ReportRawRes& result, std::string& error,
+                                          size_t offset, size_t length)
+{
+    if (use_daemon)
+        return daemon_client->checker_get_report_raw(user, id, kind, accept_compressed, offset, length, result, error);
+
+    if (core->checker_get_report_raw(user, id, kind, accept_compressed, result.report, result.compress,
+                                     result.uncompressed_size, error) < 0)
+        return -1;
+
+    result.offset = 0;
+    result.total_size = result.report.size();
+    if (!offset && !length)
+        return 0;
+
+    if (offset >= result.total_size)
+    {
+        error = "Range not satisfiable";
+        return -1;
+    }
+
+    result.offset = offset;
+    result.report = result.report.substr(offset, length ? length : std::string::npos);
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int MediaConchLib::checker_validate(int user, report report, const std::vector<long>& files,
                                     const std::vector<size_t>& policies_ids,
@@ -835,6 +1036,18 @@ void MediaConchLib::get_daemon_address(std::string& addr, int& port) const
     core->get_daemon_address(addr, port);
 }
 
+//---------------------------------------------------------------------------
+void MediaConchLib::get_daemon_workers(size_t& workers, std::map<std::string, size_t>& limits) const
+{
+    core->get_daemon_workers(workers, limits);
+}
+
+//---------------------------------------------------------------------------
+void MediaConchLib::get_daemon_max_body_size(size_t& size) const
+{
+    core->get_daemon_max_body_size(size);
+}
+
 //***************************************************************************
 // Helper
 //***************************************************************************
@@ -917,4 +1130,11 @@ void MediaConchLib::register_log_callback(void (*log)(struct MediaInfo_Event_Log
     core->ecb.log = log;
 }
 
+//---------------------------------------------------------------------------
+void MediaConchLib::register_analyze_finished_callback(void (*analyze_finished)(void* arg), void* arg)
+{
+    core->ecb.analyze_finished_arg = arg;
+    core->ecb.analyze_finished = analyze_finished;
+}
+
 }
@@ -88,6 +88,8 @@ public:
     {
         compression_None = 0,
         compression_ZLib,
+        compression_ZStd,
+        compression_LZ4,
         compression_Max,
     };
 
@@ -114,12 +116,34 @@ public:
     struct Checker_StatusRes
     {
         Checker_StatusRes() : id(-1), finished(false), has_error(false), percent(NULL), tool(NULL), source_id(-1) {}
+        Checker_StatusRes(const Checker_StatusRes& s) : percent(NULL), tool(NULL)
+        {
+            *this = s;
+        }
         ~Checker_StatusRes()
         {
             delete percent;
             delete tool;
         }
 
+        Checker_StatusRes& operator=(const Checker_StatusRes& s)
+        {
+            if (this == &s)
+                return *this;
+
+            id = s.id;
+            finished = s.finished;
+            has_error = s.has_error;
+            error_log = s.error_log;
+            delete percent;
+            percent = s.percent ? new double(*s.percent) : NULL;
+            delete tool;
+            tool = s.tool ? new int(*s.tool) : NULL;
+            generated_id = s.generated_id;
+            source_id = s.source_id;
+            return *this;
+        }
+
         long               id;
         bool               finished;
 
@@ -133,6 +157,16 @@ public:
         long               source_id;
     };
 
+    struct Checker_EventsRes
+    {
+        Checker_EventsRes() : last_event(-1), events_lost(false) {}
+
+        long                                 last_event;
+        bool                                 events_lost;
+        std::vector<long>                    finished;
+        std::vector<std::pair<long, double> > progress;
+    };
+
     struct Checker_ReportRes
     {
         std::string           report;
@@ -141,6 +175,19 @@ public:
         Checker_ReportRes() : has_valid(false), valid(true) {}
     };
 
+    struct Checker_ReportRawRes
+    {
+        Checker_ReportRawRes() : compress(compression_None), uncompressed_size(0), offset(0), total_size(0) {}
+
+        // compression_ZLib when the report is given as stored, to be uncompressed by the caller
+        std::string           report;
+        compression           compress;
+        size_t                uncompressed_size;
+        // Part given, in the bytes of the report compressed or not
+        size_t                offset;
+        size_t                total_size;
+    };
+
     struct Checker_ValidateRes
     {
         long                    id;
@@ -298,6 +345,13 @@ public:
                          const std::vector<std::pair<std::string,std::string> >& options,
                          std::vector<long>& files_id, std::string& error, bool force_analyze = false,
                          bool mil_analyze = true);
+    // A file not registered has the id -1 and its own error in files_error
+    int  checker_analyze(int user, const std::vector<std::string>& files,
+                         const std::vector<std::string>& plugins,
+                         const std::vector<std::pair<std::string,std::string> >& options,
+                         std::vector<long>& files_id, std::vector<bool>& registered,
+                         std::vector<std::string>& files_error, std::string& error,
+                         bool force_analyze = false, bool mil_analyze = true);
     int  checker_analyze(int user, const std::string& file, const std::vector<std::string>& plugins,
                          const std::vector<std::pair<std::string,std::string> >& options,
                          bool& registered, long& file_id, std::string& error, bool force_analyze = false,
@@ -307,6 +361,12 @@ public:
     int  checker_status(int user, const std::vector<long>& files_id,
                         std::vector<Checker_StatusRes>& res, std::string& error);
     int  checker_status(int user, long file_id, Checker_StatusRes& res, std::string& error);
+    // Block until at least one of the files is finished or the timeout (in ms) expired
+    // With the daemon, last_event (-1 at first) is updated so the next wait only checks the files reported finished
+    int  checker_wait_finished(int user, const std::vector<long>& files_id, std::vector<long>& finished,
+                               std::string& error, size_t timeout=(size_t)-1, long* last_event=NULL);
+    // Files finished after last_event (-1 to subscribe), block until one is finished or the timeout (in ms) expired
+    int  checker_events(int user, long last_event, size_t timeout, Checker_EventsRes& res, std::string& error);
 
     int  checker_list(int user, std::vector<std::string>& vec, std::string& error);
     int  checker_list(int user, std::vector<long>& vec, std::string& error);
@@ -317,6 +377,10 @@ public:
 
     // Output
     int  checker_get_report(CheckerReport& c_report, Checker_ReportRes* result, std::string& error);
+    // Report saved (MediaInfo, MicroMediaTrace, VeraPDF or DPFManager), kept compressed with zlib when accepted,
+    // a part is given when length is not 0
+    int  checker_get_report_raw(int user, long id, report kind, bool accept_compressed, Checker_ReportRawRes& result,
+                                std::string& error, size_t offset=0, size_t length=0);
     int  checker_validate(int user, MediaConchLib::report report, const std::vector<long>& files,
                           const std::vector<size_t>& policies_ids,
                           const std::vector<std::string>& policies_contents,
@@ -393,6 +457,8 @@ public:
     void set_use_daemon(bool use);
     bool get_use_daemon() const;
     void get_daemon_address(std::string& addr, int& port) const;
+    void get_daemon_workers(size_t& workers, std::map<std::string, size_t>& limits) const;
+    void get_daemon_max_body_size(size_t& size) const;
 
     // Helper
     int init_http_client();
@@ -402,6 +468,7 @@ public:
 
     // Register Event callback
     void register_log_callback(void (*log)(struct MediaInfo_Event_Log_0* Event));
+    void register_analyze_finished_callback(void (*analyze_finished)(void* arg), void* arg);
 
 private:
     MediaConchLib (const MediaConchLib&);
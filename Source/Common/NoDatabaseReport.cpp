@@ -34,13 +34,8 @@ NoDatabaseReport::NoDatabaseReport() : DatabaseReport()
 //---------------------------------------------------------------------------
 NoDatabaseReport::~NoDatabaseReport()
 {
-    std::map<long, std::vector<MC_Report*> >::iterator it_r = reports_saved.begin();
-    for (; it_r != reports_saved.end(); ++it_r)
-    {
-        for (size_t i = 0; i < it_r->second.size(); ++i)
-            delete it_r->second[i];
-    }
-    reports_saved.clear();
+    while (!reports_saved.empty())
+        delete_reports(reports_saved.begin()->first);
 
     for (size_t i = 0; i < files_saved.size(); ++i)
     {
@@ -81,19 +76,105 @@ int NoDatabaseReport::update_report_table()
 }
 
 //---------------------------------------------------------------------------
-void NoDatabaseReport::get_users_id(std::vector<long>& ids, std::string&)
+bool NoDatabaseReport::MC_FileKey::operator<(const MC_FileKey& k) const
 {
-    std::map<long, bool> tmp;
-    for (size_t i = 0; i < files_saved.size(); ++i)
+    if (user != k.user)
+        return user < k.user;
+    int cmp = filename.compare(k.filename);
+    if (cmp)
+        return cmp < 0;
+    return options < k.options;
+}
+
+//---------------------------------------------------------------------------
+bool NoDatabaseReport::MC_ReportKey::operator<(const MC_ReportKey& k) const
+{
+    if (reportKind != k.reportKind)
+        return reportKind < k.reportKind;
+    if (format != k.format)
+        return format < k.format;
+    return options < k.options;
+}
+
+//---------------------------------------------------------------------------
+bool NoDatabaseReport::file_match_user(int user, long id) const
+{
+    return id >= 0 && id < (long)files_saved.size() && files_saved[id] && files_saved[id]->user == user;
+}
+
+//---------------------------------------------------------------------------
+void NoDatabaseReport::index_file(long id)
+{
+    MC_File* f = files_saved[id];
+
+    // Ids are increasing, the vectors stay sorted
+    files_index[MC_FileKey(f->user, f->filename, f->options)].push_back(id);
+    users_files[f->user].insert(id);
+}
+
+//---------------------------------------------------------------------------
+void NoDatabaseReport::unindex_file(long id)
+{
+    MC_File* f = files_saved[id];
+
+    std::map<MC_FileKey, std::vector<long> >::iterator it = files_index.find(MC_FileKey(f->user, f->filename, f->options));
+    if (it != files_index.end())
     {
-        if (!files_saved[i])
-            continue;
+        for (size_t i = 0; i < it->second.size(); ++i)
+        {
+            if (it->second[i] != id)
+                continue;
 
-        tmp[files_saved[i]->user] = true;
+            it->second.erase(it->second.begin() + i);
+            break;
+        }
+        if (it->second.empty())
+            files_index.erase(it);
     }
 
-    std::map<long, bool>::iterator it = tmp.begin();
-    for (; it != tmp.end(); ++it)
+    std::map<int, std::set<long> >::iterator it_u = users_files.find(f->user);
+    if (it_u != users_files.end())
+    {
+        it_u->second.erase(id);
+        if (it_u->second.empty())
+            users_files.erase(it_u);
+    }
+
+    std::map<std::string, std::set<long> >::iterator it_f = fingerprints_index.find(f->fingerprint);
+    if (it_f != fingerprints_index.end())
+    {
+        it_f->second.erase(id);
+        if (it_f->second.empty())
+            fingerprints_index.erase(it_f);
+    }
+}
+
+//---------------------------------------------------------------------------
+void NoDatabaseReport::delete_file(long id)
+{
+    unindex_file(id);
+    delete files_saved[id];
+    files_saved[id] = NULL;
+}
+
+//---------------------------------------------------------------------------
+void NoDatabaseReport::delete_reports(long id)
+{
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::iterator it = reports_saved.find(id);
+    if (it == reports_saved.end())
+        return;
+
+    std::map<MC_ReportKey, MC_Report*>::iterator it_r = it->second.begin();
+    for (; it_r != it->second.end(); ++it_r)
+        delete it_r->second;
+    reports_saved.erase(it);
+}
+
+//---------------------------------------------------------------------------
+void NoDatabaseReport::get_users_id(std::vector<long>& ids, std::string&)
+{
+    std::map<int, std::set<long> >::iterator it = users_files.begin();
+    for (; it != users_files.end(); ++it)
         ids.push_back(it->first);
 }
 
@@ -119,6 +200,7 @@ long NoDatabaseReport::add_file(int user, const std::string& filename, const std
 
     long id = (long)files_saved.size();
     files_saved.push_back(f);
+    index_file(id);
     return id;
 }
 
@@ -128,7 +210,7 @@ long NoDatabaseReport::update_file(int user, long file_id, const std::string& fi
                                    long source_id, size_t generated_time,
                                    const std::string& generated_log, const std::string& generated_error_log)
 {
-    if (file_id < 0 || file_id >= (long)files_saved.size() || files_saved[file_id]->user != user || files_saved[file_id]->options != options)
+    if (!file_match_user(user, file_id) || files_saved[file_id]->options != options)
         return -1;
 
     MC_File* f = files_saved[file_id];
@@ -152,11 +234,16 @@ long NoDatabaseReport::update_file(int user, long file_id, const std::string& fi
 long NoDatabaseReport::get_file_id(int user, const std::string& file, const std::string& file_last_modification,
                                    const std::string& options, std::string& err)
 {
-    for (long id = 0; id < (long)files_saved.size(); ++id)
-        if (files_saved[id] && file == files_saved[id]->filename &&
-            (!file_last_modification.size() || file_last_modification == files_saved[id]->file_last_modification) &&
-            files_saved[id]->user == user && files_saved[id]->options == options)
-            return id;
+    std::map<MC_FileKey, std::vector<long> >::iterator it = files_index.find(MC_FileKey(user, file, options));
+    if (it != files_index.end())
+    {
+        for (size_t i = 0; i < it->second.size(); ++i)
+        {
+            long id = it->second[i];
+            if (!file_last_modification.size() || file_last_modification == files_saved[id]->file_last_modification)
+                return id;
+        }
+    }
 
     err = "File not found";
     return -1;
@@ -165,8 +252,7 @@ long NoDatabaseReport::get_file_id(int user, const std::string& file, const std:
 //---------------------------------------------------------------------------
 int NoDatabaseReport::get_file_name_from_id(int user, long id, std::string& file, std::string& err)
 {
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
     {
         file = files_saved[id]->filename;
         return 0;
@@ -184,8 +270,7 @@ int NoDatabaseReport::get_file_information_from_id(int user, long id, std::strin
                                                    std::string& options, bool& analyzed,
                                                    bool& has_error, std::string& error_log, std::string& err)
 {
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
     {
         filename = files_saved[id]->filename;
         file_last_modification = files_saved[id]->file_last_modification;
@@ -224,8 +309,7 @@ int NoDatabaseReport::get_file_information_from_id(int user, long id, std::strin
 bool NoDatabaseReport::file_is_analyzed(int user, long id, std::string& err)
 {
     err = std::string();
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
     {
         if (reports_saved.find(id) != reports_saved.end())
             return true;
@@ -241,11 +325,9 @@ bool NoDatabaseReport::file_is_analyzed(int user, long id, std::string& err)
 int NoDatabaseReport::remove_file(int user, long id, std::string& err)
 {
     err = std::string();
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
     {
-        delete files_saved[id];
-        files_saved[id] = NULL;
+        delete_file(id);
         return 0;
     }
 
@@ -257,20 +339,10 @@ int NoDatabaseReport::remove_file(int user, long id, std::string& err)
 int NoDatabaseReport::reset_file(int user, long id, std::string& err)
 {
     err = std::string();
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
         files_saved[id]->analyzed = false;
 
-    std::map<long, std::vector<MC_Report*> >::iterator it = reports_saved.find(id);
-    if (it != reports_saved.end())
-    {
-        for (size_t i = 0; i < reports_saved[id].size(); ++i)
-        {
-            if (reports_saved[id][i])
-                delete reports_saved[id][i];
-        }
-        reports_saved[id].clear();
-    }
+    delete_reports(id);
 
     return 0;
 }
@@ -279,14 +351,14 @@ int NoDatabaseReport::reset_file(int user, long id, std::string& err)
 int NoDatabaseReport::remove_all_files(int user, std::string& err)
 {
     err = std::string();
-    for (size_t id = 0; id < files_saved.size(); ++id)
-    {
-        if (!files_saved[id] || files_saved[id]->user != user)
-            continue;
+    std::map<int, std::set<long> >::iterator it = users_files.find(user);
+    if (it == users_files.end())
+        return 0;
 
-        delete files_saved[id];
-        files_saved[id] = NULL;
-    }
+    // The set is updated while the files are removed
+    std::vector<long> ids(it->second.begin(), it->second.end());
+    for (size_t i = 0; i < ids.size(); ++i)
+        delete_file(ids[i]);
 
     return 0;
 }
@@ -294,8 +366,7 @@ int NoDatabaseReport::remove_all_files(int user, std::string& err)
 //---------------------------------------------------------------------------
 int NoDatabaseReport::add_file_generated_id(int user, long source_id, long generated_id, std::string& err)
 {
-    if (source_id >= 0 && source_id < (long)files_saved.size() && files_saved[source_id] &&
-        files_saved[source_id]->user == user)
+    if (file_match_user(user, source_id))
     {
         files_saved[source_id]->generated_id.push_back(generated_id);
         return 0;
@@ -308,8 +379,7 @@ int NoDatabaseReport::add_file_generated_id(int user, long source_id, long gener
 //---------------------------------------------------------------------------
 int NoDatabaseReport::update_file_analyzed(int user, long id, std::string& err, bool analyzed)
 {
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
     {
         files_saved[id]->analyzed = analyzed;
         return 0;
@@ -322,8 +392,7 @@ int NoDatabaseReport::update_file_analyzed(int user, long id, std::string& err,
 //---------------------------------------------------------------------------
 int NoDatabaseReport::update_file_error(int user, long id, std::string& err, bool has_error, const std::string& error_log)
 {
-    if (id >= 0 && id < (long)files_saved.size() && files_saved[id] &&
-        files_saved[id]->user == user)
+    if (file_match_user(user, id))
     {
         files_saved[id]->has_error = has_error;
         files_saved[id]->error_log = error_log;
@@ -334,14 +403,128 @@ int NoDatabaseReport::update_file_error(int user, long id, std::string& err, boo
     return -1;
 }
 
+//---------------------------------------------------------------------------
+int NoDatabaseReport::update_file_fingerprint(int user, long id, const std::string& fingerprint, std::string& err)
+{
+    if (!file_match_user(user, id))
+    {
+        err = "File not found";
+        return -1;
+    }
+
+    MC_File* f = files_saved[id];
+    if (f->fingerprint.size())
+    {
+        std::map<std::string, std::set<long> >::iterator it = fingerprints_index.find(f->fingerprint);
+        if (it != fingerprints_index.end())
+        {
+            it->second.erase(id);
+            if (it->second.empty())
+                fingerprints_index.erase(it);
+        }
+    }
+
+    f->fingerprint = fingerprint;
+    if (fingerprint.size())
+        fingerprints_index[fingerprint].insert(id);
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::update_file_full_fingerprint(int user, long id, const std::string& fingerprint, std::string& err)
+{
+    if (!file_match_user(user, id))
+    {
+        err = "File not found";
+        return -1;
+    }
+
+    files_saved[id]->full_fingerprint = fingerprint;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::get_file_full_fingerprint(int user, long id, std::string& fingerprint, std::string& err)
+{
+    if (!file_match_user(user, id))
+    {
+        err = "File not found";
+        return -1;
+    }
+
+    fingerprint = files_saved[id]->full_fingerprint;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+long NoDatabaseReport::get_file_id_from_fingerprint(const std::string& fingerprint, const std::string& options,
+                                                    long exclude_id, int& user, std::string&)
+{
+    std::map<std::string, std::set<long> >::iterator it = fingerprints_index.find(fingerprint);
+    if (it == fingerprints_index.end())
+        return -1;
+
+    std::set<long>::iterator it_id = it->second.begin();
+    for (; it_id != it->second.end(); ++it_id)
+    {
+        MC_File* f = files_saved[*it_id];
+        if (*it_id == exclude_id || f->options != options || !f->analyzed || f->has_error ||
+            f->source_id != -1 || f->generated_id.size() || has_plugin_report(*it_id))
+            continue;
+
+        user = f->user;
+        return *it_id;
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+bool NoDatabaseReport::has_plugin_report(long id) const
+{
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::const_iterator it = reports_saved.find(id);
+    if (it == reports_saved.end())
+        return false;
+
+    std::map<MC_ReportKey, MC_Report*>::const_iterator it_r = it->second.begin();
+    for (; it_r != it->second.end(); ++it_r)
+        if (it_r->first.reportKind == MediaConchLib::report_MediaVeraPdf ||
+            it_r->first.reportKind == MediaConchLib::report_MediaDpfManager)
+            return true;
+    return false;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::copy_reports(int src_user, long src_id, int user, long id, std::string& err)
+{
+    if (!file_match_user(src_user, src_id) || !file_match_user(user, id))
+    {
+        err = "File not found";
+        return -1;
+    }
+
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::iterator it = reports_saved.find(src_id);
+    if (it == reports_saved.end())
+        return 0;
+
+    std::map<MC_ReportKey, MC_Report*>::iterator it_r = it->second.begin();
+    for (; it_r != it->second.end(); ++it_r)
+    {
+        MC_Report*& saved = reports_saved[id][it_r->first];
+        if (saved)
+            delete saved;
+        saved = new MC_Report(*it_r->second);
+    }
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int NoDatabaseReport::save_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                                   const std::string& options,
                                   const std::string& report, MediaConchLib::compression c,
-                                  int mil_version, std::string& err)
+                                  size_t uncompressed_size, int mil_version, int dictionary_id, std::string& err)
 {
-    if (file_id < 0 || file_id > (long)files_saved.size() || !files_saved[file_id] ||
-        files_saved[file_id]->user != user)
+    if (!file_match_user(user, file_id))
     {
         err = "File not found";
         return -1;
@@ -352,48 +535,42 @@ int NoDatabaseReport::save_report(int user, long file_id, MediaConchLib::report
     r->format = format;
     r->report = report;
     r->compression = c;
+    r->uncompressed_size = uncompressed_size;
     r->mil_version = mil_version;
+    r->dictionary_id = dictionary_id;
     r->options = options;
 
-    std::map<long, std::vector<MC_Report*> >::iterator it = reports_saved.find(file_id);
-    if (it != reports_saved.end())
-    {
-        for (size_t i = 0; i < reports_saved[file_id].size(); ++i)
-        {
-            MC_Report *r = reports_saved[file_id][i];
-            if (r && r->format == format && r->reportKind == reportKind && r->options == options)
-            {
-                delete r;
-                reports_saved[file_id].erase(reports_saved[file_id].begin() + i);
-                break;
-            }
-        }
-    }
-    reports_saved[file_id].push_back(r);
+    MC_Report*& saved = reports_saved[file_id][MC_ReportKey(reportKind, format, options)];
+    if (saved)
+        delete saved;
+    saved = r;
     return 0;
 }
 
 //---------------------------------------------------------------------------
 int NoDatabaseReport::get_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                                   const std::string& options,
-                                  std::string& report, MediaConchLib::compression& c, std::string& err)
+                                  std::string& report, MediaConchLib::compression& c, size_t& uncompressed_size,
+                                  int& dictionary_id, std::string& err)
 {
-    if (file_id < 0 || file_id > (long)files_saved.size() || !files_saved[file_id] ||
-        files_saved[file_id]->user != user)
+    if (!file_match_user(user, file_id))
     {
         err = "File not found";
         return -1;
     }
 
-    for (size_t i = 0; i < reports_saved[file_id].size(); ++i)
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::iterator it = reports_saved.find(file_id);
+    if (it != reports_saved.end())
     {
-        MC_Report* r = reports_saved[file_id][i];
-        if (!r || r->format != format || r->reportKind != reportKind || r->options != options)
-            continue;
-
-        report = r->report;
-        c = r->compression;
-        return 0;
+        std::map<MC_ReportKey, MC_Report*>::iterator it_r = it->second.find(MC_ReportKey(reportKind, format, options));
+        if (it_r != it->second.end())
+        {
+            report = it_r->second->report;
+            c = it_r->second->compression;
+            uncompressed_size = it_r->second->uncompressed_size;
+            dictionary_id = it_r->second->dictionary_id;
+            return 0;
+        }
     }
 
     err = "Report not found";
@@ -403,22 +580,19 @@ int NoDatabaseReport::get_report(int user, long file_id, MediaConchLib::report r
 //---------------------------------------------------------------------------
 int NoDatabaseReport::remove_report(int user, long file_id, std::string& err)
 {
-    if (file_id < 0 || file_id > (long)files_saved.size() || !files_saved[file_id] ||
-        files_saved[file_id]->user != user)
+    if (!file_match_user(user, file_id))
     {
         err = "File not found";
         return -1;
     }
 
-    std::map<long, std::vector<MC_Report*> >::iterator it = reports_saved.find(file_id);
-
-    if (it == reports_saved.end())
+    if (reports_saved.find(file_id) == reports_saved.end())
     {
         err = "Report not found";
         return -1;
     }
 
-    reports_saved.erase(it);
+    delete_reports(file_id);
     return 0;
 }
 
@@ -426,18 +600,13 @@ int NoDatabaseReport::remove_report(int user, long file_id, std::string& err)
 int NoDatabaseReport::remove_all_reports(int user, std::string& err)
 {
     err = std::string();
-    for (size_t id = 0; id < files_saved.size(); ++id)
-    {
-        if (!files_saved[id] || files_saved[id]->user != user)
-            continue;
-
-        std::map<long, std::vector<MC_Report*> >::iterator it = reports_saved.find(id);
-
-        if (it == reports_saved.end())
-            continue;
+    std::map<int, std::set<long> >::iterator it = users_files.find(user);
+    if (it == users_files.end())
+        return 0;
 
-        reports_saved.erase(it);
-    }
+    std::set<long>::iterator it_id = it->second.begin();
+    for (; it_id != it->second.end(); ++it_id)
+        delete_reports(*it_id);
     return 0;
 }
 
@@ -446,40 +615,34 @@ int NoDatabaseReport::report_is_registered(int user, long file_id, MediaConchLib
                                            const std::string& options, bool& registered, std::string& err)
 {
     registered = false;
-    if (file_id < 0 || file_id > (long)files_saved.size() || !files_saved[file_id] ||
-        files_saved[file_id]->user != user)
+    if (!file_match_user(user, file_id))
     {
         err = "File not found";
         return -1;
     }
 
-    for (size_t i = 0; i < reports_saved[file_id].size(); ++i)
-    {
-        MC_Report* r = reports_saved[file_id][i];
-
-        if (r && r->format == format && r->reportKind == reportKind && r->options == options)
-        {
-            registered = true;
-            break;
-        }
-    }
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::iterator it = reports_saved.find(file_id);
+    if (it != reports_saved.end())
+        registered = it->second.find(MC_ReportKey(reportKind, format, options)) != it->second.end();
 
     return 0;
 }
 
 int NoDatabaseReport::version_registered(int user, long file_id, std::string& err)
 {
-    if (file_id < 0 || file_id > (long)files_saved.size() || !files_saved[file_id] ||
-        files_saved[file_id]->user != user)
+    if (!file_match_user(user, file_id))
     {
         err = "File not found";
         return -1;
     }
 
-    for (size_t i = 0; i < reports_saved[file_id].size(); ++i)
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::iterator it = reports_saved.find(file_id);
+    if (it != reports_saved.end())
     {
-        if (reports_saved[file_id][i] && reports_saved[file_id][i]->mil_version)
-            return reports_saved[file_id][i]->mil_version;
+        std::map<MC_ReportKey, MC_Report*>::iterator it_r = it->second.begin();
+        for (; it_r != it->second.end(); ++it_r)
+            if (it_r->second->mil_version)
+                return it_r->second->mil_version;
     }
 
     err = "Report not found";
@@ -489,13 +652,13 @@ int NoDatabaseReport::version_registered(int user, long file_id, std::string& er
 //---------------------------------------------------------------------------
 int NoDatabaseReport::get_elements(int user, std::vector<std::string>& vec, std::string&)
 {
-    for (size_t i = 0; i < files_saved.size(); ++i)
-    {
-        if (!files_saved[i] || files_saved[i]->user != user)
-            continue;
+    std::map<int, std::set<long> >::iterator it = users_files.find(user);
+    if (it == users_files.end())
+        return 0;
 
-        vec.push_back(files_saved[i]->filename);
-    }
+    std::set<long>::iterator it_id = it->second.begin();
+    for (; it_id != it->second.end(); ++it_id)
+        vec.push_back(files_saved[*it_id]->filename);
 
     return 0;
 }
@@ -503,13 +666,11 @@ int NoDatabaseReport::get_elements(int user, std::vector<std::string>& vec, std:
 //---------------------------------------------------------------------------
 int NoDatabaseReport::get_elements(int user, std::vector<long>& vec, std::string&)
 {
-    for (size_t i = 0; i < files_saved.size(); ++i)
-    {
-        if (!files_saved[i] || files_saved[i]->user != user)
-            continue;
+    std::map<int, std::set<long> >::iterator it = users_files.find(user);
+    if (it == users_files.end())
+        return 0;
 
-        vec.push_back((long)i);
-    }
+    vec.insert(vec.end(), it->second.begin(), it->second.end());
 
     return 0;
 }
@@ -519,28 +680,88 @@ int NoDatabaseReport::get_element_report_kind(int user, long file_id, MediaConch
                                               std::string& err)
 {
     report_kind = MediaConchLib::report_MediaConch;
-    if (file_id < 0 || file_id > (long)files_saved.size() || !files_saved[file_id] ||
-        files_saved[file_id]->user != user)
+    if (!file_match_user(user, file_id))
     {
         err = "File not found";
         return -1;
     }
 
-    if (file_id >= 0 && reports_saved[file_id].size())
-    {
-        for (size_t i = 0; i < reports_saved[file_id].size(); ++i)
-        {
-            if (!reports_saved[file_id][i])
-                continue;
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >::iterator it = reports_saved.find(file_id);
+    if (it == reports_saved.end())
+        return 0;
 
-            MediaConchLib::report tool_i = reports_saved[file_id][i]->reportKind;
-            if (tool_i == MediaConchLib::report_MediaInfo || tool_i == MediaConchLib::report_MediaTrace || tool_i == MediaConchLib::report_MicroMediaTrace)
-                tool_i = MediaConchLib::report_MediaConch;
+    // Reports of the plugins give their kind to the file
+    std::map<MC_ReportKey, MC_Report*>::iterator it_r = it->second.begin();
+    for (; it_r != it->second.end(); ++it_r)
+    {
+        MediaConchLib::report tool_i = it_r->first.reportKind;
+        if (tool_i == MediaConchLib::report_MediaInfo || tool_i == MediaConchLib::report_MediaTrace || tool_i == MediaConchLib::report_MicroMediaTrace)
+            tool_i = MediaConchLib::report_MediaConch;
 
+        if (tool_i != MediaConchLib::report_MediaConch)
             report_kind = tool_i;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::get_watch_folder_user(const std::string& folder, long& user, std::string& err)
+{
+    std::map<std::pair<int, std::string>, std::map<std::string, DatabaseWatchFolderFile> >::iterator it;
+    for (it = watch_folders_files.begin(); it != watch_folders_files.end(); ++it)
+    {
+        if (it->first.second == folder)
+        {
+            user = it->first.first;
+            return 0;
         }
     }
 
+    err = "Folder not watched before.";
+    return -1;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::get_watch_folder_files(int user, const std::string& folder,
+                                             std::vector<DatabaseWatchFolderFile>& files, std::string&)
+{
+    std::map<std::pair<int, std::string>, std::map<std::string, DatabaseWatchFolderFile> >::iterator it;
+    it = watch_folders_files.find(std::make_pair(user, folder));
+    if (it == watch_folders_files.end())
+        return 0;
+
+    std::map<std::string, DatabaseWatchFolderFile>::iterator it_f = it->second.begin();
+    for (; it_f != it->second.end(); ++it_f)
+        files.push_back(it_f->second);
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::save_watch_folder_file(int user, const std::string& folder, const DatabaseWatchFolderFile& file,
+                                             std::string&)
+{
+    watch_folders_files[std::make_pair(user, folder)][file.filename] = file;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::remove_watch_folder_file(int user, const std::string& folder, const std::string& filename,
+                                               std::string&)
+{
+    std::map<std::pair<int, std::string>, std::map<std::string, DatabaseWatchFolderFile> >::iterator it;
+    it = watch_folders_files.find(std::make_pair(user, folder));
+    if (it != watch_folders_files.end())
+        it->second.erase(filename);
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int NoDatabaseReport::remove_watch_folder(int user, const std::string& folder, std::string&)
+{
+    watch_folders_files.erase(std::make_pair(user, folder));
     return 0;
 }
 
@@ -16,6 +16,7 @@
 
 //---------------------------------------------------------------------------
 #include "DatabaseReport.h"
+#include <set>
 
 //---------------------------------------------------------------------------
 namespace MediaConch {
@@ -67,16 +68,23 @@ public:
     virtual int  add_file_generated_id(int user, long source_id, long generated_id, std::string& err);
     virtual int  update_file_analyzed(int user, long id, std::string& err, bool analyzed=true);
     virtual int  update_file_error(int user, long id, std::string& err, bool has_error=true, const std::string& error_log="");
+    virtual int  update_file_fingerprint(int user, long id, const std::string& fingerprint, std::string& err);
+    virtual int  update_file_full_fingerprint(int user, long id, const std::string& fingerprint, std::string& err);
+    virtual int  get_file_full_fingerprint(int user, long id, std::string& fingerprint, std::string& err);
+    virtual long get_file_id_from_fingerprint(const std::string& fingerprint, const std::string& options, long exclude_id,
+                                              int& user, std::string& err);
+    virtual int  copy_reports(int src_user, long src_id, int user, long id, std::string& err);
 
     // Report
     virtual int  save_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                              const std::string& options,
-                             const std::string& report, MediaConchLib::compression, int, std::string&);
+                             const std::string& report, MediaConchLib::compression, size_t, int, int,
+                             std::string&);
     virtual int  remove_report(int user, long file_id, std::string& err);
     virtual int  remove_all_reports(int user, std::string& err);
     virtual int  get_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                             const std::string& options,
-                            std::string& report, MediaConchLib::compression&, std::string&);
+                            std::string& report, MediaConchLib::compression&, size_t&, int&, std::string&);
     virtual int  report_is_registered(int user, long file_id, MediaConchLib::report reportKind,
                                       MediaConchLib::format format, const std::string& options,
                                       bool& registered, std::string& err);
@@ -86,6 +94,16 @@ public:
     virtual int  get_element_report_kind(int user, long file_id, MediaConchLib::report& report_kind,
                                          std::string& err);
 
+    // Watch folder
+    virtual int  get_watch_folder_user(const std::string& folder, long& user, std::string& err);
+    virtual int  get_watch_folder_files(int user, const std::string& folder,
+                                        std::vector<DatabaseWatchFolderFile>& files, std::string& err);
+    virtual int  save_watch_folder_file(int user, const std::string& folder, const DatabaseWatchFolderFile& file,
+                                        std::string& err);
+    virtual int  remove_watch_folder_file(int user, const std::string& folder, const std::string& filename,
+                                          std::string& err);
+    virtual int  remove_watch_folder(int user, const std::string& folder, std::string& err);
+
 protected:
     virtual int  execute();
 
@@ -114,6 +132,9 @@ private:
 
         bool               has_error;
         std::string        error_log;
+
+        std::string        fingerprint;
+        std::string        full_fingerprint;
     };
 
     struct MC_Report
@@ -121,13 +142,50 @@ private:
         MediaConchLib::report      reportKind;
         MediaConchLib::format      format;
         MediaConchLib::compression compression;
+        size_t                     uncompressed_size;
         std::string                report;
         std::string                options;
         int                        mil_version;
+        int                        dictionary_id;
+    };
+
+    // Index of the files by user, name and options
+    struct MC_FileKey
+    {
+        MC_FileKey(int u, const std::string& f, const std::string& o) : user(u), filename(f), options(o) {}
+        int                user;
+        std::string        filename;
+        std::string        options;
+
+        bool operator<(const MC_FileKey& k) const;
+    };
+
+    // Index of the reports of a file by kind, format and options
+    struct MC_ReportKey
+    {
+        MC_ReportKey(MediaConchLib::report r, MediaConchLib::format f, const std::string& o) : reportKind(r), format(f), options(o) {}
+        MediaConchLib::report      reportKind;
+        MediaConchLib::format      format;
+        std::string                options;
+
+        bool operator<(const MC_ReportKey& k) const;
     };
 
-    std::vector<MC_File*> files_saved;
-    std::map<long, std::vector<MC_Report*> > reports_saved;
+    std::vector<MC_File*>                                files_saved;
+    std::map<MC_FileKey, std::vector<long> >             files_index; // Ids sorted, one by modification time
+    std::map<int, std::set<long> >                       users_files;
+    std::map<std::string, std::set<long> >               fingerprints_index;
+    std::map<long, std::map<MC_ReportKey, MC_Report*> >  reports_saved;
+    // Files of the watched folders by user and folder, then by name
+    std::map<std::pair<int, std::string>, std::map<std::string, DatabaseWatchFolderFile> > watch_folders_files;
+
+    bool file_match_user(int user, long id) const;
+    // Reports created by the VeraPDF or DPF Manager plugins
+    bool has_plugin_report(long id) const;
+    void index_file(long id);
+    void unindex_file(long id);
+    void delete_file(long id);
+    void delete_reports(long id);
 };
 
 }
@@ -23,6 +23,7 @@
 #include "Policy.h"
 #include "XsltPolicy.h"
 #include "UnknownPolicy.h"
+#include "PolicyEvaluator.h"
 #include "JS_Tree.h"
 //---------------------------------------------------------------------------
 
@@ -130,6 +131,7 @@ int Policies::create_xslt_policy(int user, const std::string& type, int parent_i
     {
         ((XsltPolicy*)parent)->nodes.push_back(p);
         p->parent_id = parent_id;
+        xslt_policy_changed(user, parent);
     }
 
     if (policies.find(user) == policies.end())
@@ -297,6 +299,7 @@ int Policies::duplicate_policy(int user, int id, int dst_policy_id, int *dst_use
         p = new XsltPolicy((XsltPolicy*)old);
         ((XsltPolicy*)p)->parent_id = destination->id;
         ((XsltPolicy*)destination)->nodes.push_back((XsltPolicy*)p);
+        xslt_policy_changed(destination_user, destination);
         if (copy_name && ((XsltPolicy*)old)->parent_id == destination->id && ((XsltPolicy*)p)->node_name.size())
             ((XsltPolicy*)p)->node_name += "_copy";
         p->name = ((XsltPolicy*)p)->node_name;
@@ -750,6 +753,7 @@ int Policies::remove_policy(int user, int id, std::string& err)
 
                 if (i != ((XsltPolicy*)tmp)->nodes.size())
                     ((XsltPolicy*)tmp)->nodes.erase(((XsltPolicy*)tmp)->nodes.begin() + i);
+                xslt_policy_changed(user, tmp);
             }
         }
     }
@@ -804,6 +808,7 @@ int Policies::policy_change_info(int user, int id, const std::string& name, cons
     p->description = description;
     if (license.size())
         p->license = license;
+    xslt_policy_changed(user, p);
 
     return 0;
 }
@@ -827,6 +832,7 @@ int Policies::policy_change_type(int user, int id, const std::string& type, std:
     }
 
     ((XsltPolicy*)p)->ope = type;
+    xslt_policy_changed(user, p);
 
     return 0;
 }
@@ -940,7 +946,8 @@ int Policies::create_xslt_policy_from_file(int user, long file_id, std::string&
 }
 
 int Policies::policy_get_policy_id(Policy* p, const std::map<std::string, std::string>& opts,
-                                   std::vector<std::string>& xslt_policies, std::string& err)
+                                   std::vector<std::string>& xslt_policies, std::string& err,
+                                   std::vector<PolicyEvaluator*>* evaluators)
 {
     if (!p)
         return -1;
@@ -965,11 +972,29 @@ int Policies::policy_get_policy_id(Policy* p, const std::map<std::string, std::s
 
     xslt_policies.push_back(policy);
 
+    // Same index as the XSLT, NULL if the policy must use it
+    if (evaluators)
+    {
+        PolicyEvaluator *evaluator = NULL;
+        std::map<std::string, std::string>::const_iterator compare = opts.find("compare");
+        if (p->type == POLICY_XSLT && (compare == opts.end() || compare->second.empty()))
+        {
+            evaluator = new PolicyEvaluator(!core->accepts_https());
+            if (evaluator->compile((XsltPolicy*)p) < 0)
+            {
+                delete evaluator;
+                evaluator = NULL;
+            }
+        }
+        evaluators->push_back(evaluator);
+    }
+
     return 0;
 }
 
 int Policies::policy_get_policy_content(const std::string& policy, const std::map<std::string, std::string>& opts,
-                                        std::vector<std::string>& xslt_policies, std::string& err)
+                                        std::vector<std::string>& xslt_policies, std::string& err,
+                                        std::vector<PolicyEvaluator*>* evaluators)
 {
     int ret = -1;
     Policy *p = new XsltPolicy(this, !core->accepts_https());
@@ -990,7 +1015,7 @@ int Policies::policy_get_policy_content(const std::string& policy, const std::ma
         }
     }
 
-    ret = policy_get_policy_id(p, opts, xslt_policies, err);
+    ret = policy_get_policy_id(p, opts, xslt_policies, err, evaluators);
     delete p;
     return ret;
 }
@@ -998,7 +1023,8 @@ int Policies::policy_get_policy_content(const std::string& policy, const std::ma
 int Policies::policy_get_policies(int user, const std::vector<size_t>* policies_ids,
                                   const std::vector<std::string>* policies_contents,
                                   const std::map<std::string, std::string>& opts,
-                                  std::vector<std::string>& xslt_policies, std::string& err)
+                                  std::vector<std::string>& xslt_policies, std::string& err,
+                                  std::vector<PolicyEvaluator*>* evaluators)
 {
     if (!policies_ids && !policies_contents)
     {
@@ -1009,14 +1035,14 @@ int Policies::policy_get_policies(int user, const std::vector<size_t>* policies_
     if (policies_ids)
     {
         for (size_t i = 0; i < policies_ids->size(); ++i)
-            if (policy_get_policy_id(get_policy(user, policies_ids->at(i), err), opts, xslt_policies, err) < 0)
+            if (policy_get_policy_id(get_policy(user, policies_ids->at(i), err), opts, xslt_policies, err, evaluators) < 0)
                 return -1;
     }
 
     if (policies_contents)
     {
         for (size_t i = 0; i < policies_contents->size(); ++i)
-            if (policy_get_policy_content(policies_contents->at(i), opts, xslt_policies, err) < 0)
+            if (policy_get_policy_content(policies_contents->at(i), opts, xslt_policies, err, evaluators) < 0)
                 return -1;
     }
 
@@ -1047,6 +1073,7 @@ int Policies::create_xslt_policy_rule(int user, int policy_id, std::string& err)
 
     rule->node_name = "New Rule";
     policy->nodes.push_back(rule);
+    xslt_policy_changed(user, p);
 
     return (int)rule->id;
 }
@@ -1090,7 +1117,9 @@ int Policies::edit_xslt_policy_rule(int user, int policy_id, int rule_id, const
     if (!r)
         return -1;
 
-    return r->edit_policy_rule(rule, err);
+    int ret = r->edit_policy_rule(rule, err);
+    xslt_policy_changed(user, p);
+    return ret;
 }
 
 int Policies::duplicate_xslt_policy_rule(int user, int policy_id, int rule_id, int dst_policy_id, std::string& err, bool copy_name)
@@ -1131,6 +1160,7 @@ int Policies::duplicate_xslt_policy_rule(int user, int policy_id, int rule_id, i
         rule->node_name += "_copy";
 
     ((XsltPolicy*)destination)->nodes.push_back(rule);
+    xslt_policy_changed(user, destination);
 
     return (int)rule->id;
 }
@@ -1170,7 +1200,25 @@ int Policies::delete_xslt_policy_rule(int user, int policy_id, int rule_id, std:
     }
 
     XsltPolicy *policy = (XsltPolicy*)p;
-    return policy->delete_policy_rule(rule_id, err);
+    int ret = policy->delete_policy_rule(rule_id, err);
+    xslt_policy_changed(user, p);
+    return ret;
+}
+
+void Policies::xslt_policy_changed(int user, Policy* p)
+{
+    // The final XSLT of a policy includes its sub-policies: invalidate the whole tree from the root
+    std::string err;
+    while (p && p->type == POLICY_XSLT && ((XsltPolicy*)p)->parent_id != (size_t)-1)
+    {
+        Policy *parent = get_policy(user, ((XsltPolicy*)p)->parent_id, err);
+        if (!parent)
+            break;
+        p = parent;
+    }
+
+    if (p && p->type == POLICY_XSLT)
+        ((XsltPolicy*)p)->invalidate_final_xslt();
 }
 
 // Helper
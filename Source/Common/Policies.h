@@ -41,6 +41,7 @@ class XsltPolicy;
 class XsltPolicyRule;
 class XsltPolicyNode;
 class Core;
+class PolicyEvaluator;
 
 //***************************************************************************
 // Class Policies
@@ -92,7 +93,8 @@ public:
     int         policy_get_policies(int user, const std::vector<size_t>* policies_ids,
                                     const std::vector<std::string>* policies_contents,
                                     const std::map<std::string, std::string>& opts,
-                                    std::vector<std::string>& xslt_policies, std::string& err);
+                                    std::vector<std::string>& xslt_policies, std::string& err,
+                                    std::vector<PolicyEvaluator*>* evaluators = NULL);
 
     // Rule
     int         create_xslt_policy_rule(int user, int policy_id, std::string& err);
@@ -162,10 +164,13 @@ private:
     void remove_saved_policy(const Policy* policy);
     XsltPolicyRule* get_xslt_policy_rule(XsltPolicy* policy, int id);
     int policy_get_policy_id(Policy* p, const std::map<std::string, std::string>& opts,
-                             std::vector<std::string>& xslt_policies, std::string& err);
+                             std::vector<std::string>& xslt_policies, std::string& err,
+                             std::vector<PolicyEvaluator*>* evaluators);
     int policy_get_policy_content(const std::string& policy, const std::map<std::string, std::string>& opts,
-                                  std::vector<std::string>& xslt_policies, std::string& err);
+                                  std::vector<std::string>& xslt_policies, std::string& err,
+                                  std::vector<PolicyEvaluator*>* evaluators);
     int erase_xslt_policy_node(std::map<size_t, Policy *>& user_policies, int id, std::string& err);
+    void xslt_policy_changed(int user, Policy* p);
     MediaConchLib::Policy_Policy *policy_to_mcl_policy(Policy *p, std::string& err);
     MediaConchLib::Policy_Policy* xslt_policy_to_mcl_policy(XsltPolicy *policy, std::string&);
     int xslt_policy_child_to_mcl_policy(XsltPolicyNode *node, MediaConchLib::Policy_Policy *, std::string&);
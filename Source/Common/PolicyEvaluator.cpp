@@ -0,0 +1,648 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//---------------------------------------------------------------------------
+#ifdef __BORLANDC__
+    #pragma hdrstop
+#endif
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include "PolicyEvaluator.h"
+#include "XsltPolicy.h"
+#include <libxml/parser.h>
+#include <libxml/xpath.h>
+#include <libxml/xpathInternals.h>
+#include <sstream>
+//---------------------------------------------------------------------------
+
+namespace MediaConch {
+
+//***************************************************************************
+// Constructor/Destructor
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+PolicyEvaluator::PolicyEvaluator(bool n_https) : root(NULL), no_https(n_https)
+{
+}
+
+//---------------------------------------------------------------------------
+PolicyEvaluator::~PolicyEvaluator()
+{
+    delete root;
+}
+
+//---------------------------------------------------------------------------
+PolicyEvaluator::Node::~Node()
+{
+    for (size_t i = 0; i < policies.size(); ++i)
+        delete policies[i];
+    policies.clear();
+}
+
+//***************************************************************************
+// Compile
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+int PolicyEvaluator::compile(const XsltPolicy* policy)
+{
+    delete root;
+    root = NULL;
+
+    if (!policy)
+        return -1;
+
+    root = compile_policy(policy);
+    if (!root)
+        return -1;
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+PolicyEvaluator::Node *PolicyEvaluator::compile_policy(const XsltPolicy* policy)
+{
+    Node *node = new Node;
+    node->name = policy->node_name;
+    node->type = policy->ope.size() ? policy->ope : "and";
+    node->description = policy->description;
+
+    if (!is_string_supported(node->name) || !is_string_supported(node->type)
+     || !is_string_supported(node->description, true))
+    {
+        delete node;
+        return NULL;
+    }
+
+    // Entities of the description are resolved when the policy is dumped
+    if (node->description.find('&') != std::string::npos)
+    {
+        delete node;
+        return NULL;
+    }
+
+    for (size_t i = 0; i < policy->nodes.size(); ++i)
+    {
+        if (!policy->nodes[i])
+            continue;
+
+        if (policy->nodes[i]->kind == XSLT_POLICY_POLICY)
+        {
+            Node *child = compile_policy((XsltPolicy*)policy->nodes[i]);
+            if (!child)
+            {
+                delete node;
+                return NULL;
+            }
+            node->policies.push_back(child);
+            continue;
+        }
+
+        const XsltPolicyRule *r = (XsltPolicyRule*)policy->nodes[i];
+
+        // Rules without track type nor scope are not run by the XSLT
+        if (r->track_type.empty() && r->scope.empty())
+            continue;
+
+        Rule rule;
+        if (compile_rule(r, rule) < 0)
+        {
+            delete node;
+            return NULL;
+        }
+        node->rules.push_back(rule);
+    }
+
+    return node;
+}
+
+//---------------------------------------------------------------------------
+int PolicyEvaluator::compile_rule(const XsltPolicyRule* r, Rule& rule)
+{
+    // MicroMediaTrace rules are only handled by the XSLT
+    if (r->scope.size())
+        return -1;
+
+    rule.name = r->node_name;
+    rule.field = r->field;
+    rule.track_type = r->track_type;
+    rule.ope = r->ope;
+    rule.value = r->value;
+
+    if (!is_string_supported(rule.name) || !is_string_supported(rule.field)
+     || !is_string_supported(rule.track_type) || !is_string_supported(rule.ope)
+     || !is_string_supported(rule.value))
+        return -1;
+
+    // Both are written as XPath literals
+    if (rule.track_type.find('\'') != std::string::npos || rule.value.find('\'') != std::string::npos)
+        return -1;
+
+    if (rule.ope.empty() || rule.ope == "exists")
+        rule.op = OPERATOR_EXISTS;
+    else if (rule.ope == "must not exist")
+        rule.op = OPERATOR_NOT_EXISTS;
+    else if (rule.ope == "starts with")
+        rule.op = OPERATOR_STARTS_WITH;
+    else if (rule.ope == "must not start with")
+        rule.op = OPERATOR_NOT_STARTS_WITH;
+    else if (rule.ope == "=")
+        rule.op = OPERATOR_EQUAL;
+    else if (rule.ope == "!=")
+        rule.op = OPERATOR_NOT_EQUAL;
+    else if (rule.ope == ">")
+        rule.op = OPERATOR_GREATER;
+    else if (rule.ope == ">=")
+        rule.op = OPERATOR_GREATER_OR_EQUAL;
+    else if (rule.ope == "<")
+        rule.op = OPERATOR_LESS;
+    else if (rule.ope == "<=")
+        rule.op = OPERATOR_LESS_OR_EQUAL;
+    else
+        return -1;
+
+    std::stringstream occurrence;
+    if (r->occurrence >= 0)
+    {
+        occurrence << r->occurrence;
+        rule.position = r->occurrence;
+    }
+    else
+    {
+        occurrence << "*";
+        rule.position = -1;
+    }
+    rule.occurrence = occurrence.str();
+
+    std::string steps;
+    if (compile_field(rule.field, rule.path, steps) < 0)
+        return -1;
+
+    std::string base = "mi:MediaInfo/mi:track[@type='" + rule.track_type + "'][" + rule.occurrence + "]" + steps;
+    switch (rule.op)
+    {
+        case OPERATOR_EXISTS:
+            rule.xpath = base;
+            break;
+        case OPERATOR_NOT_EXISTS:
+            rule.xpath = "not(" + base + ")";
+            break;
+        case OPERATOR_STARTS_WITH:
+            rule.xpath = "starts-with(" + base + ",'" + rule.value + "')";
+            break;
+        case OPERATOR_NOT_STARTS_WITH:
+            rule.xpath = "not(starts-with(" + base + ",'" + rule.value + "'))";
+            break;
+        default:
+            rule.xpath = base + rule.ope + "'" + rule.value + "'";
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int PolicyEvaluator::compile_field(const std::string& field, std::vector<std::string>& path, std::string& xpath)
+{
+    // Same splitting as the tokenize template of the policy transformation
+    std::string list = field;
+    while (true)
+    {
+        std::string removeprefix = list;
+        if (!list.compare(0, 7, "offset:"))
+            removeprefix = list.substr(7);
+        else if (!list.compare(0, 5, "size:"))
+            removeprefix = list.substr(5);
+
+        // normalize-space()
+        std::string newlist;
+        bool space = false;
+        for (size_t i = 0; i < removeprefix.size(); ++i)
+        {
+            char c = removeprefix[i];
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+            {
+                space = newlist.size() > 0;
+                continue;
+            }
+
+            if (space)
+                newlist += ' ';
+            space = false;
+            newlist += c;
+        }
+
+        if (removeprefix.find('/') == std::string::npos)
+            newlist += '/';
+
+        size_t pos = newlist.find('/');
+        std::string first = newlist.substr(0, pos);
+        std::string remaining = newlist.substr(pos + 1);
+
+        if (first.size() >= 2 && first[0] == 'm' && first[1] == ':')
+            first = first.substr(2);
+        else if (remaining.empty() && first == "Data")
+            break;
+
+        // Must be a valid XPath name test
+        if (first.empty())
+            return -1;
+        for (size_t i = 0; i < first.size(); ++i)
+        {
+            char c = first[i];
+            bool is_letter = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+            bool is_digit = (c >= '0' && c <= '9') || c == '-' || c == '.';
+            if (!is_letter && (!i || !is_digit))
+                return -1;
+        }
+
+        path.push_back(first);
+        xpath += "/mi:" + first;
+
+        if (remaining.empty())
+            break;
+        list = remaining;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+bool PolicyEvaluator::is_string_supported(const std::string& str, bool is_text)
+{
+    // The XSLT path modifies these strings
+    if (str.find("aliasxsl") != std::string::npos || str.find("my:namespace") != std::string::npos)
+        return false;
+    if (no_https && str.find("https://") != std::string::npos)
+        return false;
+
+    bool blank = true;
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        unsigned char c = (unsigned char)str[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r')
+        {
+            // Only kept as is in text content
+            if (c != ' ' && (!is_text || c == '\r'))
+                return false;
+            continue;
+        }
+
+        if (c < 0x20)
+            return false;
+        blank = false;
+    }
+
+    // Whitespace only strings are stripped from the stylesheet
+    if (str.size() && blank)
+        return false;
+
+    return true;
+}
+
+//***************************************************************************
+// Evaluate
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+int PolicyEvaluator::evaluate(const std::vector<PolicyEvaluatorMedia>& media, std::string& report, std::string& err)
+{
+    if (!root)
+    {
+        err = "Policy is not compiled";
+        return -1;
+    }
+
+    std::string ns_mi = get_namespace("mediainfo");
+
+    report = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    report += "<MediaConch xmlns=\"" + get_namespace("mediaconch") + "\"";
+    report += " xmlns:mmt=\"" + get_namespace("micromediatrace") + "\"";
+    report += " xmlns:mi=\"" + ns_mi + "\" version=\"0.3\"";
+    if (media.empty())
+    {
+        report += "/>\n";
+        return 0;
+    }
+    report += ">\n";
+
+    for (size_t i = 0; i < media.size(); ++i)
+    {
+        std::string xml = "<MediaInfo xmlns=\"" + ns_mi + "\">" + media[i].mediainfo + "</MediaInfo>";
+        xmlDocPtr doc = xmlReadMemory(xml.c_str(), xml.length(), NULL, NULL, XML_PARSE_COMPACT | XML_PARSE_NOENT);
+        if (!doc)
+        {
+            err = "MediaInfo report cannot be parsed";
+            return -1;
+        }
+
+        std::vector<xmlNodePtr> tracks;
+        xmlNodePtr mi = xmlDocGetRootElement(doc);
+        for (xmlNodePtr child = mi ? mi->children : NULL; child; child = child->next)
+            if (child->type == XML_ELEMENT_NODE && child->ns && ns_mi == (const char*)child->ns->href
+             && std::string((const char*)child->name) == "track")
+                tracks.push_back(child);
+
+        Result result;
+        evaluate_policy(root, tracks, 2, result);
+        xmlFreeDoc(doc);
+
+        // Attribute value normalization of the MediaArea report
+        std::string ref;
+        for (size_t j = 0; j < media[i].ref.size(); ++j)
+        {
+            char c = media[i].ref[j];
+            if (c == '\r' && j + 1 < media[i].ref.size() && media[i].ref[j + 1] == '\n')
+                continue;
+            ref += (c == '\r' || c == '\n' || c == '\t') ? ' ' : c;
+        }
+        escape_attribute(ref);
+        report += "  <media ref=\"" + ref + "\">\n";
+        report += result.output;
+        report += "  </media>\n";
+    }
+
+    report += "</MediaConch>\n";
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+void PolicyEvaluator::evaluate_policy(const Node* node, const std::vector<xmlNodePtr>& tracks, size_t level, Result& result)
+{
+    std::string children;
+
+    // Rules are written before the sub-policies
+    for (size_t i = 0; i < node->rules.size(); ++i)
+    {
+        Result tmp;
+        evaluate_rule(node->rules[i], tracks, level + 1, tmp);
+        children += tmp.output;
+        if (tmp.pass)
+            result.pass_count++;
+        else
+            result.fail_count++;
+    }
+
+    for (size_t i = 0; i < node->policies.size(); ++i)
+    {
+        Result tmp;
+        evaluate_policy(node->policies[i], tracks, level + 1, tmp);
+        children += tmp.output;
+        if (tmp.pass)
+            result.pass_count++;
+        else
+            result.fail_count++;
+    }
+
+    if (node->type == "or")
+        result.pass = result.pass_count >= 1;
+    else if (node->type == "and")
+        result.pass = result.fail_count == 0;
+    else
+        result.pass = false;
+
+    std::string indent(level * 2, ' ');
+    std::string name = node->name;
+    std::string type = node->type;
+    escape_attribute(name);
+    escape_attribute(type);
+
+    std::stringstream out;
+    out << indent << "<policy name=\"" << name << "\" type=\"" << type << "\"";
+    out << " rules_run=\"" << result.pass_count + result.fail_count << "\"";
+    out << " fail_count=\"" << result.fail_count << "\" pass_count=\"" << result.pass_count << "\"";
+    out << " outcome=\"" << (result.pass ? "pass" : "fail") << "\"";
+
+    if (node->description.empty() && children.empty())
+    {
+        out << "/>\n";
+        result.output = out.str();
+        return;
+    }
+
+    out << ">\n";
+    if (node->description.size())
+    {
+        std::string description = node->description;
+        escape_text(description);
+        out << indent << "  <description>" << description << "</description>\n";
+    }
+    out << children;
+    out << indent << "</policy>\n";
+    result.output = out.str();
+}
+
+//---------------------------------------------------------------------------
+void PolicyEvaluator::evaluate_rule(const Rule& rule, const std::vector<xmlNodePtr>& tracks, size_t level, Result& result)
+{
+    std::vector<xmlNodePtr> nodes;
+    get_nodes(rule, tracks, nodes);
+
+    // Same comparisons as XPath between a node-set and a string
+    bool pass = false;
+    switch (rule.op)
+    {
+        case OPERATOR_EXISTS:
+            pass = nodes.size() > 0;
+            break;
+        case OPERATOR_NOT_EXISTS:
+            pass = nodes.empty();
+            break;
+        case OPERATOR_STARTS_WITH:
+        case OPERATOR_NOT_STARTS_WITH:
+        {
+            std::string str;
+            if (nodes.size())
+                str = get_string_value(nodes[0]);
+            pass = !str.compare(0, rule.value.size(), rule.value);
+            if (rule.op == OPERATOR_NOT_STARTS_WITH)
+                pass = !pass;
+            break;
+        }
+        case OPERATOR_EQUAL:
+        case OPERATOR_NOT_EQUAL:
+            for (size_t i = 0; !pass && i < nodes.size(); ++i)
+                pass = (get_string_value(nodes[i]) == rule.value) == (rule.op == OPERATOR_EQUAL);
+            break;
+        default:
+        {
+            double value = xmlXPathStringEvalNumber((const xmlChar*)rule.value.c_str());
+            for (size_t i = 0; !pass && i < nodes.size(); ++i)
+            {
+                double node_value = xmlXPathStringEvalNumber((const xmlChar*)get_string_value(nodes[i]).c_str());
+                if (xmlXPathIsNaN(value) || xmlXPathIsNaN(node_value))
+                    continue;
+
+                switch (rule.op)
+                {
+                    case OPERATOR_GREATER:          pass = node_value > value; break;
+                    case OPERATOR_GREATER_OR_EQUAL: pass = node_value >= value; break;
+                    case OPERATOR_LESS:             pass = node_value < value; break;
+                    case OPERATOR_LESS_OR_EQUAL:    pass = node_value <= value; break;
+                    default:;
+                }
+            }
+        }
+    }
+
+    result.pass = pass;
+
+    std::string str;
+    std::stringstream out;
+    out << std::string(level * 2, ' ') << "<rule";
+    if (rule.name.size())
+    {
+        str = rule.name;
+        escape_attribute(str);
+        out << " name=\"" << str << "\"";
+    }
+    if (rule.field.size())
+    {
+        str = rule.field;
+        escape_attribute(str);
+        out << " value=\"" << str << "\"";
+    }
+    if (rule.track_type.size())
+    {
+        str = rule.track_type;
+        escape_attribute(str);
+        out << " tracktype=\"" << str << "\"";
+    }
+    out << " occurrence=\"" << rule.occurrence << "\"";
+    if (rule.ope.size())
+    {
+        str = rule.ope;
+        escape_attribute(str);
+        out << " operator=\"" << str << "\"";
+    }
+
+    str = rule.xpath;
+    escape_attribute(str);
+    out << " xpath=\"" << str << "\"";
+
+    if (!pass || rule.op == OPERATOR_STARTS_WITH || rule.op == OPERATOR_NOT_STARTS_WITH)
+    {
+        str = std::string();
+        if (nodes.size())
+            str = get_string_value(nodes[0]);
+        escape_attribute(str);
+        out << " actual=\"" << str << "\"";
+    }
+
+    out << " outcome=\"" << (pass ? "pass" : "fail") << "\"/>\n";
+    result.output = out.str();
+}
+
+//---------------------------------------------------------------------------
+void PolicyEvaluator::get_nodes(const Rule& rule, const std::vector<xmlNodePtr>& tracks, std::vector<xmlNodePtr>& nodes)
+{
+    long position = 0;
+    for (size_t i = 0; i < tracks.size(); ++i)
+    {
+        xmlChar *type = xmlGetNoNsProp(tracks[i], (const xmlChar*)"type");
+        if (!type)
+            continue;
+
+        bool is_type = rule.track_type == (const char*)type;
+        xmlFree(type);
+        if (!is_type)
+            continue;
+
+        ++position;
+        if (rule.position >= 0 && position != rule.position)
+            continue;
+
+        if (rule.position < 0)
+        {
+            // [*] keeps the tracks with at least one element
+            xmlNodePtr child = tracks[i]->children;
+            while (child && child->type != XML_ELEMENT_NODE)
+                child = child->next;
+            if (!child)
+                continue;
+        }
+
+        std::vector<xmlNodePtr> current(1, tracks[i]);
+        for (size_t j = 0; j < rule.path.size() && current.size(); ++j)
+        {
+            std::vector<xmlNodePtr> next;
+            for (size_t k = 0; k < current.size(); ++k)
+                for (xmlNodePtr child = current[k]->children; child; child = child->next)
+                    if (child->type == XML_ELEMENT_NODE && child->ns == tracks[i]->ns
+                     && rule.path[j] == (const char*)child->name)
+                        next.push_back(child);
+            current = next;
+        }
+
+        nodes.insert(nodes.end(), current.begin(), current.end());
+    }
+}
+
+//***************************************************************************
+// Output
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+std::string PolicyEvaluator::get_namespace(const std::string& name)
+{
+    return std::string(no_https ? "http" : "https") + "://mediaarea.net/" + name;
+}
+
+//---------------------------------------------------------------------------
+std::string PolicyEvaluator::get_string_value(xmlNodePtr node)
+{
+    std::string str;
+    xmlChar *content = xmlNodeGetContent(node);
+    if (content)
+    {
+        str = std::string((const char*)content);
+        xmlFree(content);
+    }
+    return str;
+}
+
+//---------------------------------------------------------------------------
+void PolicyEvaluator::escape_attribute(std::string& str)
+{
+    // Same escaping as the libxml2 serializer
+    std::string escaped;
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        switch (str[i])
+        {
+            case '&':  escaped += "&amp;"; break;
+            case '<':  escaped += "&lt;"; break;
+            case '>':  escaped += "&gt;"; break;
+            case '"':  escaped += "&quot;"; break;
+            case '\n': escaped += "&#10;"; break;
+            case '\r': escaped += "&#13;"; break;
+            case '\t': escaped += "&#9;"; break;
+            default:   escaped += str[i];
+        }
+    }
+    str = escaped;
+}
+
+//---------------------------------------------------------------------------
+void PolicyEvaluator::escape_text(std::string& str)
+{
+    std::string escaped;
+    for (size_t i = 0; i < str.size(); ++i)
+    {
+        switch (str[i])
+        {
+            case '&':  escaped += "&amp;"; break;
+            case '<':  escaped += "&lt;"; break;
+            case '>':  escaped += "&gt;"; break;
+            case '\r': escaped += "&#13;"; break;
+            default:   escaped += str[i];
+        }
+    }
+    str = escaped;
+}
+
+}
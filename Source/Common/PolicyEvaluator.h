@@ -0,0 +1,139 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Native evaluation of XSLT policies
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifndef PolicyEvaluatorH
+#define PolicyEvaluatorH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <libxml/tree.h>
+//---------------------------------------------------------------------------
+
+namespace MediaConch {
+
+class XsltPolicy;
+class XsltPolicyRule;
+
+//***************************************************************************
+// Struct PolicyEvaluatorMedia
+//***************************************************************************
+
+struct PolicyEvaluatorMedia
+{
+    std::string ref;       // File name, not escaped
+    std::string mediainfo; // Content of the media element of the MediaInfo XML report
+};
+
+//***************************************************************************
+// Class PolicyEvaluator
+//***************************************************************************
+
+// Evaluate an XsltPolicy directly on the MediaInfo reports, the output is
+// the same report as the one generated by the final XSLT of the policy.
+// Only policies with MediaInfo rules can be compiled, the other ones
+// must use the XSLT.
+class PolicyEvaluator
+{
+public:
+    //Constructor/Destructor
+    PolicyEvaluator(bool no_https);
+    ~PolicyEvaluator();
+
+    // Return -1 if the policy cannot be evaluated natively
+    int compile(const XsltPolicy* policy);
+    int evaluate(const std::vector<PolicyEvaluatorMedia>& media, std::string& report, std::string& err);
+
+private:
+    PolicyEvaluator(const PolicyEvaluator&);
+    PolicyEvaluator& operator=(const PolicyEvaluator&);
+
+    enum Operator
+    {
+        OPERATOR_EXISTS,
+        OPERATOR_NOT_EXISTS,
+        OPERATOR_STARTS_WITH,
+        OPERATOR_NOT_STARTS_WITH,
+        OPERATOR_EQUAL,
+        OPERATOR_NOT_EQUAL,
+        OPERATOR_GREATER,
+        OPERATOR_GREATER_OR_EQUAL,
+        OPERATOR_LESS,
+        OPERATOR_LESS_OR_EQUAL
+    };
+
+    struct Rule
+    {
+        std::string              name;
+        std::string              field;
+        std::string              track_type;
+        std::string              occurrence;
+        std::string              ope;
+        std::string              value;
+        std::string              xpath;
+        Operator                 op;
+        long                     position; // -1 for all the tracks
+        std::vector<std::string> path;
+    };
+
+    struct Node
+    {
+        Node() {}
+        ~Node();
+
+        std::string              name;
+        std::string              type;
+        std::string              description;
+        std::vector<Rule>        rules;
+        std::vector<Node*>       policies;
+
+    private:
+        Node(const Node&);
+        Node& operator=(const Node&);
+    };
+
+    struct Result
+    {
+        Result() : pass_count(0), fail_count(0), pass(false) {}
+
+        std::string              output;
+        size_t                   pass_count;
+        size_t                   fail_count;
+        bool                     pass;
+    };
+
+    Node                        *root;
+    bool                         no_https;
+
+    // Compile
+    Node *compile_policy(const XsltPolicy* policy);
+    int   compile_rule(const XsltPolicyRule* r, Rule& rule);
+    int   compile_field(const std::string& field, std::vector<std::string>& path, std::string& xpath);
+    bool  is_string_supported(const std::string& str, bool is_text=false);
+
+    // Evaluate
+    void  evaluate_policy(const Node* node, const std::vector<xmlNodePtr>& tracks, size_t level, Result& result);
+    void  evaluate_rule(const Rule& rule, const std::vector<xmlNodePtr>& tracks, size_t level, Result& result);
+    void  get_nodes(const Rule& rule, const std::vector<xmlNodePtr>& tracks, std::vector<xmlNodePtr>& nodes);
+
+    // Output
+    std::string get_namespace(const std::string& name);
+    static std::string get_string_value(xmlNodePtr node);
+    static void escape_attribute(std::string& str);
+    static void escape_text(std::string& str);
+};
+
+}
+
+#endif
@@ -29,7 +29,8 @@
 namespace MediaConch {
 
 //---------------------------------------------------------------------------
-QueueElement::QueueElement(Scheduler *s) : Thread(), scheduler(s), MI(NULL)
+QueueElement::QueueElement(Scheduler *s) : file_id(-1), mil_analyze(true), trace_only(false), trace(true),
+                                           reuse_analysis(false), scheduler(s), MI(NULL), stopped(false)
 {
 }
 
@@ -42,13 +43,20 @@ QueueElement::~QueueElement()
 //---------------------------------------------------------------------------
 void QueueElement::stop()
 {
-    RequestTerminate();
     MI_CS.Enter();
+    stopped = true;
     if (MI)
         MI->Option(__T("File_RequestTerminate"), String());
     MI_CS.Leave();
-    while (!IsExited())
-        Yield();
+}
+
+//---------------------------------------------------------------------------
+bool QueueElement::is_stopped()
+{
+    MI_CS.Enter();
+    bool ret = stopped;
+    MI_CS.Leave();
+    return ret;
 }
 
 static void __stdcall Event_CallBackFunction(unsigned char* Data_Content, size_t Data_Size, void* UserHandle_Void)
@@ -79,7 +87,7 @@ static void __stdcall Event_CallBackFunction(unsigned char* Data_Content, size_t
 }
 
 //---------------------------------------------------------------------------
-void QueueElement::Entry()
+void QueueElement::run()
 {
     std::string file = real_filename;
     std::string err;
@@ -91,7 +99,19 @@ void QueueElement::Entry()
     log << "start analyze:" << file;
     scheduler->write_log_timestamp(PluginLog::LOG_LEVEL_DEBUG, log.str());
 
-    ret = scheduler->execute_pre_hook_plugins(this, err);
+    // Fingerprint computed by the worker, the file is not parsed when its reports are copied
+    if (scheduler->reuse_analysis_of_same_content(this))
+    {
+        log.str("");
+        log << "end analyze, reports of the same content copied:" << file;
+        scheduler->write_log_timestamp(PluginLog::LOG_LEVEL_DEBUG, log.str());
+        scheduler->work_finished(this, NULL);
+        return;
+    }
+
+    // Plugins were run by the first analysis
+    if (!trace_only)
+        ret = scheduler->execute_pre_hook_plugins(this, err);
 
     if (ret || !mil_analyze)
     {
@@ -103,6 +123,11 @@ void QueueElement::Entry()
     }
 
     MI_CS.Enter();
+    if (stopped)
+    {
+        MI_CS.Leave();
+        return;
+    }
     MI = new MediaInfoNameSpace::MediaInfo;
     MI_CS.Leave();
 
@@ -119,13 +144,17 @@ void QueueElement::Entry()
     if (found == false)
         MI->Option(__T("ParseSpeed"), __T("0"));
 
-    // Configuration of the parsing
+    // Configuration of the parsing, the MediaTrace can be created when it is asked
+    // A generated file is removed after its analysis, its MediaTrace is created now
+    trace = trace_only || real_filename != filename || !scheduler->mediatrace_is_on_demand();
     found = false;
     for (size_t i = 0; i < options.size(); ++i)
         if (options[i].first == "details")
             found = true;
     if (found == false)
-        MI->Option(__T("Details"), __T("1"));
+        MI->Option(__T("Details"), trace ? __T("1") : __T("0"));
+    else
+        trace = true;
 
     // Attachment
     std::stringstream ss;
@@ -141,7 +170,7 @@ void QueueElement::Entry()
         MI->Option(Ztring().From_UTF8(options[i].first), Ztring().From_UTF8(options[i].second));
 
     MI->Open(ZenLib::Ztring().From_UTF8(file));
-    if (!IsTerminating()) //If terminating was requested, file is partially parsed (and there is some thread lock because the scheduler calls the queue which calls the scheduler) //TODO: reorganize calls
+    if (!is_stopped()) //If terminating was requested, file is partially parsed (and there is some thread lock because the scheduler calls the queue which calls the scheduler) //TODO: reorganize calls
         scheduler->work_finished(this, MI);
     MI_CS.Enter();
     MI->Close();
@@ -163,16 +192,20 @@ void QueueElement::Entry()
 //---------------------------------------------------------------------------
 double QueueElement::percent_done()
 {
-    if (!MI)
-        return (double)0;
+    MI_CS.Enter();
+    size_t state = MI ? MI->State_Get() : 0;
+    MI_CS.Leave();
 
-    size_t state = MI->State_Get();
     return (double)state / 100;
 }
 
 //---------------------------------------------------------------------------
 int QueueElement::attachment_cb(struct MediaInfo_Event_Global_AttachedFile_0 *Event)
 {
+    // Attachments were analyzed by the first analysis
+    if (trace_only)
+        return 0;
+
     std::string attachment((const char*)Event->Content, Event->Content_Size);
 
     std::string realname = "Unknown";
@@ -217,7 +250,8 @@ Queue::~Queue()
 
 int Queue::add_element(QueuePriority priority, int id, int user, const std::string& filename, long file_id,
                        const std::vector<std::pair<std::string,std::string> >& options,
-                       const std::vector<std::string>& plugins, bool mil_analyze, const std::string& alias)
+                       const std::vector<std::string>& plugins, bool mil_analyze, const std::string& alias,
+                       bool trace_only, bool reuse_analysis)
 {
     QueueElement *el = new QueueElement(scheduler);
 
@@ -227,6 +261,8 @@ int Queue::add_element(QueuePriority priority, int id, int user, const std::stri
     el->real_filename = filename;
     el->file_id = file_id;
     el->mil_analyze = mil_analyze;
+    el->trace_only = trace_only;
+    el->reuse_analysis = reuse_analysis;
 
     std::vector<std::pair<std::string,std::string> > opts;
     for (size_t i = 0; i < options.size(); ++i)
@@ -284,6 +320,21 @@ int Queue::has_id(int user, long file_id)
     return -1;
 }
 
+bool Queue::has_trace_element(int user, long file_id)
+{
+    std::map<QueuePriority, std::list<QueueElement*> >::iterator it = queue.begin();
+
+    for (; it != queue.end(); ++it)
+    {
+        std::list<QueueElement*>::iterator it_l = it->second.begin();
+        for (; it_l != it->second.end() ; ++it_l)
+            if ((*it_l)->trace_only && (*it_l)->file_id == file_id && (*it_l)->user == user)
+                return true;
+    }
+
+    return false;
+}
+
 int Queue::remove_element(int id)
 {
     std::map<QueuePriority, std::list<QueueElement*> >::iterator it = queue.begin();
@@ -331,7 +382,16 @@ void Queue::clear()
     queue.clear();
 }
 
-QueueElement *Queue::run_next()
+size_t Queue::queue_size() const
+{
+    size_t size = 0;
+    std::map<QueuePriority, std::list<QueueElement*> >::const_iterator it = queue.begin();
+    for (; it != queue.end(); ++it)
+        size += it->second.size();
+    return size;
+}
+
+QueueElement *Queue::pop_next()
 {
     QueueElement* el = NULL;
 
@@ -356,10 +416,6 @@ QueueElement *Queue::run_next()
         queue[PRIORITY_NONE].pop_front();
     }
 
-    if (!el)
-        return NULL;
-
-    el->Run();
     return el;
 }
 
@@ -27,7 +27,6 @@
     #define MediaInfoNameSpace MediaInfoLib
 #endif
 #include "ZenLib/Ztring.h"
-#include "ZenLib/Thread.h"
 #include "ZenLib/CriticalSection.h"
 #include <MediaInfo/MediaInfo_Events.h>
 //---------------------------------------------------------------------------
@@ -50,7 +49,8 @@ namespace MediaConch
         std::string realname;
     };
 
-    class QueueElement : public ZenLib::Thread
+    // Job run by one of the scheduler workers
+    class QueueElement
     {
     public:
         QueueElement(Scheduler *s);
@@ -65,9 +65,16 @@ namespace MediaConch
         std::vector<Attachment*>           attachments;
         long                               file_id;
         bool                               mil_analyze;
-
-        void                               Entry();
+        // Only the MediaTrace of a file already analyzed is created
+        bool                               trace_only;
+        // The file is parsed with the details, its MediaTrace is registered
+        bool                               trace;
+        // The reports of an analyzed file with the same content can be copied
+        bool                               reuse_analysis;
+
+        void                               run();
         void                               stop();
+        bool                               is_stopped();
         double                             percent_done();
         int                                attachment_cb(struct MediaInfo_Event_Global_AttachedFile_0 *Event);
         int                                log_cb(struct MediaInfo_Event_Log_0 *Event);
@@ -76,6 +83,7 @@ namespace MediaConch
         Scheduler*                         scheduler;
         MediaInfoNameSpace::MediaInfo     *MI;
         ZenLib::CriticalSection            MI_CS;
+        bool                               stopped;
     };
 
     //***************************************************************************
@@ -103,15 +111,16 @@ namespace MediaConch
         int add_element(QueuePriority priority, int id, int user, const std::string& filename, long file_id,
                         const std::vector<std::pair<std::string,std::string> >& options,
                         const std::vector<std::string>& plugins, bool mil_analyze,
-                        const std::string& alias="");
+                        const std::string& alias="", bool trace_only=false, bool reuse_analysis=false);
+        bool has_trace_element(int user, long file_id);
         long has_element(int user, const std::string& filename);
         int  has_id(int user, long file_id);
         int remove_element(int id);
         int remove_elements(int user, const std::string& filename);
         void clear();
 
-        QueueElement* run_next();
-        size_t queue_size() const { return queue.size(); }
+        QueueElement* pop_next();
+        size_t queue_size() const;
 
     private:
         std::map<QueuePriority, std::list<QueueElement*> > queue;
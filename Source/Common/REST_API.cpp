@@ -25,7 +25,7 @@ namespace MediaConch {
 // RESTAPI
 //***************************************************************************
 
-const std::string RESTAPI::API_VERSION = "1.15";
+const std::string RESTAPI::API_VERSION = "1.17";
 
 //***************************************************************************
 // Constructor/Destructor
@@ -247,6 +247,26 @@ RESTAPI::Checker_List_MediaInfo_Outputs_Res::~Checker_List_MediaInfo_Outputs_Res
     }
 }
 
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Events_Res::~Checker_Events_Res()
+{
+    if (nok)
+    {
+        delete nok;
+        nok = NULL;
+    }
+}
+
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Report_Raw_Res::~Checker_Report_Raw_Res()
+{
+    if (nok)
+    {
+        delete nok;
+        nok = NULL;
+    }
+}
+
 //---------------------------------------------------------------------------
 RESTAPI::Default_Values_For_Type_Res::~Default_Values_For_Type_Res()
 {
@@ -649,6 +669,34 @@ std::string RESTAPI::Checker_List_MediaInfo_Outputs_Req::to_str() const
     return out.str();
 }
 
+//---------------------------------------------------------------------------
+std::string RESTAPI::Checker_Events_Req::to_str() const
+{
+    std::stringstream out;
+
+    out << "{\"user\":" << user;
+    out << ",\"last_event\":" << last_event;
+    out << ",\"timeout\":" << timeout << "}";
+    return out.str();
+}
+
+//---------------------------------------------------------------------------
+std::string RESTAPI::Checker_Report_Raw_Req::to_str() const
+{
+    std::stringstream out;
+    RESTAPI api;
+
+    out << "{\"user\":" << user;
+    out << ",\"id\":" << id;
+    out << ",\"report\":" << api.get_Report_string(report);
+    if (accept_deflate)
+        out << ",\"accept_deflate\":true";
+    if (range.size())
+        out << ",\"range\":\"" << range << "\"";
+    out << "}";
+    return out.str();
+}
+
 //---------------------------------------------------------------------------
 std::string RESTAPI::Default_Values_For_Type_Req::to_str() const
 {
@@ -1318,6 +1366,58 @@ std::string RESTAPI::Checker_List_MediaInfo_Outputs_Res::to_str() const
     return out.str();
 }
 
+//---------------------------------------------------------------------------
+std::string RESTAPI::Checker_Events_Res::to_str() const
+{
+    std::stringstream out;
+
+    out << "{";
+    if (nok)
+        out << "\"nok\":" << nok->to_str();
+    else
+    {
+        out << "\"last_event\":" << last_event;
+        if (events_lost)
+            out << ",\"events_lost\":true";
+        out << ",\"finished\":[";
+        for (size_t i = 0; i < finished.size(); ++i)
+        {
+            if (i)
+                out << ",";
+            out << finished[i];
+        }
+        out << "],\"progress\":[";
+        for (size_t i = 0; i < progress.size(); ++i)
+        {
+            if (i)
+                out << ",";
+            out << "{\"id\":" << progress[i].id;
+            out << ",\"done\":" << progress[i].percent << "}";
+        }
+        out << "]";
+    }
+    out << "}";
+    return out.str();
+}
+
+//---------------------------------------------------------------------------
+std::string RESTAPI::Checker_Report_Raw_Res::to_str() const
+{
+    std::stringstream out;
+
+    out << "{";
+    if (nok)
+        out << "\"nok\":" << nok->to_str();
+    else
+    {
+        out << "\"size\":" << report.size();
+        if (deflate)
+            out << ",\"deflate\":true,\"uncompressed_size\":" << uncompressed_size;
+    }
+    out << "}";
+    return out.str();
+}
+
 //---------------------------------------------------------------------------
 std::string RESTAPI::Default_Values_For_Type_Res::to_str() const
 {
@@ -2152,6 +2252,34 @@ int RESTAPI::serialize_checker_list_mediainfo_outputs_req(Checker_List_MediaInfo
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int RESTAPI::serialize_checker_events_req(Checker_Events_Req& req, std::string& data, std::string&)
+{
+    //URI
+    std::stringstream ss;
+
+    ss << "?user=" << req.user;
+    ss << "&last_event=" << req.last_event;
+    ss << "&timeout=" << req.timeout;
+    data = ss.str();
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int RESTAPI::serialize_checker_report_raw_req(Checker_Report_Raw_Req& req, std::string& data, std::string&)
+{
+    //URI, accept_deflate and range are sent in the headers
+    std::stringstream ss;
+
+    ss << "?user=" << req.user;
+    ss << "&id=" << req.id;
+    ss << "&report=" << get_Report_string(req.report);
+    data = ss.str();
+
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int RESTAPI::serialize_default_values_for_type_req(Default_Values_For_Type_Req& req, std::string& data, std::string& err)
 {
@@ -2875,6 +3003,45 @@ int RESTAPI::serialize_checker_report_res(Checker_Report_Res& res, std::string&
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int RESTAPI::serialize_checker_report_res(Checker_Report_Res& res, JsonWriter& writer, std::string& err)
+{
+    writer.start_object();
+    writer.add_key("CHECKER_REPORT_RESULT");
+    writer.start_object();
+    if (res.ok)
+    {
+        writer.add_key("ok");
+        writer.start_object();
+        if (res.ok->report.length() > 0)
+        {
+            writer.add_key("report");
+            writer.add_string(res.ok->report);
+        }
+        if (res.ok->has_valid)
+        {
+            writer.add_key("valid");
+            writer.add_bool(res.ok->valid);
+        }
+        writer.end_object();
+    }
+    else if (res.nok)
+    {
+        writer.add_key("nok");
+        writer.add_value(serialize_mediaconch_nok(res.nok, err));
+    }
+    writer.end_object();
+    writer.end_object();
+
+    if (writer.has_failed())
+    {
+        err = "The report cannot be written in the reply.";
+        return -1;
+    }
+
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int RESTAPI::serialize_checker_clear_res(Checker_Clear_Res& res, std::string& data, std::string& err)
 {
@@ -3156,6 +3323,88 @@ int RESTAPI::serialize_checker_list_mediainfo_outputs_res(Checker_List_MediaInfo
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int RESTAPI::serialize_checker_events_res(Checker_Events_Res& res, std::string& data, std::string& err)
+{
+    Container::Value v, child;
+
+    child.type = Container::Value::CONTAINER_TYPE_OBJECT;
+
+    if (res.nok)
+        child.obj["nok"] = serialize_mediaconch_nok(res.nok, err);
+    else
+    {
+        Container::Value last_event, events_lost, progress;
+
+        last_event.type = Container::Value::CONTAINER_TYPE_INTEGER;
+        last_event.l = res.last_event;
+        child.obj["last_event"] = last_event;
+
+        if (res.events_lost)
+        {
+            events_lost.type = Container::Value::CONTAINER_TYPE_BOOL;
+            events_lost.b = true;
+            child.obj["events_lost"] = events_lost;
+        }
+
+        child.obj["finished"] = serialize_ids(res.finished, err);
+
+        progress.type = Container::Value::CONTAINER_TYPE_ARRAY;
+        for (size_t i = 0; i < res.progress.size(); ++i)
+        {
+            Container::Value p, id, done;
+            p.type = Container::Value::CONTAINER_TYPE_OBJECT;
+
+            id.type = Container::Value::CONTAINER_TYPE_INTEGER;
+            id.l = res.progress[i].id;
+            p.obj["id"] = id;
+
+            done.type = Container::Value::CONTAINER_TYPE_REAL;
+            done.d = res.progress[i].percent;
+            p.obj["done"] = done;
+
+            progress.array.push_back(p);
+        }
+        child.obj["progress"] = progress;
+    }
+
+    v.type = Container::Value::CONTAINER_TYPE_OBJECT;
+    v.obj["CHECKER_EVENTS_RESULT"] = child;
+
+    if (model->serialize(v, data) < 0)
+    {
+        err = model->get_error();
+        return -1;
+    }
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int RESTAPI::serialize_checker_report_raw_res(Checker_Report_Raw_Res& res, std::string& data, std::string& err)
+{
+    // The report is the body of the answer
+    if (!res.nok)
+    {
+        err = "Only the error of the raw report is serialized";
+        return -1;
+    }
+
+    Container::Value v, child;
+
+    child.type = Container::Value::CONTAINER_TYPE_OBJECT;
+    child.obj["nok"] = serialize_mediaconch_nok(res.nok, err);
+
+    v.type = Container::Value::CONTAINER_TYPE_OBJECT;
+    v.obj["CHECKER_REPORT_RAW_RESULT"] = child;
+
+    if (model->serialize(v, data) < 0)
+    {
+        err = model->get_error();
+        return -1;
+    }
+    return 0;
+}
+
 //---------------------------------------------------------------------------
 int RESTAPI::serialize_default_values_for_type_res(Default_Values_For_Type_Res& res, std::string& data, std::string& err)
 {
@@ -4162,12 +4411,16 @@ RESTAPI::Checker_Report_Req *RESTAPI::parse_checker_report_req(const std::string
     {
         for (size_t i = 0; i < policies_contents->array.size(); ++i)
             if (policies_contents->array[i].type == Container::Value::CONTAINER_TYPE_STRING)
-                req->policies_contents.push_back(policies_contents->array[i].s);
+            {
+                // Moved from the parsed values, the policies can be large
+                req->policies_contents.push_back(std::string());
+                req->policies_contents.back().swap(policies_contents->array[i].s);
+            }
     }
     if (display_name && display_name->type == Container::Value::CONTAINER_TYPE_STRING)
         req->display_name = display_name->s;
     if (display_content && display_content->type == Container::Value::CONTAINER_TYPE_STRING)
-        req->display_content = display_content->s;
+        req->display_content.swap(display_content->s);
 
     if (mi_inform && mi_inform->type == Container::Value::CONTAINER_TYPE_STRING)
         req->mi_inform = mi_inform->s;
@@ -4380,7 +4633,11 @@ RESTAPI::Checker_Validate_Req *RESTAPI::parse_checker_validate_req(const std::st
     {
         for (size_t i = 0; i < policies_contents->array.size(); ++i)
             if (policies_contents->array[i].type == Container::Value::CONTAINER_TYPE_STRING)
-                req->policies_contents.push_back(policies_contents->array[i].s);
+            {
+                // Moved from the parsed values, the policies can be large
+                req->policies_contents.push_back(std::string());
+                req->policies_contents.back().swap(policies_contents->array[i].s);
+            }
     }
 
     if (options && options->type == Container::Value::CONTAINER_TYPE_OBJECT)
@@ -4514,6 +4771,79 @@ RESTAPI::Checker_List_MediaInfo_Outputs_Req *RESTAPI::parse_checker_list_mediain
     return req;
 }
 
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Events_Req *RESTAPI::parse_checker_events_req(const std::string& data, std::string& err)
+{
+    Container::Value v, *child;
+
+    if (model->parse(data, v))
+    {
+        err = model->get_error();
+        return NULL;
+    }
+
+    child = model->get_value_by_key(v, "CHECKER_EVENTS");
+    if (!child || child->type != Container::Value::CONTAINER_TYPE_OBJECT)
+    {
+        err = "Missing CHECKER_EVENTS in the request";
+        return NULL;
+    }
+
+    Checker_Events_Req *req = new Checker_Events_Req;
+
+    Container::Value *user = model->get_value_by_key(*child, "user");
+    if (user && user->type == Container::Value::CONTAINER_TYPE_INTEGER)
+        req->user = user->l;
+
+    Container::Value *last_event = model->get_value_by_key(*child, "last_event");
+    if (last_event && last_event->type == Container::Value::CONTAINER_TYPE_INTEGER)
+        req->last_event = last_event->l;
+
+    Container::Value *timeout = model->get_value_by_key(*child, "timeout");
+    if (timeout && timeout->type == Container::Value::CONTAINER_TYPE_INTEGER && timeout->l > 0)
+        req->timeout = (size_t)timeout->l;
+
+    return req;
+}
+
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Report_Raw_Req *RESTAPI::parse_checker_report_raw_req(const std::string& data, std::string& err)
+{
+    Container::Value v, *child;
+
+    if (model->parse(data, v))
+    {
+        err = model->get_error();
+        return NULL;
+    }
+
+    child = model->get_value_by_key(v, "CHECKER_REPORT_RAW");
+    if (!child || child->type != Container::Value::CONTAINER_TYPE_OBJECT)
+    {
+        err = "Missing CHECKER_REPORT_RAW in the request";
+        return NULL;
+    }
+
+    Container::Value *user = model->get_value_by_key(*child, "user");
+    Container::Value *id = model->get_value_by_key(*child, "id");
+    Container::Value *report = model->get_value_by_key(*child, "report");
+    if (!id || id->type != Container::Value::CONTAINER_TYPE_INTEGER ||
+        !report || report->type != Container::Value::CONTAINER_TYPE_STRING)
+    {
+        err = "checker report raw request is not correct";
+        return NULL;
+    }
+
+    Checker_Report_Raw_Req *req = new Checker_Report_Raw_Req;
+
+    if (user && user->type == Container::Value::CONTAINER_TYPE_INTEGER)
+        req->user = user->l;
+    req->id = id->l;
+    req->report = string_to_Report(report->s);
+
+    return req;
+}
+
 //---------------------------------------------------------------------------
 RESTAPI::Checker_File_Information_Req *RESTAPI::parse_checker_file_information_req(const std::string& data, std::string& err)
 {
@@ -4649,7 +4979,7 @@ RESTAPI::Policy_Import_Req *RESTAPI::parse_policy_import_req(const std::string&
     }
 
     Policy_Import_Req *req = new Policy_Import_Req;
-    req->xml = xml->s;
+    req->xml.swap(xml->s);
 
     Container::Value *user = model->get_value_by_key(*child, "user");
     if (user && user->type == Container::Value::CONTAINER_TYPE_INTEGER)
@@ -5818,6 +6148,86 @@ RESTAPI::Checker_List_MediaInfo_Outputs_Req *RESTAPI::parse_uri_checker_list_med
     return req;
 }
 
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Events_Req *RESTAPI::parse_uri_checker_events_req(const std::string& uri, std::string&)
+{
+    Checker_Events_Req *req = new Checker_Events_Req;
+
+    size_t start = 0;
+    size_t and_pos = 0;
+    while (start != std::string::npos)
+    {
+        size_t key_start = start;
+        start = uri.find("=", start);
+        if (start == std::string::npos)
+            continue;
+
+        std::string substr = uri.substr(key_start, start - key_start);
+        ++start;
+        and_pos = uri.find("&", start);
+        std::string val = uri.substr(start, and_pos - start);
+
+        start = and_pos;
+        if (start != std::string::npos)
+            start += 1;
+
+        if (!val.length())
+            continue;
+
+        if (substr == "user")
+            req->user = strtoll(val.c_str(), NULL, 10);
+        else if (substr == "last_event")
+            req->last_event = strtoll(val.c_str(), NULL, 10);
+        else if (substr == "timeout")
+        {
+            long long timeout = strtoll(val.c_str(), NULL, 10);
+            if (timeout > 0)
+                req->timeout = (size_t)timeout;
+        }
+        else
+            start = std::string::npos;
+    }
+    return req;
+}
+
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Report_Raw_Req *RESTAPI::parse_uri_checker_report_raw_req(const std::string& uri, std::string&)
+{
+    Checker_Report_Raw_Req *req = new Checker_Report_Raw_Req;
+
+    size_t start = 0;
+    size_t and_pos = 0;
+    while (start != std::string::npos)
+    {
+        size_t key_start = start;
+        start = uri.find("=", start);
+        if (start == std::string::npos)
+            continue;
+
+        std::string substr = uri.substr(key_start, start - key_start);
+        ++start;
+        and_pos = uri.find("&", start);
+        std::string val = uri.substr(start, and_pos - start);
+
+        start = and_pos;
+        if (start != std::string::npos)
+            start += 1;
+
+        if (!val.length())
+            continue;
+
+        if (substr == "user")
+            req->user = strtoll(val.c_str(), NULL, 10);
+        else if (substr == "id")
+            req->id = strtoll(val.c_str(), NULL, 10);
+        else if (substr == "report")
+            req->report = string_to_Report(val);
+        else
+            start = std::string::npos;
+    }
+    return req;
+}
+
 //---------------------------------------------------------------------------
 RESTAPI::Default_Values_For_Type_Req *RESTAPI::parse_uri_default_values_for_type_req(const std::string& uri, std::string&)
 {
@@ -7840,6 +8250,124 @@ RESTAPI::Checker_List_MediaInfo_Outputs_Res *RESTAPI::parse_checker_list_mediain
     return res;
 }
 
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Events_Res *RESTAPI::parse_checker_events_res(const std::string& data, std::string& err)
+{
+    Container::Value v, *child;
+
+    if (model->parse(data, v))
+    {
+        err = model->get_error();
+        return NULL;
+    }
+
+    child = model->get_value_by_key(v, "CHECKER_EVENTS_RESULT");
+    if (!child || child->type != Container::Value::CONTAINER_TYPE_OBJECT)
+    {
+        err = "Missing CHECKER_EVENTS_RESULT in the result";
+        return NULL;
+    }
+
+    Checker_Events_Res *res = new Checker_Events_Res;
+    Container::Value *nok = model->get_value_by_key(*child, "nok");
+    if (nok)
+    {
+        if (parse_mediaconch_nok(nok, &res->nok, err) < 0)
+        {
+            delete res;
+            return NULL;
+        }
+        return res;
+    }
+
+    Container::Value *last_event = model->get_value_by_key(*child, "last_event");
+    Container::Value *events_lost = model->get_value_by_key(*child, "events_lost");
+    Container::Value *finished = model->get_value_by_key(*child, "finished");
+    Container::Value *progress = model->get_value_by_key(*child, "progress");
+
+    if (!last_event || last_event->type != Container::Value::CONTAINER_TYPE_INTEGER ||
+        (finished && finished->type != Container::Value::CONTAINER_TYPE_ARRAY) ||
+        (progress && progress->type != Container::Value::CONTAINER_TYPE_ARRAY))
+    {
+        err = "checker events result is not correct";
+        delete res;
+        return NULL;
+    }
+
+    res->last_event = last_event->l;
+    if (events_lost && events_lost->type == Container::Value::CONTAINER_TYPE_BOOL)
+        res->events_lost = events_lost->b;
+
+    for (size_t i = 0; finished && i < finished->array.size(); ++i)
+    {
+        if (finished->array[i].type != Container::Value::CONTAINER_TYPE_INTEGER)
+        {
+            err = "finished field has not the correct type";
+            delete res;
+            return NULL;
+        }
+        res->finished.push_back(finished->array[i].l);
+    }
+
+    for (size_t i = 0; progress && i < progress->array.size(); ++i)
+    {
+        Container::Value *id = model->get_value_by_key(progress->array[i], "id");
+        Container::Value *done = model->get_value_by_key(progress->array[i], "done");
+        if (!id || id->type != Container::Value::CONTAINER_TYPE_INTEGER)
+        {
+            err = "progress field has not the correct type";
+            delete res;
+            return NULL;
+        }
+
+        Checker_Events_Progress p;
+        p.id = id->l;
+        p.percent = 0.0;
+        if (done && done->type == Container::Value::CONTAINER_TYPE_REAL)
+            p.percent = done->d;
+        else if (done && done->type == Container::Value::CONTAINER_TYPE_INTEGER)
+            p.percent = (double)done->l;
+        res->progress.push_back(p);
+    }
+
+    return res;
+}
+
+//---------------------------------------------------------------------------
+RESTAPI::Checker_Report_Raw_Res *RESTAPI::parse_checker_report_raw_res(const std::string& data, std::string& err)
+{
+    Container::Value v, *child;
+
+    if (model->parse(data, v))
+    {
+        err = model->get_error();
+        return NULL;
+    }
+
+    child = model->get_value_by_key(v, "CHECKER_REPORT_RAW_RESULT");
+    if (!child || child->type != Container::Value::CONTAINER_TYPE_OBJECT)
+    {
+        err = "Missing CHECKER_REPORT_RAW_RESULT in the result";
+        return NULL;
+    }
+
+    Container::Value *nok = model->get_value_by_key(*child, "nok");
+    if (!nok)
+    {
+        err = "checker report raw result is not correct";
+        return NULL;
+    }
+
+    Checker_Report_Raw_Res *res = new Checker_Report_Raw_Res;
+    if (parse_mediaconch_nok(nok, &res->nok, err) < 0)
+    {
+        delete res;
+        return NULL;
+    }
+
+    return res;
+}
+
 //---------------------------------------------------------------------------
 RESTAPI::Default_Values_For_Type_Res *RESTAPI::parse_default_values_for_type_res(const std::string& data, std::string& err)
 {
@@ -19,6 +19,7 @@
 #include <vector>
 #include <utility>
 #include "Container.h"
+#include "JsonWriter.h"
 #include "MediaConchLib.h"
 //---------------------------------------------------------------------------
 
@@ -530,6 +531,63 @@ public:
         std::string     to_str() const;
     };
 
+    // Events
+    struct Checker_Events_Req
+    {
+        Checker_Events_Req() : user(-1), last_event(-1), timeout(0) {}
+
+        int                    user;
+        long                   last_event;
+        size_t                 timeout;
+        std::string            to_str() const;
+    };
+
+    struct Checker_Events_Progress
+    {
+        long                   id;
+        double                 percent;
+    };
+
+    struct Checker_Events_Res
+    {
+        Checker_Events_Res() : last_event(-1), events_lost(false), nok(NULL) {}
+        ~Checker_Events_Res();
+
+        long                                  last_event;
+        bool                                  events_lost;
+        std::vector<long>                     finished;
+        std::vector<Checker_Events_Progress>  progress;
+        MediaConch_Nok                       *nok;
+        std::string                           to_str() const;
+    };
+
+    // Report raw
+    struct Checker_Report_Raw_Req
+    {
+        Checker_Report_Raw_Req() : user(-1), id(-1), report(NO_REPORT), accept_deflate(false) {}
+
+        int                    user;
+        long                   id;
+        Report                 report;
+        // From the headers of the request: Accept-Encoding and Range
+        bool                   accept_deflate;
+        std::string            range;
+        std::string            to_str() const;
+    };
+
+    struct Checker_Report_Raw_Res
+    {
+        Checker_Report_Raw_Res() : deflate(false), uncompressed_size(0), nok(NULL) {}
+        ~Checker_Report_Raw_Res();
+
+        // Sent as the body of the answer, only nok is sent in JSON
+        std::string            report;
+        bool                   deflate;
+        size_t                 uncompressed_size;
+        MediaConch_Nok        *nok;
+        std::string            to_str() const;
+    };
+
     struct Default_Values_For_Type_Req
     {
         std::string  type;
@@ -1049,6 +1107,8 @@ public:
     int serialize_checker_id_from_filename_req(Checker_Id_From_Filename_Req& req, std::string&, std::string& err);
     int serialize_checker_file_information_req(Checker_File_Information_Req& req, std::string&, std::string& err);
     int serialize_checker_list_mediainfo_outputs_req(Checker_List_MediaInfo_Outputs_Req& req, std::string&, std::string& err);
+    int serialize_checker_events_req(Checker_Events_Req& req, std::string&, std::string& err);
+    int serialize_checker_report_raw_req(Checker_Report_Raw_Req& req, std::string&, std::string& err);
     int serialize_default_values_for_type_req(Default_Values_For_Type_Req& req, std::string&, std::string& err);
 
     int serialize_xslt_policy_create_req(XSLT_Policy_Create_Req& req, std::string&, std::string& err);
@@ -1087,6 +1147,8 @@ public:
     int serialize_checker_analyze_res(Checker_Analyze_Res& res, std::string&, std::string& err);
     int serialize_checker_status_res(Checker_Status_Res& res, std::string&, std::string& err);
     int serialize_checker_report_res(Checker_Report_Res& res, std::string&, std::string& err);
+    // The report is escaped directly in the output
+    int serialize_checker_report_res(Checker_Report_Res& res, JsonWriter& writer, std::string& err);
     int serialize_checker_clear_res(Checker_Clear_Res& res, std::string&, std::string& err);
     int serialize_checker_stop_res(Checker_Stop_Res& res, std::string&, std::string& err);
     int serialize_checker_list_res(Checker_List_Res& res, std::string&, std::string& err);
@@ -1095,6 +1157,8 @@ public:
     int serialize_checker_id_from_filename_res(Checker_Id_From_Filename_Res& res, std::string&, std::string& err);
     int serialize_checker_file_information_res(Checker_File_Information_Res& res, std::string&, std::string& err);
     int serialize_checker_list_mediainfo_outputs_res(Checker_List_MediaInfo_Outputs_Res& res, std::string&, std::string& err);
+    int serialize_checker_events_res(Checker_Events_Res& res, std::string&, std::string& err);
+    int serialize_checker_report_raw_res(Checker_Report_Raw_Res& res, std::string&, std::string& err);
     int serialize_default_values_for_type_res(Default_Values_For_Type_Res& res, std::string&, std::string& err);
 
     int serialize_xslt_policy_create_res(XSLT_Policy_Create_Res& res, std::string&, std::string& err);
@@ -1140,6 +1204,8 @@ public:
     Checker_Id_From_Filename_Req        *parse_checker_id_from_filename_req(const std::string& data, std::string& err);
     Checker_File_Information_Req        *parse_checker_file_information_req(const std::string& data, std::string& err);
     Checker_List_MediaInfo_Outputs_Req  *parse_checker_list_mediainfo_outputs_req(const std::string& uri, std::string& err);
+    Checker_Events_Req                  *parse_checker_events_req(const std::string& data, std::string& err);
+    Checker_Report_Raw_Req              *parse_checker_report_raw_req(const std::string& data, std::string& err);
     Default_Values_For_Type_Req         *parse_default_values_for_type_req(const std::string& data, std::string& err);
 
     XSLT_Policy_Create_Req              *parse_xslt_policy_create_req(const std::string&, std::string& err);
@@ -1187,6 +1253,8 @@ public:
     Checker_Id_From_Filename_Req        *parse_uri_checker_id_from_filename_req(const std::string& uri, std::string& err);
     Checker_File_Information_Req        *parse_uri_checker_file_information_req(const std::string& uri, std::string& err);
     Checker_List_MediaInfo_Outputs_Req  *parse_uri_checker_list_mediainfo_outputs_req(const std::string& uri, std::string& err);
+    Checker_Events_Req                  *parse_uri_checker_events_req(const std::string& uri, std::string& err);
+    Checker_Report_Raw_Req              *parse_uri_checker_report_raw_req(const std::string& uri, std::string& err);
     Default_Values_For_Type_Req         *parse_uri_default_values_for_type_req(const std::string& uri, std::string& err);
 
     XSLT_Policy_Create_Req              *parse_uri_xslt_policy_create_req(const std::string&, std::string& err);
@@ -1232,6 +1300,8 @@ public:
     Checker_Id_From_Filename_Res       *parse_checker_id_from_filename_res(const std::string& data, std::string& err);
     Checker_File_Information_Res       *parse_checker_file_information_res(const std::string& data, std::string& err);
     Checker_List_MediaInfo_Outputs_Res *parse_checker_list_mediainfo_outputs_res(const std::string& data, std::string& err);
+    Checker_Events_Res                 *parse_checker_events_res(const std::string& data, std::string& err);
+    Checker_Report_Raw_Res             *parse_checker_report_raw_res(const std::string& data, std::string& err);
     Default_Values_For_Type_Res        *parse_default_values_for_type_res(const std::string& data, std::string& err);
 
     XSLT_Policy_Create_Res             *parse_xslt_policy_create_res(const std::string&, std::string& err);
@@ -16,6 +16,7 @@
 #include "JS_Tree.h"
 #include "Schema.h"
 #include "Xslt.h"
+#include "PolicyEvaluator.h"
 
 #include "Common/generated/ImplementationReportXsl.h"
 #include "Common/generated/ImplementationReportVeraPDFXsl.h"
@@ -40,12 +41,15 @@ namespace MediaConch {
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-Reports::Reports(Core *c) : core(c)
+Reports::Reports(Core *c) : core(c), doc_cache(NULL)
 {
+    xslt_cache = new XsltCache;
 }
 
 Reports::~Reports()
 {
+    delete doc_cache;
+    delete xslt_cache;
 }
 
 //***************************************************************************
@@ -603,6 +607,9 @@ int Reports::create_report_mt_xml(int user, const std::vector<long>& files, std:
 
     report += start.str();
 
+    if (core->checker_create_mediatrace(user, files, err) < 0)
+        return -1;
+
     std::vector<long> vec;
     for (size_t i = 0; i < files.size(); ++i)
     {
@@ -657,6 +664,10 @@ int Reports::create_report_mmt_xml(int user, const std::vector<long>& files, std
 
     report += start.str();
 
+    // Traces not created by the analysis are created together
+    if (core->checker_create_mediatrace(user, files, err) < 0)
+        return -1;
+
     std::vector<long> vec;
     for (size_t i = 0; i < files.size(); ++i)
     {
@@ -711,6 +722,10 @@ int Reports::create_report_ma_xml(int user, const std::vector<long>& files,
     start << "\" url=\"http" << (AcceptsHttps ? "s" : std::string()) << "://mediaarea.net/MediaInfo\">MediaInfoLib</creatingLibrary>\n";
     report += start.str();
 
+    if ((reports[MediaConchLib::report_MediaTrace] || reports[MediaConchLib::report_MicroMediaTrace])
+        && core->checker_create_mediatrace(user, files, err) < 0)
+        return -1;
+
     std::vector<long> vec;
     for (size_t i = 0; i < files.size(); ++i)
     {
@@ -951,15 +966,38 @@ int Reports::check_policies(int user, const std::vector<long>& files,
     for (; it != opts.end(); ++it)
         options[it->first] = it->second;
 
-    unify_policy_options(user, options, err);
+    long reference_id = -1;
+    std::string reference_path;
+    unify_policy_options(options, reference_id, reference_path);
+
+    // Policies with only MediaInfo rules are evaluated without XSLT when possible
+    std::vector<PolicyEvaluator*> evaluators;
+    std::vector<PolicyEvaluator*>* evaluators_ptr = NULL;
+    if (core->policy_native_evaluation_is_enabled())
+        evaluators_ptr = &evaluators;
 
     std::vector<std::string> policies;
-    if (core->policies.policy_get_policies(user, policies_ids, policies_contents, options, policies, err) < 0)
-        return -1;
+    int ret = core->policies.policy_get_policies(user, policies_ids, policies_contents, options, policies, err,
+                                                 evaluators_ptr);
+
+    // The MicroMediaTrace of the reference file is only created if a policy reads it
+    if (ret >= 0 && reference_path.size())
+    {
+        bool with_mmt = false;
+        for (size_t i = 0; !with_mmt && i < policies.size(); ++i)
+            with_mmt = xslt_uses_micromediatrace(policies[i]);
+        ret = create_policy_reference_file(user, reference_id, reference_path, options, with_mmt, err);
+    }
 
     std::stringstream Out;
     result->has_valid = true;
-    if (check_policies_xslts(user, files, options, policies, Out, result->valid, err) < 0)
+    if (ret >= 0)
+        ret = check_policies_xslts(user, files, options, policies, Out, result->valid, err, evaluators_ptr);
+
+    for (size_t i = 0; i < evaluators.size(); ++i)
+        delete evaluators[i];
+
+    if (ret < 0)
         return -1;
 
     result->report = Out.str();
@@ -970,14 +1008,30 @@ int Reports::check_policies(int user, const std::vector<long>& files,
 int Reports::check_policies_xslts(int user, const std::vector<long>& files,
                                    const std::map<std::string, std::string>& options,
                                    const std::vector<std::string>& policies,
-                                   std::stringstream& Out, bool& valid, std::string& err)
+                                   std::stringstream& Out, bool& valid, std::string& err,
+                                   const std::vector<PolicyEvaluator*>* evaluators)
 {
     valid = true;
+    std::vector<PolicyEvaluatorMedia> media;
+    MediaAreaDoc ma_doc;
     for (size_t i = 0; i < policies.size(); ++i)
     {
         std::string tmp;
-        if (validate_xslt_from_memory(user, files, options, policies[i], false,
-                                       tmp, valid, err) < 0)
+        int ret = -1;
+        // The XSLT is used if the native evaluation cannot be done
+        if (evaluators && i < evaluators->size() && evaluators->at(i))
+        {
+            // Same as validate_xslt_from_memory
+            valid = true;
+            ret = check_policy_native(user, files, evaluators->at(i), media, tmp, err);
+            if (ret < 0)
+                tmp.clear();
+        }
+
+        if (ret < 0)
+            ret = validate_xslt_from_memory(user, files, options, policies[i], false, tmp, valid, err, &ma_doc);
+
+        if (ret < 0)
         {
             valid = false;
             Out << tmp;
@@ -989,9 +1043,41 @@ int Reports::check_policies_xslts(int user, const std::vector<long>& files,
                 valid = false;
         }
     }
+
+    release_media_area_doc(ma_doc);
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int Reports::check_policy_native(int user, const std::vector<long>& files, PolicyEvaluator* evaluator,
+                                 std::vector<PolicyEvaluatorMedia>& media, std::string& report, std::string& err)
+{
+    // The MediaInfo reports are shared by all the policies
+    if (media.size() != files.size())
+    {
+        media.clear();
+
+        std::vector<long> vec;
+        for (size_t i = 0; i < files.size(); ++i)
+        {
+            vec.clear();
+            vec.push_back(files[i]);
+
+            PolicyEvaluatorMedia m;
+            if (core->checker_file_from_id(user, files[i], m.ref, err) < 0)
+                return -1;
+
+            if (core->get_report_saved(user, vec, MediaConchLib::report_MediaInfo, MediaConchLib::format_Xml, "", m.mediainfo, err) < 0)
+                return -1;
+
+            get_content_of_media_in_xml(m.mediainfo);
+            media.push_back(m);
+        }
+    }
+
+    return evaluator->evaluate(media, report, err);
+}
+
 //***************************************************************************
 // Display
 //***************************************************************************
@@ -1028,11 +1114,12 @@ int Reports::transform_with_xslt_memory(const std::string& report, const std::st
                                         const std::map<std::string, std::string>& opts,
                                         std::string& result)
 {
-    Schema *S = new Xslt(!core->accepts_https());
+    Xslt *S = new Xslt(!core->accepts_https());
 
-    if (!S->register_schema_from_memory(memory))
+    if (!S->register_schema_from_cache(xslt_cache, memory))
     {
         result = report;
+        delete S;
         return -1;
     }
 
@@ -1041,6 +1128,7 @@ int Reports::transform_with_xslt_memory(const std::string& report, const std::st
     if (valid < 0)
     {
         result = report;
+        delete S;
         return -1;
     }
 
@@ -1093,10 +1181,11 @@ int Reports::transform_with_xslt_csv_memory(const std::string& report, std::stri
 int Reports::validate_xslt_from_memory(int user, const std::vector<long>& files,
                                        const std::map<std::string, std::string>& opts,
                                        const std::string& memory, bool is_implem,
-                                       std::string& report, bool& valid, std::string& err)
+                                       std::string& report, bool& valid, std::string& err,
+                                       MediaAreaDoc* ma_doc)
 {
     valid = true;
-    Schema *S = new Xslt(!core->accepts_https());
+    Xslt *S = new Xslt(!core->accepts_https());
 
     if (is_implem)
     {
@@ -1112,8 +1201,8 @@ int Reports::validate_xslt_from_memory(int user, const std::vector<long>& files,
     }
 
     int ret = 0;
-    if (S->register_schema_from_memory(memory))
-        ret = validation(user, files, S, report, valid, err);
+    if (S->register_schema_from_cache(xslt_cache, memory))
+        ret = validation(user, files, S, xslt_uses_micromediatrace(memory), report, valid, err, ma_doc);
     else
     {
         valid = false;
@@ -1132,16 +1221,26 @@ int Reports::validate_xslt_from_memory(int user, const std::vector<long>& files,
 }
 
 //---------------------------------------------------------------------------
-int Reports::validation(int user, const std::vector<long>& files, Schema* S,
-                        std::string& report, bool& valid, std::string& err)
+int Reports::validation(int user, const std::vector<long>& files, Schema* S, bool with_mmt,
+                        std::string& report, bool& valid, std::string& err, MediaAreaDoc* ma_doc)
 {
-    std::string xml;
-    if (create_report_ma_xml(user, files, S->get_options(), xml, get_bitset_with_mi_mmt(), err) < 0)
+    // Without a document of the request, only the cached one is shared
+    MediaAreaDoc tmp;
+    MediaAreaDoc *doc = ma_doc ? ma_doc : &tmp;
+
+    // Loaded again with the MicroMediaTrace, the next validations also use this one
+    if (doc->loaded && with_mmt && !doc->with_mmt)
+        release_media_area_doc(*doc);
+
+    if (!doc->loaded && get_media_area_doc(user, files, S->get_options(), with_mmt, *doc, err) < 0)
         return -1;
 
     valid = true;
 
-    int ret = S->validate_xml(xml);
+    int ret = doc->doc ? S->validate_xml_from_doc(doc->doc) : S->validate_xml(doc->xml);
+    if (!ma_doc)
+        release_media_area_doc(tmp);
+
     if (ret < 0)
     {
         valid = false;
@@ -1156,6 +1255,91 @@ int Reports::validation(int user, const std::vector<long>& files, Schema* S,
     return valid;
 }
 
+//---------------------------------------------------------------------------
+int Reports::get_media_area_doc(int user, const std::vector<long>& files, const std::map<std::string, std::string>& options,
+                                bool with_mmt, MediaAreaDoc& ma_doc, std::string& err)
+{
+    ma_doc.with_mmt = with_mmt;
+
+    // Only the documents of one file are kept between requests
+    if (doc_cache && files.size() == 1)
+    {
+        std::stringstream key;
+        key << user << ":" << files[0];
+        if (with_mmt)
+            key << ":mmt";
+        ma_doc.key = key.str();
+        ma_doc.version = doc_cache->get_version(ma_doc.key);
+        ma_doc.doc = doc_cache->acquire(ma_doc.key, ma_doc.version);
+        if (ma_doc.doc)
+        {
+            ma_doc.loaded = true;
+            return 0;
+        }
+    }
+
+    // The MicroMediaTrace, created from the file if not saved, only when the XSLT reads it
+    std::bitset<MediaConchLib::report_Max> bits = get_bitset_with_mi_mmt();
+    if (!with_mmt)
+        bits.reset(MediaConchLib::report_MicroMediaTrace);
+
+    std::string xml;
+    if (create_report_ma_xml(user, files, options, xml, bits, err) < 0)
+    {
+        release_media_area_doc(ma_doc);
+        return -1;
+    }
+
+    std::vector<std::string> errors;
+    ma_doc.doc = Xslt::parse_xml(xml, &errors);
+    // The errors are given by validate_xml()
+    if (!ma_doc.doc)
+        ma_doc.xml = xml;
+    ma_doc.loaded = true;
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+void Reports::release_media_area_doc(MediaAreaDoc& ma_doc)
+{
+    // Also without document, the cache knows nothing is built anymore
+    if (doc_cache && ma_doc.key.size())
+        doc_cache->release(ma_doc.key, ma_doc.version, (xmlDocPtr)ma_doc.doc);
+    else if (ma_doc.doc)
+        xmlFreeDoc((xmlDocPtr)ma_doc.doc);
+
+    ma_doc.doc = NULL;
+    ma_doc.xml.clear();
+    ma_doc.key.clear();
+    ma_doc.loaded = false;
+}
+
+//---------------------------------------------------------------------------
+void Reports::set_doc_cache_size(size_t size)
+{
+    delete doc_cache;
+    doc_cache = size ? new XmlDocCache(size) : NULL;
+}
+
+//---------------------------------------------------------------------------
+void Reports::reports_changed(int user, long file)
+{
+    if (!doc_cache)
+        return;
+
+    std::stringstream key;
+    key << user << ":" << file;
+    doc_cache->invalidate(key.str());
+    doc_cache->invalidate(key.str() + ":mmt");
+}
+
+//---------------------------------------------------------------------------
+void Reports::all_reports_changed()
+{
+    if (doc_cache)
+        doc_cache->invalidate_all();
+}
+
 //***************************************************************************
 // Helper
 //***************************************************************************
@@ -1180,6 +1364,14 @@ std::bitset<MediaConchLib::report_Max> Reports::get_bitset_with_mi_mmt()
     return bits;
 }
 
+//---------------------------------------------------------------------------
+bool Reports::xslt_uses_micromediatrace(const std::string& xslt)
+{
+    // The elements of the MicroMediaTrace are read with the mmt prefix, the policies rules with a mmt scope
+    // read mmt:MicroMediaTrace
+    return xslt.find("mmt:") != std::string::npos || xslt.find("MicroMediaTrace") != std::string::npos;
+}
+
 //---------------------------------------------------------------------------
 void Reports::unify_implementation_options(std::map<std::string, std::string>& opts)
 {
@@ -1196,7 +1388,7 @@ void Reports::unify_implementation_options(std::map<std::string, std::string>& o
 }
 
 //---------------------------------------------------------------------------
-void Reports::unify_policy_options(int user, std::map<std::string, std::string>& opts, std::string& err)
+void Reports::unify_policy_options(std::map<std::string, std::string>& opts, long& reference_id, std::string& reference_path)
 {
     std::map<std::string, std::string>::iterator it;
     if ((it = opts.find("policy_reference_id")) != opts.end())
@@ -1207,14 +1399,8 @@ void Reports::unify_policy_options(int user, std::map<std::string, std::string>&
         if (!file.length())
             return;
 
-        std::vector<long> files;
         char *end = NULL;
-        long file_id = strtol(file.c_str(), &end, 10);
-        files.push_back(file_id);
-
-        std::string report;
-        if (create_report_ma_xml(user, files, opts, report, get_bitset_with_mi_mmt(), err) < 0)
-            return;
+        reference_id = strtol(file.c_str(), &end, 10);
 
         std::string path = Core::get_local_data_path();
         path += "policies_references_files/";
@@ -1235,16 +1421,37 @@ void Reports::unify_policy_options(int user, std::map<std::string, std::string>&
             path = ss.str();
             break;
         }
-        ZenLib::File fd;
-
-        fd.Create(ZenLib::Ztring().From_UTF8(path));
-
-        fd.Open(ZenLib::Ztring().From_UTF8(path), ZenLib::File::Access_Write);
-        fd.Write(ZenLib::Ztring().From_UTF8(report));
-        fd.Close();
 
+        reference_path = path;
         opts["compare"] = "\"" + path + "\"";
     }
 }
 
+//---------------------------------------------------------------------------
+int Reports::create_policy_reference_file(int user, long reference_id, const std::string& path,
+                                          const std::map<std::string, std::string>& opts, bool with_mmt,
+                                          std::string& err)
+{
+    std::vector<long> files;
+    files.push_back(reference_id);
+
+    std::bitset<MediaConchLib::report_Max> bits = get_bitset_with_mi_mmt();
+    if (!with_mmt)
+        bits.reset(MediaConchLib::report_MicroMediaTrace);
+
+    std::string report;
+    if (create_report_ma_xml(user, files, opts, report, bits, err) < 0)
+        return -1;
+
+    ZenLib::File fd;
+
+    fd.Create(ZenLib::Ztring().From_UTF8(path));
+
+    fd.Open(ZenLib::Ztring().From_UTF8(path), ZenLib::File::Access_Write);
+    fd.Write(ZenLib::Ztring().From_UTF8(report));
+    fd.Close();
+
+    return 0;
+}
+
 }
@@ -26,6 +26,10 @@ namespace MediaConch {
 
 class Core;
 class Schema;
+class XsltCache;
+class XmlDocCache;
+class PolicyEvaluator;
+struct PolicyEvaluatorMedia;
 
 //***************************************************************************
 // Struct Checker Report
@@ -47,6 +51,23 @@ struct CheckerReport
     MediaConchLib::format                   format;
 };
 
+//***************************************************************************
+// Struct MediaAreaDoc
+//***************************************************************************
+
+// MediaArea XML of files parsed once for all the validations of a request
+struct MediaAreaDoc
+{
+    MediaAreaDoc() : doc(NULL), version(0), loaded(false), with_mmt(false) {}
+
+    void                                   *doc;
+    std::string                             xml;     // Kept if it cannot be parsed
+    std::string                             key;     // Set if the document comes from the cache
+    size_t                                  version;
+    bool                                    loaded;
+    bool                                    with_mmt; // The MicroMediaTrace is in the document
+};
+
 //***************************************************************************
 // Class Report
 //***************************************************************************
@@ -108,7 +129,10 @@ public:
     int   check_policies_xslts(int user, const std::vector<long>& files,
                                const std::map<std::string, std::string>& options,
                                const std::vector<std::string>& policies,
-                               std::stringstream& Out, bool& valid, std::string& err);
+                               std::stringstream& Out, bool& valid, std::string& err,
+                               const std::vector<PolicyEvaluator*>* evaluators = NULL);
+    int   check_policy_native(int user, const std::vector<long>& files, PolicyEvaluator* evaluator,
+                              std::vector<PolicyEvaluatorMedia>& media, std::string& report, std::string& err);
 
     // Display
     int   transform_with_xslt_file(const std::string& report, const std::string& Xslt,
@@ -122,18 +146,34 @@ public:
 
     // Validation
     int   validate_xslt_from_memory(int user, const std::vector<long>& files, const std::map<std::string, std::string>& opts,
-                                    const std::string& memory, bool is_implem, std::string& report, bool& valid, std::string& err);
-    int   validation(int user, const std::vector<long>& files, Schema* S,
-                     std::string& report, bool& valid, std::string& err);
+                                    const std::string& memory, bool is_implem, std::string& report, bool& valid, std::string& err,
+                                    MediaAreaDoc* ma_doc = NULL);
+    int   validation(int user, const std::vector<long>& files, Schema* S, bool with_mmt,
+                     std::string& report, bool& valid, std::string& err, MediaAreaDoc* ma_doc = NULL);
+    int   get_media_area_doc(int user, const std::vector<long>& files, const std::map<std::string, std::string>& options,
+                             bool with_mmt, MediaAreaDoc& ma_doc, std::string& err);
+    void  release_media_area_doc(MediaAreaDoc& ma_doc);
+
+    // Parsed documents kept between requests, 0 to disable
+    void  set_doc_cache_size(size_t size);
+    void  reports_changed(int user, long file);
+    void  all_reports_changed();
 
     // Helper
     std::bitset<MediaConchLib::report_Max> get_bitset_with_mi_mt();
     std::bitset<MediaConchLib::report_Max> get_bitset_with_mi_mmt();
     void  unify_implementation_options(std::map<std::string, std::string>& opts);
-    void  unify_policy_options(int user, std::map<std::string, std::string>& opts, std::string& err);
+    // The reference file is written by create_policy_reference_file() once the policies are known
+    void  unify_policy_options(std::map<std::string, std::string>& opts, long& reference_id, std::string& reference_path);
+    int   create_policy_reference_file(int user, long reference_id, const std::string& path,
+                                       const std::map<std::string, std::string>& opts, bool with_mmt, std::string& err);
+    // The XSLT reads the MicroMediaTrace, it must be in the MediaArea XML
+    static bool xslt_uses_micromediatrace(const std::string& xslt);
 
 private:
-    Core *core;
+    Core        *core;
+    XsltCache   *xslt_cache;
+    XmlDocCache *doc_cache;
 
     void  xml_escape_attributes(std::string& xml);
 };
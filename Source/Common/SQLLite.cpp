@@ -41,6 +41,7 @@ SQLLite::SQLLite()
 //---------------------------------------------------------------------------
 SQLLite::~SQLLite()
 {
+    finalize_statements();
     if (db)
         sqlite3_close(db);
 }
@@ -60,6 +61,55 @@ int SQLLite::init(const std::string& db_dirname, const std::string& db_filename)
         db = NULL;
         return -1;
     }
+
+    if (apply_pragmas() < 0)
+    {
+        sqlite3_close(db);
+        db = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int SQLLite::apply_pragmas()
+{
+    std::map<std::string, std::string>::iterator it = pragmas.begin();
+    for (; it != pragmas.end(); ++it)
+    {
+        // Values are written in the query, only keep simple words and numbers
+        bool is_valid = it->second.size() > 0;
+        for (size_t i = 0; is_valid && i < it->second.size(); ++i)
+        {
+            char c = it->second[i];
+            is_valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || (!i && c == '-');
+        }
+
+        if (!is_valid)
+        {
+            error = "Invalid value for PRAGMA " + it->first + ": " + it->second;
+            return -1;
+        }
+
+        reports.clear();
+        query = "PRAGMA " + it->first + "=" + it->second + ";";
+
+        const char* end = NULL;
+        int ret = sqlite3_prepare_v2(db, query.c_str(), query.length() + 1, &stmt, &end);
+        if (ret != SQLITE_OK || !stmt || (end && *end))
+        {
+            error = "Cannot apply " + query;
+            if (stmt)
+                sqlite3_finalize(stmt);
+            stmt = NULL;
+            return -1;
+        }
+
+        if (execute() < 0)
+            return -1;
+    }
+
+    reports.clear();
     return 0;
 }
 
@@ -97,7 +147,22 @@ int SQLLite::execute()
         }
     }
 
-    sqlite3_finalize(stmt);
+    // Statements from the cache are kept for the next same query
+    std::map<std::string, sqlite3_stmt*>::iterator it = statements.find(query);
+    if (it == statements.end() || it->second != stmt)
+    {
+        for (it = statements.begin(); it != statements.end(); ++it)
+            if (it->second == stmt)
+                break;
+    }
+
+    if (it != statements.end())
+    {
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+    }
+    else
+        sqlite3_finalize(stmt);
     stmt = NULL;
     if(ret == SQLITE_DONE)
         return 0;
@@ -184,6 +249,16 @@ std::string SQLLite::get_sqlite_error(int err)
 //---------------------------------------------------------------------------
 int SQLLite::prepare_v2(std::string& query, std::string& err)
 {
+    std::map<std::string, sqlite3_stmt*>::iterator it = statements.find(query);
+    if (it != statements.end())
+    {
+        // Also needed if the previous use stopped before its execution
+        stmt = it->second;
+        sqlite3_reset(stmt);
+        sqlite3_clear_bindings(stmt);
+        return 0;
+    }
+
     const char* end = NULL;
     int ret = sqlite3_prepare_v2(db, query.c_str(), query.length() + 1, &stmt, &end);
     if (ret != SQLITE_OK || !stmt || (end && *end))
@@ -192,12 +267,29 @@ int SQLLite::prepare_v2(std::string& query, std::string& err)
             err = get_sqlite_error(ret);
         else
             err = "Internal error when creating SQLLite query.";
+        if (stmt)
+            sqlite3_finalize(stmt);
+        stmt = NULL;
         return -1;
     }
 
+    // Queries built with variable parts are not all kept
+    if (statements.size() < max_statements)
+        statements[query] = stmt;
+
     return 0;
 }
 
+//---------------------------------------------------------------------------
+void SQLLite::finalize_statements()
+{
+    std::map<std::string, sqlite3_stmt*>::iterator it = statements.begin();
+    for (; it != statements.end(); ++it)
+        sqlite3_finalize(it->second);
+    statements.clear();
+    stmt = NULL;
+}
+
 }
 
 #endif
@@ -36,6 +36,9 @@ public:
     SQLLite();
     virtual ~SQLLite();
 
+    // PRAGMA name and value applied when the database is opened (journal_mode, synchronous...)
+    void set_pragmas(const std::map<std::string, std::string>& p) { pragmas = p; }
+
 protected:
     virtual int execute();
     virtual int init(const std::string& db_dirname, const std::string& db_filename);
@@ -45,6 +48,8 @@ protected:
     std::string                                      error;
     sqlite3                                         *db;
     sqlite3_stmt                                    *stmt; // Statement handler
+    std::map<std::string, sqlite3_stmt*>             statements; // Prepared statements kept by query
+    std::map<std::string, std::string>               pragmas;
 
     // Helper
     long                std_string_to_int(const std::string& str);
@@ -54,6 +59,10 @@ protected:
     const std::string&  get_error() const;
     std::string         get_sqlite_error(int err);
     int                 prepare_v2(std::string& query, std::string& err);
+    int                 apply_pragmas();
+    void                finalize_statements();
+
+    static const size_t max_statements = 128;
 
     SQLLite (const SQLLite&);
     SQLLite& operator=(const SQLLite&);
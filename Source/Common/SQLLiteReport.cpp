@@ -27,7 +27,7 @@ namespace MediaConch {
 // SQLLiteReport
 //***************************************************************************
 
-int SQLLiteReport::current_report_version = 7;
+int SQLLiteReport::current_report_version = 13;
 
 //***************************************************************************
 // Constructor/Destructor
@@ -59,6 +59,29 @@ int SQLLiteReport::init_report()
     return create_report_table();
 }
 
+//---------------------------------------------------------------------------
+DatabaseReport* SQLLiteReport::open_reader(std::string& err)
+{
+    SQLLiteReport* reader = new SQLLiteReport;
+
+    // The journal mode is kept in the database, the tables are already created
+    reader->pragmas = pragmas;
+    reader->pragmas.erase("journal_mode");
+    reader->pragmas["query_only"] = "1";
+    reader->db_dirname = db_dirname;
+    reader->db_filename = db_filename;
+    reader->report_version = report_version;
+
+    if (reader->init() < 0)
+    {
+        err = reader->get_error();
+        delete reader;
+        return NULL;
+    }
+
+    return reader;
+}
+
 //---------------------------------------------------------------------------
 int SQLLiteReport::create_report_table()
 {
@@ -120,6 +143,12 @@ int SQLLiteReport::update_report_table()
     UPDATE_REPORT_TABLE_FOR_VERSION(4);
     UPDATE_REPORT_TABLE_FOR_VERSION(5);
     UPDATE_REPORT_TABLE_FOR_VERSION(6);
+    UPDATE_REPORT_TABLE_FOR_VERSION(7);
+    UPDATE_REPORT_TABLE_FOR_VERSION(8);
+    UPDATE_REPORT_TABLE_FOR_VERSION(9);
+    UPDATE_REPORT_TABLE_FOR_VERSION(10);
+    UPDATE_REPORT_TABLE_FOR_VERSION(11);
+    UPDATE_REPORT_TABLE_FOR_VERSION(12);
 
 #undef UPDATE_REPORT_TABLE_FOR_VERSION
 
@@ -743,6 +772,211 @@ int SQLLiteReport::update_file_error(int user, long id, std::string& err, bool h
     return execute();
 }
 
+int SQLLiteReport::update_file_fingerprint(int user, long id, const std::string& fingerprint, std::string& err)
+{
+    reports.clear();
+    query = "UPDATE MEDIACONCH_FILE SET FINGERPRINT = ? WHERE ID = ? AND USER = ?;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_text(stmt, 1, fingerprint.c_str(), fingerprint.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 2, id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 3, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    return execute();
+}
+
+int SQLLiteReport::update_file_full_fingerprint(int user, long id, const std::string& fingerprint, std::string& err)
+{
+    reports.clear();
+    query = "UPDATE MEDIACONCH_FILE SET FULL_FINGERPRINT = ? WHERE ID = ? AND USER = ?;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_text(stmt, 1, fingerprint.c_str(), fingerprint.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 2, id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 3, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    return execute();
+}
+
+int SQLLiteReport::get_file_full_fingerprint(int user, long id, std::string& fingerprint, std::string& err)
+{
+    reports.clear();
+    query = "SELECT FULL_FINGERPRINT FROM MEDIACONCH_FILE WHERE ID = ? AND USER = ?;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_int(stmt, 1, id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 2, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    if (!reports.size() || reports[0].find("FULL_FINGERPRINT") == reports[0].end())
+    {
+        err = "File not found";
+        return -1;
+    }
+
+    fingerprint = reports[0]["FULL_FINGERPRINT"];
+    return 0;
+}
+
+long SQLLiteReport::get_file_id_from_fingerprint(const std::string& fingerprint, const std::string& options,
+                                                 long exclude_id, int& user, std::string& err)
+{
+    std::stringstream create;
+
+    // Files of any user, only the ones analyzed without error, without generated files
+    // and without the reports of the plugins
+    reports.clear();
+    create << "SELECT ID, USER FROM MEDIACONCH_FILE";
+    create << " WHERE FINGERPRINT = ? AND OPTIONS = ? AND ID != ? AND ANALYZED = 1 AND HAS_ERROR = 0";
+    create << " AND SOURCE_ID = -1 AND IFNULL(LENGTH(GENERATED_ID), 0) = 0";
+    create << " AND ID NOT IN (SELECT FILE_ID FROM MEDIACONCH_REPORT WHERE TOOL = ? OR TOOL = ?) LIMIT 1;";
+    query = create.str();
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_text(stmt, 1, fingerprint.c_str(), fingerprint.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 2, options.c_str(), options.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 3, exclude_id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 4, (int)MediaConchLib::report_MediaVeraPdf);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 5, (int)MediaConchLib::report_MediaDpfManager);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    if (!reports.size() || reports[0].find("ID") == reports[0].end() || reports[0].find("USER") == reports[0].end())
+        return -1;
+
+    user = std_string_to_int(reports[0]["USER"]);
+    return std_string_to_int(reports[0]["ID"]);
+}
+
+int SQLLiteReport::copy_reports(int src_user, long src_id, int user, long id, std::string& err)
+{
+    if (!file_id_match_user(src_user, src_id, err) || !file_id_match_user(user, id, err))
+    {
+        err = "File ID is not matching the user.";
+        return -1;
+    }
+
+    std::stringstream create;
+
+    // The reports are copied as saved, without being uncompressed
+    reports.clear();
+    create << "INSERT OR REPLACE INTO MEDIACONCH_REPORT";
+    create << " (FILE_ID, TOOL, FORMAT, OPTIONS, REPORT, COMPRESS, MIL_VERSION, UNCOMPRESSED_SIZE, DICTIONARY_ID)";
+    create << " SELECT ?, TOOL, FORMAT, OPTIONS, REPORT, COMPRESS, MIL_VERSION, UNCOMPRESSED_SIZE, DICTIONARY_ID";
+    create << " FROM MEDIACONCH_REPORT WHERE FILE_ID = ?;";
+    query = create.str();
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_int(stmt, 1, id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 2, src_id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    return execute();
+}
+
 bool SQLLiteReport::file_id_match_user(int user, long id, std::string& err)
 {
     std::stringstream create;
@@ -904,7 +1138,7 @@ int SQLLiteReport::remove_all_files(int user, std::string& err)
 int SQLLiteReport::save_report(int user, long file_id, MediaConchLib::report report_kind, MediaConchLib::format format,
                                const std::string& options,
                                const std::string& report, MediaConchLib::compression compress,
-                               int mil_version, std::string& err)
+                               size_t uncompressed_size, int mil_version, int dictionary_id, std::string& err)
 {
     std::stringstream create;
 
@@ -919,12 +1153,13 @@ int SQLLiteReport::save_report(int user, long file_id, MediaConchLib::report rep
         return -1;
 
     if (registered)
-        return update_report(user, file_id, report_kind, format, options, report, compress, mil_version, err);
+        return update_report(user, file_id, report_kind, format, options, report, compress, uncompressed_size,
+                             mil_version, dictionary_id, err);
 
     reports.clear();
     create << "INSERT INTO MEDIACONCH_REPORT";
-    create << " (FILE_ID, TOOL, FORMAT, OPTIONS, REPORT, COMPRESS, MIL_VERSION)";
-    create << " VALUES (?, ?, ?, ?, ?, ?, ?);";
+    create << " (FILE_ID, TOOL, FORMAT, OPTIONS, REPORT, COMPRESS, MIL_VERSION, UNCOMPRESSED_SIZE, DICTIONARY_ID)";
+    create << " VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
     query = create.str();
 
     if (prepare_v2(query, err) < 0)
@@ -979,19 +1214,33 @@ int SQLLiteReport::save_report(int user, long file_id, MediaConchLib::report rep
         return -1;
     }
 
+    ret = sqlite3_bind_int64(stmt, 8, (sqlite3_int64)uncompressed_size);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 9, dictionary_id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
     return execute();
 }
 
 int SQLLiteReport::update_report(int, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                                  const std::string& options,
                                  const std::string& report, MediaConchLib::compression compress,
-                                 int mil_version, std::string& err)
+                                 size_t uncompressed_size, int mil_version, int dictionary_id, std::string& err)
 {
     std::stringstream create;
 
     reports.clear();
     create << "UPDATE MEDIACONCH_REPORT ";
-    create << "SET REPORT = ?, COMPRESS = ?, MIL_VERSION = ? ";
+    create << "SET REPORT = ?, COMPRESS = ?, MIL_VERSION = ?, UNCOMPRESSED_SIZE = ?, DICTIONARY_ID = ? ";
     create << "WHERE FILE_ID = ? AND TOOL = ? AND FORMAT = ? ";
     create << "AND OPTIONS = ?;";
     query = create.str();
@@ -1020,28 +1269,42 @@ int SQLLiteReport::update_report(int, long file_id, MediaConchLib::report report
         return -1;
     }
 
-    ret = sqlite3_bind_int(stmt, 4, file_id);
+    ret = sqlite3_bind_int64(stmt, 4, (sqlite3_int64)uncompressed_size);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 5, dictionary_id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 6, file_id);
     if (ret != SQLITE_OK)
     {
         err = get_sqlite_error(ret);
         return -1;
     }
 
-    ret = sqlite3_bind_int(stmt, 5, (int)reportKind);
+    ret = sqlite3_bind_int(stmt, 7, (int)reportKind);
     if (ret != SQLITE_OK)
     {
         err = get_sqlite_error(ret);
         return -1;
     }
 
-    ret = sqlite3_bind_int(stmt, 6, (int)format);
+    ret = sqlite3_bind_int(stmt, 8, (int)format);
     if (ret != SQLITE_OK)
     {
         err = get_sqlite_error(ret);
         return -1;
     }
 
-    ret = sqlite3_bind_text(stmt, 7, options.c_str(), options.size(), SQLITE_STATIC);
+    ret = sqlite3_bind_text(stmt, 9, options.c_str(), options.size(), SQLITE_STATIC);
     if (ret != SQLITE_OK)
     {
         err = get_sqlite_error(ret);
@@ -1118,7 +1381,8 @@ int SQLLiteReport::remove_all_reports(int user, std::string& err)
 
 int SQLLiteReport::get_report(int user, long file_id, MediaConchLib::report report_kind,
                               MediaConchLib::format format, const std::string& options,
-                              std::string& report, MediaConchLib::compression& compress, std::string& err)
+                              std::string& report, MediaConchLib::compression& compress,
+                              size_t& uncompressed_size, int& dictionary_id, std::string& err)
 {
     if (!file_id_match_user(user, file_id, err))
     {
@@ -1129,7 +1393,7 @@ int SQLLiteReport::get_report(int user, long file_id, MediaConchLib::report repo
     std::stringstream create;
 
     reports.clear();
-    create << "SELECT REPORT, COMPRESS FROM MEDIACONCH_REPORT WHERE ";
+    create << "SELECT REPORT, COMPRESS, UNCOMPRESSED_SIZE, DICTIONARY_ID FROM MEDIACONCH_REPORT WHERE ";
     create << "FILE_ID = ? ";
     create << "AND TOOL = ? ";
     create << "AND FORMAT = ?";
@@ -1173,22 +1437,33 @@ int SQLLiteReport::get_report(int user, long file_id, MediaConchLib::report repo
         return -1;
     }
 
-    std::map<std::string, std::string> r = reports[0];
+    std::map<std::string, std::string>& r = reports[0];
 
     if (r.find("REPORT") == r.end())
     {
         err = "No report found";
         return -1;
     }
-    report += r["REPORT"];
+
+    // Reports can be big, avoid a copy
+    if (report.empty())
+        report.swap(r["REPORT"]);
+    else
+        report += r["REPORT"];
+
+    uncompressed_size = 0;
+    if (r.find("UNCOMPRESSED_SIZE") != r.end())
+        uncompressed_size = std_string_to_uint(r["UNCOMPRESSED_SIZE"]);
+
+    dictionary_id = -1;
+    if (r.find("DICTIONARY_ID") != r.end())
+        dictionary_id = (int)std_string_to_int(r["DICTIONARY_ID"]);
 
     if (r.find("COMPRESS") != r.end())
     {
-        const std::string& c = r["COMPRESS"];
-        if (c == "0")
-            compress = MediaConchLib::compression_None;
-        else if (c == "1")
-            compress = MediaConchLib::compression_ZLib;
+        long c = std_string_to_int(r["COMPRESS"]);
+        if (c > 0 && c < MediaConchLib::compression_Max)
+            compress = (MediaConchLib::compression)c;
         else
             compress = MediaConchLib::compression_None;
     }
@@ -1421,6 +1696,272 @@ int SQLLiteReport::get_element_report_kind(int user, long file_id, MediaConchLib
     return 0;
 }
 
+//---------------------------------------------------------------------------
+int SQLLiteReport::get_watch_folder_user(const std::string& folder, long& user, std::string& err)
+{
+    std::string key("USER");
+
+    reports.clear();
+    query = "SELECT USER FROM MEDIACONCH_WATCH_FOLDER_FILE WHERE FOLDER = ? LIMIT 1;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_text(stmt, 1, folder.c_str(), folder.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    if (!reports.size() || reports[0].find(key) == reports[0].end())
+    {
+        err = "Folder not watched before.";
+        return -1;
+    }
+
+    user = std_string_to_int(reports[0][key]);
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::get_watch_folder_files(int user, const std::string& folder,
+                                          std::vector<DatabaseWatchFolderFile>& files, std::string& err)
+{
+    reports.clear();
+    query = "SELECT FILENAME, FILE_LAST_MODIFICATION, FILE_SIZE, STATE, FILE_ID"
+            " FROM MEDIACONCH_WATCH_FOLDER_FILE WHERE USER = ? AND FOLDER = ?;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_int(stmt, 1, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 2, folder.c_str(), folder.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    files.reserve(files.size() + reports.size());
+    for (size_t i = 0; i < reports.size(); ++i)
+    {
+        DatabaseWatchFolderFile file;
+        file.filename = reports[i]["FILENAME"];
+        file.file_last_modification = reports[i]["FILE_LAST_MODIFICATION"];
+        file.file_size = std_string_to_uint(reports[i]["FILE_SIZE"]);
+        file.state = std_string_to_int(reports[i]["STATE"]);
+        file.file_id = std_string_to_int(reports[i]["FILE_ID"]);
+        files.push_back(file);
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::save_watch_folder_file(int user, const std::string& folder, const DatabaseWatchFolderFile& file,
+                                          std::string& err)
+{
+    std::stringstream create;
+
+    reports.clear();
+    create << "INSERT OR REPLACE INTO MEDIACONCH_WATCH_FOLDER_FILE";
+    create << " (USER, FOLDER, FILENAME, FILE_LAST_MODIFICATION, FILE_SIZE, STATE, FILE_ID)";
+    create << " VALUES (?, ?, ?, ?, ?, ?, ?);";
+    query = create.str();
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_int(stmt, 1, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 2, folder.c_str(), folder.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 3, file.filename.c_str(), file.filename.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 4, file.file_last_modification.c_str(), file.file_last_modification.size(),
+                            SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int64(stmt, 5, (sqlite3_int64)file.file_size);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 6, file.state);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_int(stmt, 7, file.file_id);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::remove_watch_folder_file(int user, const std::string& folder, const std::string& filename,
+                                            std::string& err)
+{
+    reports.clear();
+    query = "DELETE FROM MEDIACONCH_WATCH_FOLDER_FILE WHERE USER = ? AND FOLDER = ? AND FILENAME = ?;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_int(stmt, 1, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 2, folder.c_str(), folder.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 3, filename.c_str(), filename.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::remove_watch_folder(int user, const std::string& folder, std::string& err)
+{
+    reports.clear();
+    query = "DELETE FROM MEDIACONCH_WATCH_FOLDER_FILE WHERE USER = ? AND FOLDER = ?;";
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    int ret = sqlite3_bind_int(stmt, 1, user);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    ret = sqlite3_bind_text(stmt, 2, folder.c_str(), folder.size(), SQLITE_STATIC);
+    if (ret != SQLITE_OK)
+    {
+        err = get_sqlite_error(ret);
+        return -1;
+    }
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::begin_batch(std::string& err)
+{
+    // Savepoints can be nested, the outermost one is the transaction
+    return execute_batch_query("SAVEPOINT MEDIACONCH_BATCH;", err);
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::commit_batch(std::string& err)
+{
+    return execute_batch_query("RELEASE MEDIACONCH_BATCH;", err);
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::rollback_batch(std::string& err)
+{
+    if (execute_batch_query("ROLLBACK TO MEDIACONCH_BATCH;", err) < 0)
+        return -1;
+
+    return execute_batch_query("RELEASE MEDIACONCH_BATCH;", err);
+}
+
+//---------------------------------------------------------------------------
+int SQLLiteReport::execute_batch_query(const char* batch_query, std::string& err)
+{
+    reports.clear();
+    query = batch_query;
+
+    if (prepare_v2(query, err) < 0)
+        return -1;
+
+    if (execute() < 0)
+    {
+        err = error;
+        return -1;
+    }
+
+    return 0;
+}
+
 }
 
 #endif
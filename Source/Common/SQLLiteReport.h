@@ -68,21 +68,28 @@ public:
     virtual int  add_file_generated_id(int user, long source_id, long generated_id, std::string& err);
     virtual int  update_file_analyzed(int user, long id, std::string& err, bool analyzed=true);
     virtual int  update_file_error(int user, long id, std::string& err, bool has_error=true, const std::string& error_log="");
+    virtual int  update_file_fingerprint(int user, long id, const std::string& fingerprint, std::string& err);
+    virtual int  update_file_full_fingerprint(int user, long id, const std::string& fingerprint, std::string& err);
+    virtual int  get_file_full_fingerprint(int user, long id, std::string& fingerprint, std::string& err);
+    virtual long get_file_id_from_fingerprint(const std::string& fingerprint, const std::string& options, long exclude_id,
+                                              int& user, std::string& err);
+    virtual int  copy_reports(int src_user, long src_id, int user, long id, std::string& err);
 
     // Report
     virtual int  save_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                              const std::string& options,
-                             const std::string& report, MediaConchLib::compression,
-                             int mil_version, std::string& err);
+                             const std::string& report, MediaConchLib::compression, size_t uncompressed_size,
+                             int mil_version, int dictionary_id, std::string& err);
     virtual int  update_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                                const std::string& options,
-                               const std::string& report, MediaConchLib::compression,
-                               int mil_version, std::string& err);
+                               const std::string& report, MediaConchLib::compression, size_t uncompressed_size,
+                               int mil_version, int dictionary_id, std::string& err);
     virtual int  remove_report(int user, long filename, std::string& err);
     virtual int  remove_all_reports(int user, std::string& err);
     virtual int  get_report(int user, long file_id, MediaConchLib::report reportKind, MediaConchLib::format format,
                             const std::string& options,
-                            std::string& report, MediaConchLib::compression&, std::string& err);
+                            std::string& report, MediaConchLib::compression&, size_t& uncompressed_size,
+                            int& dictionary_id, std::string& err);
     virtual int  report_is_registered(int user, long file_id, MediaConchLib::report reportKind,
                                       MediaConchLib::format format, const std::string& options,
                                       bool& registered, std::string& err);
@@ -91,6 +98,24 @@ public:
     virtual int  get_elements(int user, std::vector<long>& vec, std::string& err);
     virtual int  get_element_report_kind(int user, long file_id, MediaConchLib::report& report_kind, std::string& err);
 
+    // Watch folder
+    virtual int  get_watch_folder_user(const std::string& folder, long& user, std::string& err);
+    virtual int  get_watch_folder_files(int user, const std::string& folder,
+                                        std::vector<DatabaseWatchFolderFile>& files, std::string& err);
+    virtual int  save_watch_folder_file(int user, const std::string& folder, const DatabaseWatchFolderFile& file,
+                                        std::string& err);
+    virtual int  remove_watch_folder_file(int user, const std::string& folder, const std::string& filename,
+                                          std::string& err);
+    virtual int  remove_watch_folder(int user, const std::string& folder, std::string& err);
+
+    // Batch
+    virtual int  begin_batch(std::string& err);
+    virtual int  commit_batch(std::string& err);
+    virtual int  rollback_batch(std::string& err);
+
+    // Reader
+    virtual DatabaseReport* open_reader(std::string& err);
+
 protected:
     virtual int init();
     virtual int init_report();
@@ -101,6 +126,7 @@ private:
 
     bool          file_id_match_user(int user, long file_id, std::string& err);
     int           get_generated_id(int user, long id, std::vector<long>& generated_id, std::string& err);
+    int           execute_batch_query(const char* batch_query, std::string& err);
 
     SQLLiteReport (const SQLLiteReport&);
     SQLLiteReport& operator=(const SQLLiteReport&);
@@ -41,7 +41,9 @@ namespace MediaConch {
     //***************************************************************************
 
     //---------------------------------------------------------------------------
-    Scheduler::Scheduler(Core* c) : core(c), max_threads_modified(false), max_threads(1)
+    Scheduler::Scheduler(Core* c) : core(c), max_threads(get_hardware_concurrency()), max_threads_modified(false),
+                                    events_last(-1), idle_workers(0), wakeups_pending(0),
+                                    running_workers(0), stopping(false)
     {
         queue = new Queue(this);
     }
@@ -49,54 +51,185 @@ namespace MediaConch {
     //---------------------------------------------------------------------------
     Scheduler::~Scheduler()
     {
-        queue->clear();
         CS.Enter();
+        queue->clear();
         std::map<QueueElement*, QueueElement*>::iterator it = working.begin();
         for (; it != working.end(); ++it)
-        {
             if (it->first)
-            {
                 it->first->stop();
-                delete it->first;
-            }
+        CS.Leave();
+
+        // Workers delete their current element before leaving
+        queue_cond.lock();
+        stopping = true;
+        queue_cond.broadcast();
+        while (running_workers)
+            queue_cond.wait();
+        queue_cond.unlock();
+
+        // ZenLib threads are detached, only their exit is left to wait for
+        for (size_t i = 0; i < workers.size(); ++i)
+        {
+            while (!workers[i]->IsExited())
+                ZenLib::Thread::Yield();
+            delete workers[i];
         }
+        workers.clear();
         working.clear();
-        CS.Leave();
         delete queue;
     }
 
+    //***************************************************************************
+    // Workers
+    //***************************************************************************
+
+    //---------------------------------------------------------------------------
+    void SchedulerWorker::Entry()
+    {
+        scheduler->worker_loop();
+    }
+
+    //---------------------------------------------------------------------------
+    size_t Scheduler::get_hardware_concurrency()
+    {
+#if defined(_WIN32) || defined(WIN32)
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        long nb = (long)info.dwNumberOfProcessors;
+#else
+        long nb = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+        if (nb <= 0)
+            return 1;
+        return (size_t)nb;
+    }
+
+    //---------------------------------------------------------------------------
+    void Scheduler::worker_loop()
+    {
+        while (true)
+        {
+            QueueElement *el = NULL;
+
+            queue_cond.lock();
+            while (!stopping && (el = next_element()) == NULL)
+            {
+                ++idle_workers;
+                queue_cond.wait();
+                --idle_workers;
+                if (wakeups_pending)
+                    --wakeups_pending;
+            }
+            queue_cond.unlock();
+
+            if (!el)
+                break;
+
+            el->run();
+
+            CS.Enter();
+            remove_element(el);
+            CS.Leave();
+            delete el;
+        }
+
+        queue_cond.lock();
+        --running_workers;
+        if (stopping)
+            queue_cond.broadcast();
+        queue_cond.unlock();
+    }
+
+    //---------------------------------------------------------------------------
+    QueueElement *Scheduler::next_element()
+    {
+        QueueElement *el = NULL;
+
+        CS.Enter();
+        if (working.size() < max_threads)
+            el = queue->pop_next();
+        if (el)
+            working[el] = el;
+        CS.Leave();
+
+        return el;
+    }
+
     //---------------------------------------------------------------------------
     int Scheduler::add_element_to_queue(int user, const std::string& filename, long file_id,
                                         const std::vector<std::pair<std::string,std::string> >& options,
                                         const std::vector<std::string>& plugins, bool mil_analyze,
-                                        const std::string& alias)
+                                        const std::string& alias, bool reuse_analysis)
     {
-        static int index = 0;
+        return queue_element(user, filename, file_id, options, plugins, mil_analyze, alias, false, reuse_analysis);
+    }
+
+    int Scheduler::add_trace_to_queue(int user, const std::string& filename, long file_id,
+                                      const std::vector<std::pair<std::string,std::string> >& options)
+    {
+        CS.Enter();
+        bool exists = queue->has_trace_element(user, file_id);
+        std::map<QueueElement*, QueueElement*>::iterator it = working.begin();
+        for (; !exists && it != working.end(); ++it)
+            if (it->first->trace_only && it->first->file_id == file_id && it->first->user == user)
+                exists = true;
+        CS.Leave();
+
+        if (exists)
+            return 0;
 
-        queue->add_element(PRIORITY_NONE, index++, user, filename, file_id, options, plugins, mil_analyze, alias);
-        run_element();
-        return index - 1;
+        return queue_element(user, filename, file_id, options, std::vector<std::string>(), true, "", true);
     }
 
-    //---------------------------------------------------------------------------
-    void Scheduler::run_element()
+    bool Scheduler::mediatrace_is_on_demand() const
+    {
+        return core->mediatrace_on_demand_is_enabled();
+    }
+
+    bool Scheduler::reuse_analysis_of_same_content(QueueElement *el)
+    {
+        // The MediaTrace and the generated files are always parsed
+        if (el->trace_only || el->real_filename != el->filename)
+            return false;
+
+        return core->reuse_analysis_of_same_content(el->user, el->real_filename, el->file_id, el->reuse_analysis);
+    }
+
+    int Scheduler::queue_element(int user, const std::string& filename, long file_id,
+                                 const std::vector<std::pair<std::string,std::string> >& options,
+                                 const std::vector<std::string>& plugins, bool mil_analyze,
+                                 const std::string& alias, bool trace_only, bool reuse_analysis)
     {
+        static int index = 0;
+
+        // A client waits for the MediaTrace
         CS.Enter();
-        if (working.size() >= max_threads)
+        int id = index++;
+        queue->add_element(trace_only ? PRIORITY_HIGH : PRIORITY_NONE, id, user, filename, file_id, options,
+                           plugins, mil_analyze, alias, trace_only, reuse_analysis);
+        CS.Leave();
+
+        // Wake up an idle worker not already signaled, or grow the pool up to max_threads
+        queue_cond.lock();
+        if (idle_workers > wakeups_pending)
         {
-            CS.Leave();
-            return;
+            ++wakeups_pending;
+            queue_cond.signal();
         }
-
-        QueueElement *ret = queue->run_next();
-        if (!ret)
+        else if (workers.size() < max_threads && !stopping)
         {
-            CS.Leave();
-            return;
+            SchedulerWorker *worker = new SchedulerWorker(this);
+            if (worker->Run() == ZenLib::Thread::Ok)
+            {
+                workers.push_back(worker);
+                ++running_workers;
+            }
+            else
+                delete worker;
         }
+        queue_cond.unlock();
 
-        working[ret] = ret;
-        CS.Leave();
+        return id;
     }
 
     void Scheduler::work_finished(QueueElement *el, MediaInfoNameSpace::MediaInfo* MI)
@@ -104,14 +237,23 @@ namespace MediaConch {
         if (!el)
             return;
 
-        core->set_file_analyzed_to_database(el->user, el->file_id);
-
         if (!MI)
+        {
+            core->set_file_analyzed_to_database(el->user, el->file_id);
+            CS.Enter();
+            remove_element(el);
+            CS.Leave();
+            notify_finished();
+            return;
+        }
+
+        if (el->trace_only)
         {
             CS.Enter();
+            core->register_trace_to_database(el->user, el->file_id, MI);
             remove_element(el);
             CS.Leave();
-            run_element();
+            notify_finished();
             return;
         }
 
@@ -122,16 +264,16 @@ namespace MediaConch {
             return;
 
         CS.Enter();
-        core->register_reports_to_database(el->user, el->file_id, MI);
+        core->register_reports_to_database(el->user, el->file_id, MI, el->trace);
         remove_element(el);
         CS.Leave();
-        run_element();
+        notify_finished();
     }
 
     bool Scheduler::is_finished()
     {
         CS.Enter();
-        size_t size = working.size();
+        size_t size = working.size() + queue->queue_size();
         CS.Leave();
         return size == 0;
     }
@@ -177,7 +319,7 @@ namespace MediaConch {
             }
         }
         CS.Leave();
-        run_element();
+        notify_finished();
 
         return 0;
     }
@@ -209,6 +351,104 @@ namespace MediaConch {
         return ret;
     }
 
+    bool Scheduler::wait_all_finished(size_t timeout)
+    {
+        size_t start = get_time_ms();
+
+        // State is checked with the condition locked, a completion cannot be missed
+        ConditionLocker lock(finished_cond);
+        while (!is_finished())
+            if (!wait_finished_notification(start, timeout))
+                return false;
+
+        return true;
+    }
+
+    bool Scheduler::wait_element_finished(int user, long file_id, size_t timeout)
+    {
+        size_t start = get_time_ms();
+
+        ConditionLocker lock(finished_cond);
+        double percent_done;
+        while (!element_is_finished(user, file_id, percent_done))
+            if (!wait_finished_notification(start, timeout))
+                return false;
+
+        return true;
+    }
+
+    int Scheduler::wait_elements_finished(int user, const std::vector<long>& ids, std::vector<long>& finished,
+                                          size_t timeout)
+    {
+        size_t start = get_time_ms();
+
+        ConditionLocker lock(finished_cond);
+        while (true)
+        {
+            for (size_t i = 0; i < ids.size(); ++i)
+            {
+                double percent_done;
+                if (element_is_finished(user, ids[i], percent_done))
+                    finished.push_back(ids[i]);
+            }
+
+            if (finished.size() || !ids.size())
+                break;
+
+            if (!wait_finished_notification(start, timeout))
+                break;
+        }
+
+        return 0;
+    }
+
+    int Scheduler::get_events(int user, long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res)
+    {
+        size_t start = get_time_ms();
+
+        ConditionLocker lock(finished_cond);
+        while (true)
+        {
+            CS.Enter();
+            res.last_event = events_last;
+            res.events_lost = false;
+            res.finished.clear();
+
+            if (last_event >= 0)
+            {
+                long first = events_last - (long)events.size() + 1;
+                // Events too old or from another run of the scheduler
+                if (last_event + 1 < first || last_event > events_last)
+                {
+                    res.events_lost = true;
+                    last_event = first - 1;
+                }
+
+                for (long i = last_event + 1; i <= events_last; ++i)
+                    if (events[i - first].first == user)
+                        res.finished.push_back(events[i - first].second);
+            }
+            CS.Leave();
+
+            // Events of the other users are skipped by the next call
+            if (last_event < 0 || res.finished.size() || res.events_lost)
+                break;
+
+            if (!wait_finished_notification(start, timeout))
+                break;
+        }
+
+        res.progress.clear();
+        CS.Enter();
+        std::map<QueueElement*, QueueElement*>::iterator it = working.begin();
+        for (; it != working.end(); ++it)
+            if (it->first && it->first->user == user)
+                res.progress.push_back(std::make_pair(it->first->file_id, it->first->percent_done()));
+        CS.Leave();
+
+        return 0;
+    }
+
     long Scheduler::element_exists(int user, const std::string& filename,
                                    const std::string& options, std::string& err)
     {
@@ -293,10 +533,10 @@ namespace MediaConch {
         MediaConchLib::report report_kind = ((PluginFormat*)p)->get_report_kind();
 
         CS.Enter();
-        core->register_reports_to_database(el->user, el->file_id, report, report_kind, "", MI);
+        core->register_reports_to_database(el->user, el->file_id, report, report_kind, "", MI, el->trace);
         remove_element(el);
         CS.Leave();
-        run_element();
+        notify_finished();
 
         delete p;
 
@@ -306,8 +546,61 @@ namespace MediaConch {
     void Scheduler::remove_element(QueueElement *el)
     {
         std::map<QueueElement*, QueueElement*>::iterator it = working.find(el);
-        if (it != working.end())
-            working.erase(it);
+        if (it == working.end())
+            return;
+
+        working.erase(it);
+
+        // Keep the event for the clients waiting for the completion
+        events.push_back(std::make_pair(el->user, el->file_id));
+        ++events_last;
+        if (events.size() > EVENTS_MAX)
+            events.pop_front();
+    }
+
+    void Scheduler::notify_finished()
+    {
+        // Must not be called with CS locked
+        // Reports kept in a database batch are written when nothing is left to analyze
+        if (is_finished())
+            core->flush_database_batch();
+
+        finished_cond.lock();
+        finished_cond.broadcast();
+        finished_cond.unlock();
+
+        // The requests of events kept by the daemon
+        if (core->ecb.analyze_finished)
+            core->ecb.analyze_finished(core->ecb.analyze_finished_arg);
+    }
+
+    bool Scheduler::wait_finished_notification(size_t start, size_t timeout)
+    {
+        // Must be called with finished_cond locked
+        if (timeout == WAIT_INFINITE)
+        {
+            finished_cond.wait();
+            return true;
+        }
+
+        size_t elapsed = get_time_ms() - start;
+        if (elapsed >= timeout)
+            return false;
+
+        // The caller checks its state again, the next call reports the expiration
+        finished_cond.wait_for(timeout - elapsed);
+        return true;
+    }
+
+    size_t Scheduler::get_time_ms()
+    {
+#if defined(_WIN32) || defined(WIN32)
+        return (size_t)GetTickCount();
+#else
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        return (size_t)now.tv_sec * 1000 + now.tv_usec / 1000;
+#endif
     }
 
     int Scheduler::execute_pre_hook_plugins(QueueElement *el, std::string& err)
@@ -27,6 +27,10 @@
     #define MediaInfoNameSpace MediaInfoLib
 #endif
 #include "ZenLib/CriticalSection.h"
+#include "ZenLib/Thread.h"
+#include "Condition.h"
+#include "MediaConchLib.h"
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -39,6 +43,25 @@ namespace MediaConch {
 class Queue;
 class QueueElement;
 class Core;
+class Scheduler;
+
+//***************************************************************************
+// Class SchedulerWorker
+//***************************************************************************
+
+class SchedulerWorker : public ZenLib::Thread
+{
+public:
+    SchedulerWorker(Scheduler *s) : scheduler(s) {}
+
+    void Entry();
+
+private:
+    SchedulerWorker(const SchedulerWorker&);
+    SchedulerWorker& operator=(const SchedulerWorker&);
+
+    Scheduler *scheduler;
+};
 
 //***************************************************************************
 // Class Scheduler
@@ -54,13 +77,27 @@ public:
     int  add_element_to_queue(int user, const std::string& filename, long file_id,
                               const std::vector<std::pair<std::string,std::string> >& options,
                               const std::vector<std::string>& plugins, bool mil_analyze,
-                              const std::string& alias="");
+                              const std::string& alias="", bool reuse_analysis=false);
+    // Create the MediaTrace of a file analyzed without it, once for the elements queued or analyzed
+    int  add_trace_to_queue(int user, const std::string& filename, long file_id,
+                            const std::vector<std::pair<std::string,std::string> >& options);
+    bool mediatrace_is_on_demand() const;
+    // Fingerprint of the element saved, true if the reports of a file with the same content were copied
+    bool reuse_analysis_of_same_content(QueueElement* el);
     void work_finished(QueueElement* el, MediaInfoNameSpace::MediaInfo* MI);
     bool is_finished();
 
     long element_exists(int user, const std::string& filename,
                         const std::string& options, std::string& err);
     bool element_is_finished(int user, long file_id, double& percent_done);
+    // Blocking waits, timeout in milliseconds: return false (or no finished element) when it expired
+    bool wait_all_finished(size_t timeout=WAIT_INFINITE);
+    bool wait_element_finished(int user, long file_id, size_t timeout=WAIT_INFINITE);
+    int  wait_elements_finished(int user, const std::vector<long>& ids, std::vector<long>& finished,
+                                size_t timeout=WAIT_INFINITE);
+    // Elements finished after the event last_event (-1 to only get the current event), wait for one
+    // until the timeout expired, with the progress of the elements still analyzed
+    int  get_events(int user, long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res);
     int  get_elements(int user, std::vector<std::string>& vec, std::string& err);
     int  get_elements(int user, std::vector<long>& vec, std::string& err);
     int  stop_elements(int user, const std::vector<long>& vec, std::string& err);
@@ -72,23 +109,53 @@ public:
     void write_log_timestamp(int level, std::string log);
     void log_cb(struct MediaInfo_Event_Log_0 *Event);
 
-    void set_default_max_threads(size_t nb) {} // { if (max_threads_modified) return; max_threads = nb; } //TODO: check issues with the GUI when there are tons of files
+    void set_default_max_threads(size_t nb) { if (max_threads_modified) return; max_threads = nb; }
     void set_max_threads(size_t nb) { max_threads_modified = true; max_threads = nb; }
 
+    static size_t get_hardware_concurrency();
+
+    static const size_t WAIT_INFINITE = (size_t)-1;
+
 private:
+    friend class SchedulerWorker;
+
     Scheduler(const Scheduler&);
     Scheduler&     operator=(const Scheduler&);
 
     Core                                   *core;
     Queue                                  *queue;
-    int                                     threads_launch;
     size_t                                  max_threads;
     bool                                    max_threads_modified;
     std::map<QueueElement*, QueueElement*>  working;
     CriticalSection                         CS;
-
-    void run_element();
-    void remove_element(QueueElement *el);
+    Condition                               finished_cond;
+
+    // Finished elements (user, file id), the last one is the event events_last, protected by CS
+    std::deque<std::pair<int, long> >       events;
+    long                                    events_last;
+
+    // Worker pool, protected by queue_cond
+    std::vector<SchedulerWorker*>           workers;
+    size_t                                  idle_workers;
+    // Idle workers signaled but not yet awake, they do not take the next elements
+    size_t                                  wakeups_pending;
+    // Workers not out of worker_loop
+    size_t                                  running_workers;
+    bool                                    stopping;
+    Condition                               queue_cond;
+
+    void          worker_loop();
+    int           queue_element(int user, const std::string& filename, long file_id,
+                                const std::vector<std::pair<std::string,std::string> >& options,
+                                const std::vector<std::string>& plugins, bool mil_analyze,
+                                const std::string& alias, bool trace_only, bool reuse_analysis=false);
+    QueueElement *next_element();
+    void          remove_element(QueueElement *el);
+    void          notify_finished();
+    bool          wait_finished_notification(size_t start, size_t timeout);
+    static size_t get_time_ms();
+
+    static const size_t EVENTS_MAX = 100000;
 };
 
 }
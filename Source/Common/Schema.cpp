@@ -14,6 +14,7 @@
 #include "Schema.h"
 #include <fstream>
 #include <sstream>
+#include <string.h>
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
@@ -103,6 +104,12 @@ int Schema::validate_xml(const std::string&, bool)
     return -1;
 }
 
+//---------------------------------------------------------------------------
+int Schema::validate_xml_from_doc(void*, bool)
+{
+    return -1;
+}
+
 //***************************************************************************
 // Callbacks
 //***************************************************************************
@@ -122,19 +129,31 @@ void Schema::manage_generic_error(void *userData, const char* msg, ...)
 {
     Schema *obj = (Schema *)userData;
     va_list args;
-    char buf[4096] = {0};
 
     va_start(args, msg);
+    obj->errors.push_back(generic_error_message(msg, args));
+    va_end(args);
+}
+
+//---------------------------------------------------------------------------
+std::string Schema::generic_error_message(const char* msg, va_list args)
+{
+    char buf[4096] = {0};
+
 #ifdef _MSC_VER
     int ret = vsnprintf_s(buf, sizeof(buf), _TRUNCATE, msg, args);
 #else //_MSC_VER
     int ret = vsnprintf(buf, sizeof(buf), msg, args);
+#endif //_MSC_VER
+    // The length returned is the one of the whole message, not of what was written,
+    // and is negative when truncated by vsnprintf_s
     if (ret < 0)
-        ret = 0;
+        ret = (int)strlen(buf);
+    else if ((size_t)ret >= sizeof(buf))
+        ret = sizeof(buf) - 1;
     buf[ret] = '\0';
-#endif //_MSC_VER
-    obj->errors.push_back(buf);
-    va_end(args);
+
+    return std::string(buf, ret);
 }
 
 }
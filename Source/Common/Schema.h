@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <stdarg.h>
 #include <libxml/xmlerror.h>
 
 namespace MediaConch {
@@ -40,6 +41,7 @@ public:
 
     virtual int  validate_xml(const std::string& xml, bool silent=true);
     virtual int  validate_xml_from_file(const char* file, bool silent=true);
+    virtual int  validate_xml_from_doc(void* doc, bool silent=true);
 
     std::string  get_schema() const { return schema; }
     std::string  get_report() const { return report; }
@@ -52,6 +54,9 @@ public:
     static void  manage_generic_error(void *userData, const char* msg, ...);
     static void  manage_error(void *userData, xmlErrorPtr err);
 
+    // Message of a generic error callback, truncated if too long
+    static std::string generic_error_message(const char* msg, va_list args);
+
 protected:
     std::string                        schema;
     std::string                        report;
@@ -12,8 +12,10 @@
 
 //---------------------------------------------------------------------------
 #include "WatchFolder.h"
+#include "WatchFolderWatcher.h"
 #include "MediaConchLib.h"
 #include "Core.h"
+#include "DatabaseReport.h"
 #include "Reports.h"
 #include "PluginLog.h"
 #include "PluginPreHook.h"
@@ -28,8 +30,10 @@
 
 #if defined(UNIX)
 #include <unistd.h>
+#include <sys/time.h>
 #elif defined(MACOS) || defined(MACOSX)
 #include <unistd.h>
+#include <sys/time.h>
 #elif defined(WINDOWS)
 #include <windows.h>
 #include <Lmcons.h>
@@ -39,7 +43,7 @@
 namespace MediaConch {
 
 //---------------------------------------------------------------------------
-WatchFolderFile::WatchFolderFile() : state(WFFS_NOT_READY)
+WatchFolderFile::WatchFolderFile() : size(0), file_id(-1), state(WFFS_NOT_READY)
 {
 }
 
@@ -49,8 +53,10 @@ WatchFolderFile::~WatchFolderFile()
 }
 
 //---------------------------------------------------------------------------
-WatchFolder::WatchFolder(Core* c, long user_id) : user(user_id), core(c), recursive(true), end(false), is_watching(false)
+WatchFolder::WatchFolder(Core* c, long user_id) : user(user_id), core(c), last_scan(0), scanned(false), recursive(true),
+                                                  end(false), is_watching(false)
 {
+    watcher = WatchFolderWatcher::create(core->watch_folder_events_is_enabled());
 #ifdef WINDOWS
         waiting_time = 10;
 #else
@@ -62,6 +68,11 @@ WatchFolder::WatchFolder(Core* c, long user_id) : user(user_id), core(c), recurs
 WatchFolder::~WatchFolder()
 {
     stop();
+    delete watcher;
+
+    std::map<std::string, WatchFolderFile*>::iterator it = files.begin();
+    for (; it != files.end(); ++it)
+        delete it->second;
 }
 
 //---------------------------------------------------------------------------
@@ -80,154 +91,372 @@ void WatchFolder::set_recursive(bool r)
 void WatchFolder::Entry()
 {
     is_watching = true;
+
+    load_catalog();
+
+    std::string err;
+    if (watcher->start(folder, recursive, err) < 0)
+        core->plugin_add_log(PluginLog::LOG_LEVEL_WARNING, folder + ": " + err);
+
     while (!end)
     {
-        ZenLib::Ztring dir_name = ZenLib::Ztring().From_UTF8(folder);
+        std::vector<std::string> changes;
+        bool rescan = false;
+        watcher->get_changes(changes, rescan);
+
+        // Without notification, a file is analyzed when it is not modified between two scans,
+        // a wake up for a finished analysis does not scan again before the interval
+        if (rescan && !watcher->notifies_changes() && scanned && get_time_ms() - last_scan < scan_interval())
+            rescan = false;
+
+        if (rescan)
+        {
+            scan_folder(watcher->notifies_changes());
+            last_scan = get_time_ms();
+            scanned = true;
+        }
+
+        for (size_t i = 0; i < changes.size(); ++i)
+            file_changed(changes[i], true);
+
+        check_analyzing();
+        save_catalog();
+        wait_next_scan();
+    }
+    is_watching = false;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::scan_folder(bool ready)
+{
+    ZenLib::Ztring dir_name = ZenLib::Ztring().From_UTF8(folder);
+
+    int flags = ZenLib::Dir::Include_Files | ZenLib::Dir::Include_Hidden;
+    if (recursive)
+        flags |= ZenLib::Dir::Parse_SubDirs;
 
-        int flags = ZenLib::Dir::Include_Files | ZenLib::Dir::Include_Hidden;
-        if (recursive)
-            flags |= ZenLib::Dir::Parse_SubDirs;
+    ZenLib::ZtringList list = ZenLib::Dir::GetAllFileNames(dir_name, (ZenLib::Dir::dirlist_t)flags);
 
-        ZenLib::ZtringList list = ZenLib::Dir::GetAllFileNames(dir_name, (ZenLib::Dir::dirlist_t)flags);
+    std::set<std::string> listed;
+    for (size_t i = 0; i < list.size(); ++i)
+    {
+        std::string filename = list[i].To_UTF8();
+        listed.insert(filename);
+        file_changed(filename, ready);
+    }
 
-        for (size_t i = 0; i < list.size(); ++i)
+    // Files removed from the folder, also the ones removed while the watch was stopped
+    std::map<std::string, WatchFolderFile*>::iterator it = files.begin();
+    while (it != files.end())
+    {
+        if (listed.find(it->first) != listed.end() ||
+            (it->second && it->second->state == WatchFolderFile::WFFS_ANALYZING))
         {
-            ZenLib::Ztring modified_time = ZenLib::File::Modified_Get(list[i]);
-            std::string filename = list[i].To_UTF8();
-            std::string time_utf8 = modified_time.To_UTF8();
+            ++it;
+            continue;
+        }
 
-            if (files.find(filename) == files.end() || !files[filename])
-            {
-                if (!filename.size())
-                    continue;
+        file_catalog_removed(it->first);
+        delete it->second;
+        files.erase(it++);
+    }
+}
 
-                WatchFolderFile *wffile = new WatchFolderFile;
-                wffile->name = filename;
-                wffile->time = time_utf8;
+//---------------------------------------------------------------------------
+void WatchFolder::file_changed(const std::string& filename, bool ready)
+{
+    if (!filename.size())
+        return;
 
-                //Create sub directory if needed
-                std::string reports_dir = ZenLib::FileName::Path_Get(list[i]).To_UTF8();
-                if (reports_dir.size() > folder.size())
-                {
-                    size_t s = folder.size();
-                    if (s && (folder[s - 1] == '/' || folder[s - 1] == '\\'))
-                        s -= 1;
-                    reports_dir = reports_dir.substr(s);
-                }
-                else
-                    reports_dir = std::string();
-
-                ZenLib::Ztring f_reports = ZenLib::Ztring().From_UTF8(folder_reports);
-                if (f_reports[f_reports.size() - 1] != ZenLib::FileName_PathSeparator[0])
-                    f_reports += ZenLib::FileName_PathSeparator;
-                f_reports += ZenLib::Ztring().From_UTF8(reports_dir);
-                if (folder_reports.size() && !ZenLib::Dir::Exists(f_reports))
-                    ZenLib::Dir::Create(f_reports);
-
-                if (f_reports[f_reports.size() - 1] != ZenLib::FileName_PathSeparator[0])
-                    f_reports += ZenLib::FileName_PathSeparator;
-                wffile->report_file = f_reports.To_UTF8();
-
-                wffile->report_file += ZenLib::FileName::Name_Get(list[i]).To_UTF8();
-                if (ZenLib::FileName::Extension_Get(list[i]).size())
-                    wffile->report_file += "." + ZenLib::FileName::Extension_Get(list[i]).To_UTF8();
-
-                files[filename] = wffile;
-                continue;
-            }
+    ZenLib::Ztring name = ZenLib::Ztring().From_UTF8(filename);
+    std::string time_utf8 = ZenLib::File::Modified_Get(name).To_UTF8();
 
-            WatchFolderFile *wffile = files[filename];
-            if (wffile->time != time_utf8)
-            {
-                wffile->time = time_utf8;
-                wffile->state = WatchFolderFile::WFFS_NOT_READY;
-                continue;
-            }
+    // Notified file already moved or removed
+    if (ready && !time_utf8.size())
+        return;
 
-            if (wffile->state == WatchFolderFile::WFFS_DONE)
-                continue;
+    size_t size = (size_t)ZenLib::File::Size_Get(name);
 
-            if (wffile->state == WatchFolderFile::WFFS_ANALYZING)
-                continue;
+    std::map<std::string, WatchFolderFile*>::iterator it = files.find(filename);
+    if (it == files.end() || !it->second)
+    {
+        WatchFolderFile *wffile = create_file(filename, time_utf8);
+        wffile->size = size;
+        files[filename] = wffile;
+        file_catalog_changed(wffile);
+        if (ready)
+            analyze_file(wffile);
+        return;
+    }
 
-            bool registered = false;
-            std::string err;
-            bool need_analyze = true;
-            for (size_t j = 0; need_analyze && j < plugins.size(); ++j)
-            {
-                const std::vector<Plugin*>& ps = core->get_pre_hook_plugins();
-                for (size_t ps_i = 0; ps_i < ps.size(); ++ps_i)
-                    if (ps[ps_i] && plugins[i] == ps[ps_i]->get_id() &&
-                        ps[ps_i]->get_type() == MediaConchLib::PLUGIN_PRE_HOOK)
-                    {
-                        if (((PluginPreHook*)ps[ps_i])->is_creating_files())
-                        {
-                            need_analyze = false;
-                            break;
-                        }
-                    }
-            }
+    WatchFolderFile *wffile = it->second;
+    if (wffile->time != time_utf8 || wffile->size != size)
+    {
+        if (wffile->state == WatchFolderFile::WFFS_ANALYZING)
+            analyzing.erase(wffile->file_id);
+        wffile->time = time_utf8;
+        wffile->size = size;
+        wffile->state = WatchFolderFile::WFFS_NOT_READY;
+        file_catalog_changed(wffile);
+        if (!ready)
+            return;
+    }
+
+    if (wffile->state != WatchFolderFile::WFFS_NOT_READY)
+        return;
+
+    analyze_file(wffile);
+}
+
+//---------------------------------------------------------------------------
+WatchFolderFile *WatchFolder::create_file(const std::string& filename, const std::string& time)
+{
+    ZenLib::Ztring name = ZenLib::Ztring().From_UTF8(filename);
+
+    WatchFolderFile *wffile = new WatchFolderFile;
+    wffile->name = filename;
+    wffile->time = time;
+
+    //Create sub directory if needed
+    std::string reports_dir = ZenLib::FileName::Path_Get(name).To_UTF8();
+    if (reports_dir.size() > folder.size())
+    {
+        size_t s = folder.size();
+        if (s && (folder[s - 1] == '/' || folder[s - 1] == '\\'))
+            s -= 1;
+        reports_dir = reports_dir.substr(s);
+    }
+    else
+        reports_dir = std::string();
 
-            wffile->file_id = core->checker_analyze(user, filename, registered, options, plugins, err, need_analyze);
-            if (wffile->file_id == -1)
+    ZenLib::Ztring f_reports = ZenLib::Ztring().From_UTF8(folder_reports);
+    if (f_reports[f_reports.size() - 1] != ZenLib::FileName_PathSeparator[0])
+        f_reports += ZenLib::FileName_PathSeparator;
+    f_reports += ZenLib::Ztring().From_UTF8(reports_dir);
+    if (folder_reports.size() && !ZenLib::Dir::Exists(f_reports))
+        ZenLib::Dir::Create(f_reports);
+
+    if (f_reports[f_reports.size() - 1] != ZenLib::FileName_PathSeparator[0])
+        f_reports += ZenLib::FileName_PathSeparator;
+    wffile->report_file = f_reports.To_UTF8();
+
+    wffile->report_file += ZenLib::FileName::Name_Get(name).To_UTF8();
+    if (ZenLib::FileName::Extension_Get(name).size())
+        wffile->report_file += "." + ZenLib::FileName::Extension_Get(name).To_UTF8();
+
+    return wffile;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::analyze_file(WatchFolderFile *wffile)
+{
+    bool registered = false;
+    std::string err;
+    bool need_analyze = true;
+    for (size_t j = 0; need_analyze && j < plugins.size(); ++j)
+    {
+        const std::vector<Plugin*>& ps = core->get_pre_hook_plugins();
+        for (size_t ps_i = 0; ps_i < ps.size(); ++ps_i)
+            if (ps[ps_i] && plugins[j] == ps[ps_i]->get_id() &&
+                ps[ps_i]->get_type() == MediaConchLib::PLUGIN_PRE_HOOK)
             {
-                std::stringstream out;
-                out << "Cannot parse:" << filename;
-                core->plugin_add_log(PluginLog::LOG_LEVEL_ERROR, out.str());
+                if (((PluginPreHook*)ps[ps_i])->is_creating_files())
+                {
+                    need_analyze = false;
+                    break;
+                }
             }
-            else
-                wffile->state = WatchFolderFile::WFFS_ANALYZING;
+    }
+
+    wffile->file_id = core->checker_analyze(user, wffile->name, registered, options, plugins, err, need_analyze);
+    if (wffile->file_id == -1)
+    {
+        std::stringstream out;
+        out << "Cannot parse:" << wffile->name;
+        core->plugin_add_log(PluginLog::LOG_LEVEL_ERROR, out.str());
+    }
+    else
+    {
+        wffile->state = WatchFolderFile::WFFS_ANALYZING;
+        analyzing[wffile->file_id] = wffile;
+        file_catalog_changed(wffile);
+    }
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::check_analyzing()
+{
+    std::map<long, WatchFolderFile*>::iterator it = analyzing.begin();
+    while (it != analyzing.end())
+    {
+        WatchFolderFile *wffile = it->second;
+
+        MediaConchLib::Checker_StatusRes status;
+        std::string err;
+        core->checker_status(user, wffile->file_id, status, err);
+        if (!status.finished)
+        {
+            ++it;
+            continue;
         }
 
-        //In case of analysis
-        std::map<std::string, WatchFolderFile*>::iterator it = files.begin();
-        for (; it != files.end(); ++it)
+        analyzing.erase(it++);
+        wffile->state = WatchFolderFile::WFFS_DONE;
+        file_catalog_changed(wffile);
+
+        if (status.generated_id.size())
         {
-            WatchFolderFile *wffile = it->second;
-            if (!wffile || wffile->state != WatchFolderFile::WFFS_ANALYZING)
-                continue;
-
-            MediaConchLib::Checker_StatusRes status;
-            std::string err;
-            core->checker_status(user, wffile->file_id, status, err);
-            if (status.finished)
+            for (size_t j = 0; j < status.generated_id.size(); ++j)
             {
-                wffile->state = WatchFolderFile::WFFS_DONE;
-
-                if (status.generated_id.size())
-                {
-                    for (size_t j = 0; j < status.generated_id.size(); ++j)
-                    {
-                        WatchFolderFile *new_wffile = new WatchFolderFile;
-                        std::string filename;
-                        std::string err;
-                        core->checker_file_from_id(user, status.generated_id[j], filename, err);
-                        new_wffile->file_id = status.generated_id[j];
-                        new_wffile->name = filename;
-                        new_wffile->time = ZenLib::File::Modified_Get(ZenLib::Ztring().From_UTF8(filename)).To_UTF8();
-                        new_wffile->report_file = wffile->report_file;
-                        new_wffile->state = WatchFolderFile::WFFS_ANALYZING;
-                        files[filename] = new_wffile;
-                    }
-                }
-                else if (folder_reports.size())
-                    ask_report(wffile);
+                WatchFolderFile *new_wffile = new WatchFolderFile;
+                std::string filename;
+                std::string err;
+                core->checker_file_from_id(user, status.generated_id[j], filename, err);
+                new_wffile->file_id = status.generated_id[j];
+                new_wffile->name = filename;
+                new_wffile->time = ZenLib::File::Modified_Get(ZenLib::Ztring().From_UTF8(filename)).To_UTF8();
+                new_wffile->size = (size_t)ZenLib::File::Size_Get(ZenLib::Ztring().From_UTF8(filename));
+                new_wffile->report_file = wffile->report_file;
+                new_wffile->state = WatchFolderFile::WFFS_ANALYZING;
+                files[filename] = new_wffile;
+                analyzing[new_wffile->file_id] = new_wffile;
+                file_catalog_changed(new_wffile);
             }
         }
+        else if (folder_reports.size())
+            ask_report(wffile);
+    }
+}
 
+//---------------------------------------------------------------------------
+size_t WatchFolder::scan_interval() const
+{
+    // In milliseconds
 #ifdef WINDOWS
-        ::Sleep((DWORD)waiting_time);
+    return waiting_time;
+#else
+    return waiting_time / 1000;
+#endif
+}
+
+//---------------------------------------------------------------------------
+size_t WatchFolder::get_time_ms()
+{
+#if defined(WINDOWS)
+    return (size_t)GetTickCount();
 #else
-        usleep(waiting_time);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return (size_t)now.tv_sec * 1000 + now.tv_usec / 1000;
 #endif
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::wait_next_scan()
+{
+    size_t timeout = scan_interval();
+
+    // Without notification, only the time left until the next scan
+    size_t elapsed = get_time_ms() - last_scan;
+    if (!watcher->notifies_changes() && scanned)
+        timeout = elapsed < timeout ? timeout - elapsed : 0;
+
+    //Wake up as soon as an analysis is finished to write its reports
+    if (analyzing.size())
+    {
+        std::vector<long> ids;
+        std::map<long, WatchFolderFile*>::iterator it = analyzing.begin();
+        for (; it != analyzing.end(); ++it)
+            ids.push_back(it->first);
+
+        std::vector<long> finished;
+        std::string err;
+        core->checker_wait_finished(user, ids, finished, err, timeout);
+        return;
     }
-    is_watching = false;
+
+    watcher->wait_changes(timeout);
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::load_catalog()
+{
+    std::vector<DatabaseWatchFolderFile> catalog;
+    std::string err;
+    if (core->watch_folder_get_files(user, folder, catalog, err) < 0)
+    {
+        core->plugin_add_log(PluginLog::LOG_LEVEL_WARNING, folder + ": " + err);
+        return;
+    }
+
+    // Compared with the files found by the first scan
+    for (size_t i = 0; i < catalog.size(); ++i)
+    {
+        const DatabaseWatchFolderFile& file = catalog[i];
+        WatchFolderFile *wffile = create_file(file.filename, file.file_last_modification);
+        wffile->size = file.file_size;
+        wffile->file_id = file.file_id;
+
+        // The files queued before the restart are asked again, they are not analyzed twice if registered
+        if (file.state == WatchFolderFile::WFFS_DONE)
+            wffile->state = WatchFolderFile::WFFS_DONE;
+
+        files[file.filename] = wffile;
+    }
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::save_catalog()
+{
+    if (catalog_changed.empty() && catalog_removed.empty())
+        return;
+
+    std::vector<DatabaseWatchFolderFile> saved;
+    std::set<std::string>::iterator it = catalog_changed.begin();
+    for (; it != catalog_changed.end(); ++it)
+    {
+        std::map<std::string, WatchFolderFile*>::iterator it_f = files.find(*it);
+        if (it_f == files.end() || !it_f->second)
+            continue;
+
+        DatabaseWatchFolderFile file;
+        file.filename = it_f->second->name;
+        file.file_last_modification = it_f->second->time;
+        file.file_size = it_f->second->size;
+        file.state = (int)it_f->second->state;
+        file.file_id = it_f->second->file_id;
+        saved.push_back(file);
+    }
+
+    std::vector<std::string> removed(catalog_removed.begin(), catalog_removed.end());
+    catalog_changed.clear();
+    catalog_removed.clear();
+
+    std::string err;
+    if (core->watch_folder_save_files(user, folder, saved, removed, err) < 0)
+        core->plugin_add_log(PluginLog::LOG_LEVEL_WARNING, folder + ": cannot save the watched files: " + err);
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::file_catalog_changed(WatchFolderFile *wffile)
+{
+    catalog_removed.erase(wffile->name);
+    catalog_changed.insert(wffile->name);
+}
+
+//---------------------------------------------------------------------------
+void WatchFolder::file_catalog_removed(const std::string& filename)
+{
+    catalog_changed.erase(filename);
+    catalog_removed.insert(filename);
 }
 
 //---------------------------------------------------------------------------
 void WatchFolder::stop()
 {
     end = true;
+    watcher->stop();
+
     RequestTerminate();
     while (!IsExited())
     {
@@ -19,6 +19,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <ZenLib/Thread.h>
 #include <ZenLib/CriticalSection.h>
 
@@ -30,6 +31,7 @@ namespace MediaConch {
 //***************************************************************************
 
 class Core;
+class WatchFolderWatcher;
 
 class WatchFolderFile
 {
@@ -46,6 +48,7 @@ public:
 
     std::string           name;
     std::string           time;
+    size_t                size;
     std::string           report_file;
     long                  file_id;
     WatchFolderFileState  state;
@@ -78,9 +81,32 @@ private:
     WatchFolder&                             operator=(const WatchFolder&);
 
     int                                      ask_report(WatchFolderFile *wffile);
+    void                                     scan_folder(bool ready);
+    // Not ready, the file is analyzed if it is not modified at the next scan
+    void                                     file_changed(const std::string& filename, bool ready);
+    WatchFolderFile                         *create_file(const std::string& filename, const std::string& time);
+    void                                     analyze_file(WatchFolderFile *wffile);
+    void                                     check_analyzing();
+    void                                     wait_next_scan();
+    size_t                                   scan_interval() const;
+    static size_t                            get_time_ms();
+    // Files known before the restart, they are not analyzed again if not modified
+    void                                     load_catalog();
+    void                                     save_catalog();
+    void                                     file_catalog_changed(WatchFolderFile *wffile);
+    void                                     file_catalog_removed(const std::string& filename);
 
     Core                                    *core;
+    WatchFolderWatcher                      *watcher;
     std::map<std::string, WatchFolderFile*>  files;
+    // Files being analyzed, by id
+    std::map<long, WatchFolderFile*>         analyzing;
+    // Catalog changes saved together at the end of each scan
+    std::set<std::string>                    catalog_changed;
+    std::set<std::string>                    catalog_removed;
+    // Time of the last scan of the whole folder, in milliseconds
+    size_t                                   last_scan;
+    bool                                     scanned;
     size_t                                   waiting_time;
     bool                                     recursive;
     bool                                     end;
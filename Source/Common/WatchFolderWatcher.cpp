@@ -0,0 +1,311 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Change detection of the watched folders
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#include "WatchFolderWatcher.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// WatchFolderWatcher
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+WatchFolderWatcher *WatchFolderWatcher::create(bool use_events)
+{
+#if defined(__linux__)
+    if (use_events)
+        return new WatchFolderInotify;
+#else
+    (void)use_events;
+#endif
+    return new WatchFolderPolling;
+}
+
+//***************************************************************************
+// WatchFolderPolling
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+WatchFolderPolling::WatchFolderPolling() : stopped(false)
+{
+}
+
+//---------------------------------------------------------------------------
+WatchFolderPolling::~WatchFolderPolling()
+{
+}
+
+//---------------------------------------------------------------------------
+int WatchFolderPolling::start(const std::string&, bool, std::string&)
+{
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderPolling::get_changes(std::vector<std::string>&, bool& rescan)
+{
+    rescan = true;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderPolling::wait_changes(size_t timeout)
+{
+    ConditionLocker lock(stop_cond);
+    if (!stopped)
+        stop_cond.wait_for(timeout);
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderPolling::stop()
+{
+    stop_cond.lock();
+    stopped = true;
+    stop_cond.broadcast();
+    stop_cond.unlock();
+}
+
+#if defined(__linux__)
+//***************************************************************************
+// WatchFolderInotify
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+static const uint32_t inotify_mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_CREATE;
+
+//---------------------------------------------------------------------------
+WatchFolderInotify::WatchFolderInotify() : fd(-1), recursive(true), rescan_needed(true), polling(false)
+{
+    // Written by stop to wake up the wait
+    if (pipe(stop_pipe) < 0)
+    {
+        stop_pipe[0] = -1;
+        stop_pipe[1] = -1;
+    }
+}
+
+//---------------------------------------------------------------------------
+WatchFolderInotify::~WatchFolderInotify()
+{
+    if (fd >= 0)
+        close(fd);
+    for (size_t i = 0; i < 2; ++i)
+        if (stop_pipe[i] >= 0)
+            close(stop_pipe[i]);
+}
+
+//---------------------------------------------------------------------------
+int WatchFolderInotify::start(const std::string& f, bool r, std::string& err)
+{
+    folder = f;
+    recursive = r;
+    rescan_needed = true;
+
+    fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        err = "Cannot watch the changes of the folder, it is scanned";
+        polling = true;
+        return -1;
+    }
+
+    if (add_watches(folder, NULL) < 0)
+    {
+        err = "Not enough inotify watches for the folder (fs.inotify.max_user_watches), it is scanned";
+        polling = true;
+        return -1;
+    }
+
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int WatchFolderInotify::add_watches(const std::string& dir, std::vector<std::string>* files)
+{
+    int wd = inotify_add_watch(fd, dir.c_str(), inotify_mask | IN_ONLYDIR);
+    if (wd < 0)
+        return errno == ENOSPC ? -1 : 0;
+    watches[wd] = dir;
+
+    // Files of a directory created or moved are reported, they may be written before its watch
+    if (!recursive && !files)
+        return 0;
+
+    DIR *d = opendir(dir.c_str());
+    if (!d)
+        return 0;
+
+    int ret = 0;
+    struct dirent *entry;
+    while (ret == 0 && (entry = readdir(d)) != NULL)
+    {
+        if (!strcmp(entry->d_name, ".") || !strcmp(entry->d_name, ".."))
+            continue;
+
+        std::string path = dir + "/" + entry->d_name;
+
+        bool is_dir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN)
+        {
+            struct stat st;
+            is_dir = !lstat(path.c_str(), &st) && S_ISDIR(st.st_mode);
+        }
+
+        if (is_dir && recursive)
+            ret = add_watches(path, files);
+        else if (!is_dir && files)
+            files->push_back(path);
+    }
+    closedir(d);
+
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderInotify::remove_watches(const std::string& dir)
+{
+    std::string sub_dir = dir + "/";
+    std::map<int, std::string>::iterator it = watches.begin();
+    while (it != watches.end())
+    {
+        if (it->second == dir || !it->second.compare(0, sub_dir.size(), sub_dir))
+        {
+            inotify_rm_watch(fd, it->first);
+            watches.erase(it++);
+        }
+        else
+            ++it;
+    }
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderInotify::reset_watches()
+{
+    std::map<int, std::string>::iterator it = watches.begin();
+    for (; it != watches.end(); ++it)
+        inotify_rm_watch(fd, it->first);
+    watches.clear();
+
+    if (add_watches(folder, NULL) < 0)
+        polling = true;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderInotify::get_changes(std::vector<std::string>& files, bool& rescan)
+{
+    rescan = rescan_needed || polling;
+    rescan_needed = false;
+    if (fd < 0 || polling)
+        return;
+
+    // Aligned for the events
+    long buffer[1024];
+    bool overflow = false;
+    ssize_t len;
+    while ((len = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        const char *p = (const char*)buffer;
+        while (p < (const char*)buffer + len)
+        {
+            const struct inotify_event *event = (const struct inotify_event*)p;
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                overflow = true;
+                continue;
+            }
+
+            std::map<int, std::string>::iterator it = watches.find(event->wd);
+            if (it == watches.end())
+                continue;
+
+            if (event->mask & IN_IGNORED)
+            {
+                watches.erase(it);
+                continue;
+            }
+
+            if (!event->len)
+                continue;
+
+            std::string path = it->second + "/" + event->name;
+            if (event->mask & IN_ISDIR)
+            {
+                // A moved directory is watched again with its new path if it stays in the folder
+                if (event->mask & IN_MOVED_FROM)
+                    remove_watches(path);
+                else if (recursive && (event->mask & (IN_CREATE | IN_MOVED_TO)) && add_watches(path, &files) < 0)
+                    polling = true;
+                continue;
+            }
+
+            if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                files.push_back(path);
+        }
+    }
+
+    // Watches added again before the scan, no directory is missed
+    if (overflow)
+    {
+        reset_watches();
+        rescan = true;
+    }
+
+    if (polling)
+        rescan = true;
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderInotify::wait_changes(size_t timeout)
+{
+    struct pollfd fds[2];
+    nfds_t nb = 0;
+    if (stop_pipe[0] >= 0)
+    {
+        fds[nb].fd = stop_pipe[0];
+        fds[nb].events = POLLIN;
+        ++nb;
+    }
+    if (fd >= 0 && !polling)
+    {
+        fds[nb].fd = fd;
+        fds[nb].events = POLLIN;
+        ++nb;
+    }
+
+    poll(fds, nb, (int)timeout);
+}
+
+//---------------------------------------------------------------------------
+void WatchFolderInotify::stop()
+{
+    // Not read, the next waits return immediately
+    if (stop_pipe[1] >= 0)
+        while (write(stop_pipe[1], "", 1) < 0 && errno == EINTR)
+            ;
+}
+#endif // !__linux__
+
+}
@@ -0,0 +1,114 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Change detection of the watched folders
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#ifndef WATCHFOLDERWATCHERH
+#define WATCHFOLDERWATCHERH
+//---------------------------------------------------------------------------
+
+//---------------------------------------------------------------------------
+#include <string>
+#include <vector>
+#include <map>
+#include "Condition.h"
+
+//---------------------------------------------------------------------------
+namespace MediaConch {
+
+//***************************************************************************
+// Class WatchFolderWatcher
+//***************************************************************************
+
+// Used by the thread of the watch folder, stop can be called by another thread
+class WatchFolderWatcher
+{
+public:
+    WatchFolderWatcher() {}
+    virtual ~WatchFolderWatcher() {}
+
+    // Start to watch the folder, -1 if the changes cannot be notified (the folder is scanned)
+    virtual int  start(const std::string& folder, bool recursive, std::string& err) = 0;
+    // Files written since the last call, rescan is set when the whole folder has to be scanned
+    virtual void get_changes(std::vector<std::string>& files, bool& rescan) = 0;
+    // Block until a change, the stop or the end of the timeout (in milliseconds)
+    virtual void wait_changes(size_t timeout) = 0;
+    virtual void stop() = 0;
+    // Files found by a scan can be analyzed, they are notified again when they are written
+    virtual bool notifies_changes() const = 0;
+
+    static WatchFolderWatcher *create(bool use_events);
+
+private:
+    WatchFolderWatcher(const WatchFolderWatcher&);
+    WatchFolderWatcher& operator=(const WatchFolderWatcher&);
+};
+
+//***************************************************************************
+// Class WatchFolderPolling
+//***************************************************************************
+
+// The folder is scanned at each wait
+class WatchFolderPolling : public WatchFolderWatcher
+{
+public:
+    WatchFolderPolling();
+    ~WatchFolderPolling();
+
+    int  start(const std::string& folder, bool recursive, std::string& err);
+    void get_changes(std::vector<std::string>& files, bool& rescan);
+    void wait_changes(size_t timeout);
+    void stop();
+    bool notifies_changes() const { return false; }
+
+private:
+    bool      stopped;
+    Condition stop_cond;
+};
+
+#if defined(__linux__)
+//***************************************************************************
+// Class WatchFolderInotify
+//***************************************************************************
+
+// Files closed after writing or moved in the folder, a scan is asked when events are lost
+class WatchFolderInotify : public WatchFolderWatcher
+{
+public:
+    WatchFolderInotify();
+    ~WatchFolderInotify();
+
+    int  start(const std::string& folder, bool recursive, std::string& err);
+    void get_changes(std::vector<std::string>& files, bool& rescan);
+    void wait_changes(size_t timeout);
+    void stop();
+    bool notifies_changes() const { return !polling; }
+
+private:
+    int                         fd;
+    int                         stop_pipe[2];
+    std::string                 folder;
+    bool                        recursive;
+    bool                        rescan_needed;
+    // Not enough watches, the folder is scanned
+    bool                        polling;
+    std::map<int, std::string>  watches;
+
+    int  add_watches(const std::string& dir, std::vector<std::string>* files);
+    void remove_watches(const std::string& dir);
+    // Events lost, the directories created or moved meanwhile are watched
+    void reset_watches();
+};
+#endif // !__linux__
+
+}
+
+#endif // !WATCHFOLDERWATCHERH
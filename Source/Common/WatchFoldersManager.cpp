@@ -71,12 +71,13 @@ int WatchFoldersManager::add_watch_folder(const std::string& folder, const std::
         return -1;
     }
 
+    // Folder watched before a restart: same user, the files already analyzed are kept
+    std::string err;
     if (in_user)
         user_id = *in_user;
-    else
+    else if (core->watch_folder_get_user(folder, user_id, err) < 0)
     {
         std::vector<long> ids;
-        std::string err;
         core->get_users_ids(ids, err);
         for (user_id = -2; true; --user_id)
         {
@@ -147,10 +148,15 @@ int WatchFoldersManager::remove_watch_folder(const std::string& folder, std::str
         return -1;
     }
 
+    long user = it->second->user;
     delete it->second;
     it->second = NULL;
     watch_folders.erase(it);
     CS.Leave();
+
+    // Not watched anymore, the files are analyzed again if the folder is added back
+    std::string err;
+    core->watch_folder_remove_files(user, folder, err);
     return 0;
 }
 
@@ -18,11 +18,404 @@
 #include <fstream>
 #include <sstream>
 #include <string.h>
+#include <stdarg.h>
 //---------------------------------------------------------------------------
 
 //---------------------------------------------------------------------------
 namespace MediaConch {
 
+//***************************************************************************
+// XsltCache
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+XsltCache::XsltCache(size_t max) : max_entries(max), use_counter(0)
+{
+    exsltRegisterAll();
+}
+
+//---------------------------------------------------------------------------
+XsltCache::~XsltCache()
+{
+    std::multimap<size_t, Entry*>::iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+    {
+        if (it->second->style)
+            xsltFreeStylesheet(it->second->style);
+        delete it->second;
+    }
+    entries.clear();
+
+    // Globals are shared by the cached stylesheets, only cleaned once they are freed
+    xsltCleanupGlobals();
+}
+
+//---------------------------------------------------------------------------
+xsltStylesheetPtr XsltCache::acquire(const std::string& memory, bool no_https, std::vector<std::string>& errors)
+{
+    size_t hash = hash_content(memory);
+
+    cond.lock();
+    Entry *entry = NULL;
+    while ((entry = find(hash, memory, no_https)) && !entry->style)
+        // Being compiled by another request, wait for it instead of compiling it again
+        cond.wait();
+
+    if (entry)
+    {
+        entry->refs++;
+        entry->last_use = ++use_counter;
+        cond.unlock();
+        return entry->style;
+    }
+
+    if (entries.size() >= max_entries)
+        evict_unused();
+
+    // Entry without stylesheet marking the compilation in progress, none if every entry is in use
+    if (entries.size() < max_entries)
+    {
+        entry = new Entry;
+        entry->content = memory;
+        entry->no_https = no_https;
+        entry->style = NULL;
+        entry->refs = 0;
+        entry->last_use = ++use_counter;
+        entries.insert(std::make_pair(hash, entry));
+    }
+    cond.unlock();
+
+    xsltStylesheetPtr style = compile(memory, no_https, errors);
+
+    cond.lock();
+    if (!entry && style)
+        // Not kept in the cache
+        uncached[style] = true;
+    else if (entry)
+    {
+        std::pair<std::multimap<size_t, Entry*>::iterator, std::multimap<size_t, Entry*>::iterator> range = entries.equal_range(hash);
+        for (std::multimap<size_t, Entry*>::iterator it = range.first; it != range.second; ++it)
+            if (it->second == entry)
+            {
+                if (style)
+                {
+                    entry->style = style;
+                    entry->refs = 1;
+                }
+                else
+                {
+                    // The waiting requests compile it again to get their own errors
+                    delete entry;
+                    entries.erase(it);
+                }
+                break;
+            }
+        cond.broadcast();
+    }
+    cond.unlock();
+
+    return style;
+}
+
+//---------------------------------------------------------------------------
+void XsltCache::release(xsltStylesheetPtr style)
+{
+    if (!style)
+        return;
+
+    cond.lock();
+    std::map<xsltStylesheetPtr, bool>::iterator u_it = uncached.find(style);
+    if (u_it != uncached.end())
+    {
+        uncached.erase(u_it);
+        cond.unlock();
+        xsltFreeStylesheet(style);
+        return;
+    }
+
+    std::multimap<size_t, Entry*>::iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+        if (it->second->style == style)
+        {
+            if (it->second->refs)
+                it->second->refs--;
+            break;
+        }
+    cond.unlock();
+}
+
+//---------------------------------------------------------------------------
+XsltCache::Entry* XsltCache::find(size_t hash, const std::string& memory, bool no_https)
+{
+    // Must be called with cond locked
+    std::pair<std::multimap<size_t, Entry*>::iterator, std::multimap<size_t, Entry*>::iterator> range = entries.equal_range(hash);
+    for (std::multimap<size_t, Entry*>::iterator it = range.first; it != range.second; ++it)
+        if (it->second->no_https == no_https && it->second->content == memory)
+            return it->second;
+    return NULL;
+}
+
+//---------------------------------------------------------------------------
+size_t XsltCache::hash_content(const std::string& memory)
+{
+    // FNV-1a
+    size_t hash = (size_t)2166136261UL;
+    for (size_t i = 0; i < memory.size(); ++i)
+    {
+        hash ^= (unsigned char)memory[i];
+        hash *= (size_t)16777619UL;
+    }
+    return hash;
+}
+
+//---------------------------------------------------------------------------
+xsltStylesheetPtr XsltCache::compile(const std::string& memory, bool no_https, std::vector<std::string>& errors)
+{
+    xmlLoadExtDtdDefaultValue = 1;
+    xmlSetGenericErrorFunc(&errors, &manage_generic_error);
+    xsltSetGenericErrorFunc(&errors, &manage_generic_error);
+
+    int doc_flags = XML_PARSE_COMPACT | XML_PARSE_DTDLOAD;
+#ifdef XML_PARSE_BIG_LINES
+    doc_flags |= XML_PARSE_BIG_LINES;
+#endif // !XML_PARSE_BIG_LINES
+
+    xmlDocPtr doc = NULL;
+    if (no_https)
+    {
+        std::string content = memory;
+        Core::unify_no_https(content);
+        doc = xmlReadMemory(content.c_str(), content.length(), NULL, NULL, doc_flags);
+    }
+    else
+        doc = xmlReadMemory(memory.c_str(), memory.length(), NULL, NULL, doc_flags);
+
+    xsltStylesheetPtr style = NULL;
+    if (doc)
+    {
+        // On success, the document is owned by the stylesheet
+        style = xsltParseStylesheetDoc(doc);
+        if (!style)
+            xmlFreeDoc(doc);
+    }
+
+    xsltSetGenericErrorFunc(NULL, NULL);
+    xmlSetGenericErrorFunc(NULL, NULL);
+    return style;
+}
+
+//---------------------------------------------------------------------------
+void XsltCache::evict_unused()
+{
+    // Must be called with cond locked, remove the least recently used entry not in use nor being compiled
+    std::multimap<size_t, Entry*>::iterator oldest = entries.end();
+    std::multimap<size_t, Entry*>::iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+        if (!it->second->refs && it->second->style && (oldest == entries.end() || it->second->last_use < oldest->second->last_use))
+            oldest = it;
+
+    if (oldest == entries.end())
+        return;
+
+    xsltFreeStylesheet(oldest->second->style);
+    delete oldest->second;
+    entries.erase(oldest);
+}
+
+//---------------------------------------------------------------------------
+void XsltCache::manage_generic_error(void *userData, const char* msg, ...)
+{
+    std::vector<std::string> *errors = (std::vector<std::string> *)userData;
+    va_list args;
+
+    va_start(args, msg);
+    errors->push_back(Schema::generic_error_message(msg, args));
+    va_end(args);
+}
+
+//***************************************************************************
+// XmlDocCache
+//***************************************************************************
+
+//---------------------------------------------------------------------------
+XmlDocCache::XmlDocCache(size_t max) : max_entries(max), use_counter(0), version_counter(0), all_version(0)
+{
+}
+
+//---------------------------------------------------------------------------
+XmlDocCache::~XmlDocCache()
+{
+    std::map<std::string, Entry>::iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+        xmlFreeDoc(it->second.doc);
+    entries.clear();
+}
+
+//---------------------------------------------------------------------------
+size_t XmlDocCache::get_version(const std::string& key)
+{
+    CS.Enter();
+    size_t version = current_version(key);
+    ++building[key];
+    CS.Leave();
+    return version;
+}
+
+//---------------------------------------------------------------------------
+xmlDocPtr XmlDocCache::acquire(const std::string& key, size_t version)
+{
+    CS.Enter();
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if (it == entries.end() || it->second.in_use || it->second.version != version)
+    {
+        CS.Leave();
+        return NULL;
+    }
+
+    it->second.in_use = true;
+    it->second.last_use = ++use_counter;
+    xmlDocPtr doc = it->second.doc;
+    CS.Leave();
+
+    return doc;
+}
+
+//---------------------------------------------------------------------------
+void XmlDocCache::release(const std::string& key, size_t version, xmlDocPtr doc)
+{
+    CS.Enter();
+    std::map<std::string, size_t>::iterator b_it = building.find(key);
+    if (b_it != building.end() && !--b_it->second)
+        building.erase(b_it);
+
+    if (!doc)
+    {
+        forget_version(key);
+        CS.Leave();
+        return;
+    }
+
+    bool keep = version == current_version(key);
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    if (it != entries.end())
+    {
+        if (it->second.doc == doc)
+        {
+            if (keep)
+            {
+                it->second.in_use = false;
+                CS.Leave();
+                return;
+            }
+            entries.erase(it);
+        }
+        // Another document is already kept for this key
+        keep = false;
+    }
+
+    if (keep && entries.size() >= max_entries)
+        evict_unused();
+
+    if (keep && entries.size() < max_entries)
+    {
+        Entry entry;
+        entry.doc = doc;
+        entry.version = version;
+        entry.in_use = false;
+        entry.last_use = ++use_counter;
+        entries[key] = entry;
+        CS.Leave();
+        return;
+    }
+    forget_version(key);
+    CS.Leave();
+
+    xmlFreeDoc(doc);
+}
+
+//---------------------------------------------------------------------------
+void XmlDocCache::invalidate(const std::string& key)
+{
+    xmlDocPtr doc = NULL;
+
+    CS.Enter();
+    versions[key] = ++version_counter;
+    std::map<std::string, Entry>::iterator it = entries.find(key);
+    // A document in use is freed when it is released
+    if (it != entries.end() && !it->second.in_use)
+    {
+        doc = it->second.doc;
+        entries.erase(it);
+    }
+    forget_version(key);
+    CS.Leave();
+
+    if (doc)
+        xmlFreeDoc(doc);
+}
+
+//---------------------------------------------------------------------------
+void XmlDocCache::invalidate_all()
+{
+    std::vector<xmlDocPtr> docs;
+
+    CS.Enter();
+    all_version = ++version_counter;
+    versions.clear();
+    std::map<std::string, Entry>::iterator it = entries.begin();
+    while (it != entries.end())
+    {
+        if (it->second.in_use)
+        {
+            ++it;
+            continue;
+        }
+        docs.push_back(it->second.doc);
+        entries.erase(it++);
+    }
+    CS.Leave();
+
+    for (size_t i = 0; i < docs.size(); ++i)
+        xmlFreeDoc(docs[i]);
+}
+
+//---------------------------------------------------------------------------
+size_t XmlDocCache::current_version(const std::string& key)
+{
+    // Must be called with CS locked
+    std::map<std::string, size_t>::iterator it = versions.find(key);
+    if (it == versions.end() || it->second < all_version)
+        return all_version;
+    return it->second;
+}
+
+//---------------------------------------------------------------------------
+void XmlDocCache::forget_version(const std::string& key)
+{
+    // Must be called with CS locked, nothing of an older version can be kept anymore
+    if (entries.find(key) == entries.end() && building.find(key) == building.end())
+        versions.erase(key);
+}
+
+//---------------------------------------------------------------------------
+void XmlDocCache::evict_unused()
+{
+    // Must be called with CS locked, remove the least recently used entry not in use
+    std::map<std::string, Entry>::iterator oldest = entries.end();
+    std::map<std::string, Entry>::iterator it = entries.begin();
+    for (; it != entries.end(); ++it)
+        if (!it->second.in_use && (oldest == entries.end() || it->second.last_use < oldest->second.last_use))
+            oldest = it;
+
+    if (oldest == entries.end())
+        return;
+
+    std::string key = oldest->first;
+    xmlFreeDoc(oldest->second.doc);
+    entries.erase(oldest);
+    forget_version(key);
+}
+
 //***************************************************************************
 // Constructor/Destructor
 //***************************************************************************
@@ -32,12 +425,25 @@ Xslt::Xslt(bool no_https) : Schema(no_https)
 {
     xslt_ctx = NULL;
     doc_ctx = NULL;
+    cache = NULL;
     exsltRegisterAll();
 }
 
 //---------------------------------------------------------------------------
 Xslt::~Xslt()
 {
+    free_stylesheet();
+}
+
+//---------------------------------------------------------------------------
+void Xslt::free_stylesheet()
+{
+    if (cache)
+    {
+        cache->release(xslt_ctx);
+        cache = NULL;
+        xslt_ctx = NULL;
+    }
     if (xslt_ctx)
     {
         xsltFreeStylesheet(xslt_ctx);
@@ -49,7 +455,6 @@ Xslt::~Xslt()
         xmlFreeDoc(doc_ctx);
         doc_ctx = NULL;
     }
-    xsltCleanupGlobals();
 }
 
 //---------------------------------------------------------------------------
@@ -62,18 +467,7 @@ bool Xslt::register_schema_from_doc(void* data)
     xsltSetGenericErrorFunc(this, &manage_generic_error);
     xmlLoadExtDtdDefaultValue = 1;
 
-    if (xslt_ctx)
-    {
-        xsltFreeStylesheet(xslt_ctx);
-        xslt_ctx = NULL;
-        doc_ctx = NULL;
-    }
-
-    if (doc_ctx)
-    {
-        xmlFreeDoc(doc_ctx);
-        doc_ctx = NULL;
-    }
+    free_stylesheet();
 
     doc_ctx = xmlCopyDoc(doc, 1);
     xslt_ctx = xsltParseStylesheetDoc(doc_ctx);
@@ -115,26 +509,67 @@ bool Xslt::register_schema_from_memory(const std::string& schem)
 }
 
 //---------------------------------------------------------------------------
-int Xslt::validate_xml(const std::string& xml, bool)
+bool Xslt::register_schema_from_cache(XsltCache *c, const std::string& schem)
 {
-    report.clear();
+    free_stylesheet();
+
+    xslt_ctx = c->acquire(schem, no_https, errors);
     if (!xslt_ctx)
-        return -1;
+        return false;
+
+    cache = c;
+    return true;
+}
 
+//---------------------------------------------------------------------------
+xmlDocPtr Xslt::parse_xml(const std::string& xml, std::vector<std::string>* errors)
+{
     xmlSubstituteEntitiesDefault(1);
     xmlLoadExtDtdDefaultValue = 1;
 
     int doc_flags = XML_PARSE_COMPACT | XML_PARSE_DTDLOAD;
-    xmlSetGenericErrorFunc(this, &manage_generic_error);
+    if (errors)
+        xmlSetGenericErrorFunc(errors, &XsltCache::manage_generic_error);
 
 #ifdef XML_PARSE_BIG_LINES
     doc_flags =| XML_PARSE_BIG_LINES;
 #endif // !XML_PARSE_BIG_LINES
 
     xmlDocPtr doc = xmlReadMemory(xml.c_str(), xml.length(), NULL, NULL, doc_flags);
+
+    if (errors)
+        xmlSetGenericErrorFunc(NULL, NULL);
+    return doc;
+}
+
+//---------------------------------------------------------------------------
+int Xslt::validate_xml(const std::string& xml, bool silent)
+{
+    report.clear();
+    if (!xslt_ctx)
+        return -1;
+
+    xmlSetGenericErrorFunc(this, &manage_generic_error);
+
+    xmlDocPtr doc = parse_xml(xml);
     if (!doc)
         return -1;
 
+    int ret = validate_xml_from_doc(doc, silent);
+    xmlFreeDoc(doc);
+    return ret;
+}
+
+//---------------------------------------------------------------------------
+int Xslt::validate_xml_from_doc(void* data, bool)
+{
+    report.clear();
+    xmlDocPtr doc = (xmlDocPtr)data;
+    if (!xslt_ctx || !doc)
+        return -1;
+
+    xmlSetGenericErrorFunc(this, &manage_generic_error);
+
     const char** params = NULL;
     std::vector<std::string> vec;
 
@@ -162,16 +597,12 @@ int Xslt::validate_xml(const std::string& xml, bool)
         delete [] params;
 
     if (!res)
-    {
-        xmlFreeDoc(doc);
         return -1;
-    }
 
     xmlChar *doc_txt_ptr = NULL;
     int doc_txt_len = 0;
     if (xsltSaveResultToString(&doc_txt_ptr, &doc_txt_len, res, xslt_ctx) < 0)
     {
-        xmlFreeDoc(doc);
         xmlFreeDoc(res);
         return -1;
     }
@@ -181,7 +612,6 @@ int Xslt::validate_xml(const std::string& xml, bool)
     report = std::string((const char*)doc_txt_ptr+Prefix, doc_txt_len);
     free(doc_txt_ptr);
 
-    xmlFreeDoc(doc);
     xmlFreeDoc(res);
     xmlSetGenericErrorFunc(NULL, NULL);
 
@@ -212,24 +642,4 @@ void Xslt::manage_error(void *userData, xmlErrorPtr err)
     obj->errors.push_back(err->message);
 }
 
-//---------------------------------------------------------------------------
-void Xslt::manage_generic_error(void *userData, const char* msg, ...)
-{
-    Xslt *obj = (Xslt *)userData;
-    va_list args;
-    char buf[4096] = {0};
-
-    va_start(args, msg);
-#ifdef _MSC_VER
-    int ret = vsnprintf_s(buf, sizeof(buf), _TRUNCATE, msg, args);
-#else //_MSC_VER
-    int ret = vsnprintf(buf, sizeof(buf), msg, args);
-    if (ret < 0)
-        ret = 0;
-    buf[ret] = '\0';
-#endif //_MSC_VER
-    obj->errors.push_back(buf);
-    va_end(args);
-}
-
 }
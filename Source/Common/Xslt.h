@@ -21,10 +21,109 @@
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
 #include <string>
+#include <map>
+#include <ZenLib/CriticalSection.h>
 #include "Schema.h"
+#include "Condition.h"
 
 namespace MediaConch {
 
+//***************************************************************************
+// Class XsltCache
+//***************************************************************************
+
+// Compiled stylesheets shared between threads, keyed by content and no_https.
+// A stylesheet given by acquire() stays valid until it is released.
+class XsltCache
+{
+public:
+    //Constructor/Destructor
+    XsltCache(size_t max_entries=64);
+    ~XsltCache();
+
+    xsltStylesheetPtr acquire(const std::string& memory, bool no_https, std::vector<std::string>& errors);
+    void              release(xsltStylesheetPtr style);
+
+    static size_t     hash_content(const std::string& memory);
+
+    // Callbacks, userData is a std::vector<std::string>
+    static void       manage_generic_error(void *userData, const char* msg, ...);
+
+private:
+    XsltCache(const XsltCache&);
+    XsltCache&        operator=(const XsltCache&);
+
+    struct Entry
+    {
+        std::string       content;
+        bool              no_https;
+        xsltStylesheetPtr style; // NULL while being compiled
+        size_t            refs;
+        size_t            last_use;
+    };
+
+    std::multimap<size_t, Entry*>     entries;
+    std::map<xsltStylesheetPtr, bool> uncached;
+    size_t                            max_entries;
+    size_t                            use_counter;
+    Condition                         cond;
+
+    Entry*            find(size_t hash, const std::string& memory, bool no_https);
+    xsltStylesheetPtr compile(const std::string& memory, bool no_https, std::vector<std::string>& errors);
+    void              evict_unused();
+};
+
+//***************************************************************************
+// Class XmlDocCache
+//***************************************************************************
+
+// Parsed documents kept between requests, keyed by the caller.
+// The version of a key changes when it is invalidated, a document built for
+// an older version is not kept. A document given by acquire() is only used
+// by this caller until it is released.
+// Each get_version() must be followed by a release(), with a NULL document
+// if none was built, the version of a key is only kept while it is cached
+// or a document is built for it.
+class XmlDocCache
+{
+public:
+    //Constructor/Destructor
+    XmlDocCache(size_t max_entries);
+    ~XmlDocCache();
+
+    size_t            get_version(const std::string& key);
+    xmlDocPtr         acquire(const std::string& key, size_t version);
+    void              release(const std::string& key, size_t version, xmlDocPtr doc);
+    void              invalidate(const std::string& key);
+    void              invalidate_all();
+
+private:
+    XmlDocCache(const XmlDocCache&);
+    XmlDocCache&      operator=(const XmlDocCache&);
+
+    struct Entry
+    {
+        xmlDocPtr         doc;
+        size_t            version;
+        bool              in_use;
+        size_t            last_use;
+    };
+
+    std::map<std::string, Entry>  entries;
+    std::map<std::string, size_t> versions;
+    // Documents being built, by key, between get_version() and release()
+    std::map<std::string, size_t> building;
+    size_t                        max_entries;
+    size_t                        use_counter;
+    size_t                        version_counter;
+    size_t                        all_version;
+    ZenLib::CriticalSection       CS;
+
+    size_t            current_version(const std::string& key);
+    void              forget_version(const std::string& key);
+    void              evict_unused();
+};
+
 //***************************************************************************
 // Class Xslt
 //***************************************************************************
@@ -40,9 +139,16 @@ public:
     virtual bool register_schema_from_doc(void* doc);
 
     virtual int  validate_xml(const std::string& xml, bool silent=true);
+    // The document is not modified, it can be used for several stylesheets
+    virtual int  validate_xml_from_doc(void* doc, bool silent=true);
+
+    // Parse an XML report the same way validate_xml() does, errors are collected if given
+    static xmlDocPtr parse_xml(const std::string& xml, std::vector<std::string>* errors=NULL);
 
-    // Callbacks
-    static void  manage_generic_error(void *userData, const char* msg, ...);
+    // Use a compiled stylesheet from the cache instead of compiling it again
+    bool         register_schema_from_cache(XsltCache *cache, const std::string& schem);
+
+    // Callbacks, the generic errors are the ones of Schema
     static void  manage_error(void *userData, xmlErrorPtr err);
 
 private:
@@ -51,6 +157,9 @@ private:
 
     xsltStylesheetPtr xslt_ctx;
     xmlDocPtr         doc_ctx;
+    XsltCache        *cache;
+
+    void              free_stylesheet();
 };
 
 }
@@ -15,6 +15,7 @@
 #include "Policy.h"
 #include "XsltPolicy.h"
 #include "Xslt.h"
+#include "Core.h"
 #include <iostream>
 #include <sstream>
 #include <string.h>
@@ -150,13 +151,14 @@ void XsltPolicyRule::create_default_name(std::string& name)
 //***************************************************************************
 
 //---------------------------------------------------------------------------
-XsltPolicy::XsltPolicy(Policies *p, bool no_https) : Policy(p, Policies::POLICY_XSLT, no_https), XsltPolicyNode()
+XsltPolicy::XsltPolicy(Policies *p, bool no_https) : Policy(p, Policies::POLICY_XSLT, no_https), XsltPolicyNode(),
+                                                      version(0), final_xslt_version((size_t)-1)
 {
     kind = XSLT_POLICY_POLICY;
 }
 
 //---------------------------------------------------------------------------
-XsltPolicy::XsltPolicy(const XsltPolicy* s) : Policy(s), XsltPolicyNode(s)
+XsltPolicy::XsltPolicy(const XsltPolicy* s) : Policy(s), XsltPolicyNode(s), version(0), final_xslt_version((size_t)-1)
 {
     type = Policies::POLICY_XSLT;
 
@@ -179,7 +181,8 @@ XsltPolicy::XsltPolicy(const XsltPolicy* s) : Policy(s), XsltPolicyNode(s)
 }
 
 //---------------------------------------------------------------------------
-XsltPolicy::XsltPolicy(const XsltPolicy& s, bool is_system) : Policy(s), XsltPolicyNode(s)
+XsltPolicy::XsltPolicy(const XsltPolicy& s, bool is_system) : Policy(s), XsltPolicyNode(s), version(0),
+                                                               final_xslt_version((size_t)-1)
 {
     if (&s == this)
         return;
@@ -219,17 +222,45 @@ XsltPolicy::~XsltPolicy()
 //---------------------------------------------------------------------------
 int XsltPolicy::get_final_xslt(std::string& xslt, const std::map<std::string, std::string>& opts)
 {
-    if (dump_schema(xslt) < 0)
-        return -1;
+    std::string options = Core::serialize_string_from_options_map(opts);
 
-    if (policies->transform_with_xslt_memory(xslt, policy_transform_xml, opts, xslt) < 0)
+    final_xslt_CS.Enter();
+    if (final_xslt_version == version && final_xslt_options == options)
+    {
+        xslt = final_xslt;
+        final_xslt_CS.Leave();
+        return 0;
+    }
+
+    if (dump_schema(xslt) < 0 || policies->transform_with_xslt_memory(xslt, policy_transform_xml, opts, xslt) < 0)
+    {
+        final_xslt_CS.Leave();
         return -1;
+    }
 
     replace_aliasxsl_in_policy(xslt);
     replace_xlmns_in_policy(xslt);
+
+    final_xslt = xslt;
+    final_xslt_options = options;
+    final_xslt_version = version;
+    final_xslt_CS.Leave();
     return 0;
 }
 
+//---------------------------------------------------------------------------
+void XsltPolicy::invalidate_final_xslt()
+{
+    final_xslt_CS.Enter();
+    ++version;
+    final_xslt = std::string();
+    final_xslt_CS.Leave();
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+        if (nodes[i] && nodes[i]->kind == XSLT_POLICY_POLICY)
+            ((XsltPolicy*)nodes[i])->invalidate_final_xslt();
+}
+
 //***************************************************************************
 // XsltPolicy Parsing
 //***************************************************************************
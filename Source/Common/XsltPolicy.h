@@ -29,6 +29,7 @@
 #include <list>
 #include <vector>
 #include <libxml/tree.h>
+#include <ZenLib/CriticalSection.h>
 #include "Policy.h"
 using namespace MediaInfoNameSpace;
 //---------------------------------------------------------------------------
@@ -113,6 +114,8 @@ public:
     XsltPolicyRule* get_policy_rule(int id, std::string& err);
     int             get_final_xslt(std::string& xslt, const std::map<std::string, std::string>& opts);
     int             delete_policy_rule(int rule_id, std::string& err);
+    // Must be called on the root policy after any change in the tree
+    void            invalidate_final_xslt();
 
     //TODO
     std::vector<XsltPolicyNode*>  nodes;
@@ -121,6 +124,13 @@ private:
 
     XsltPolicy& operator=(const XsltPolicy&);
 
+    // Final XSLT built for the version, with the options, kept until the policy changes
+    size_t                        version;
+    size_t                        final_xslt_version;
+    std::string                   final_xslt;
+    std::string                   final_xslt_options;
+    ZenLib::CriticalSection       final_xslt_CS;
+
     xmlDocPtr create_doc();
     int       import_schema_from_doc(xmlDocPtr doc, const std::string& filename);
 
@@ -87,6 +87,21 @@ namespace MediaConch
             httpd->set_address(address);
         if (port != -1)
             httpd->set_port(port);
+
+        // Heavy commands are run by the workers
+        size_t workers = 4;
+        std::map<std::string, size_t> limits;
+        MCL->get_daemon_workers(workers, limits);
+        httpd->set_workers(workers);
+        std::map<std::string, size_t>::iterator it = limits.begin();
+        for (; it != limits.end(); ++it)
+            httpd->set_endpoint_limit(it->first, it->second);
+
+        // Policies imported and validations with policies contents can be large
+        size_t max_body_size = 64 * 1024 * 1024;
+        MCL->get_daemon_max_body_size(max_body_size);
+        httpd->set_max_body_size(max_body_size);
+
         if (httpd->init(err) < 0)
         {
             std::clog << err << std::endl;
@@ -110,6 +125,8 @@ namespace MediaConch
         httpd->commands.checker_id_from_filename_cb = on_checker_id_from_filename_command;
         httpd->commands.checker_file_information_cb = on_checker_file_information_command;
         httpd->commands.checker_list_mediainfo_outputs_cb = on_checker_list_mediainfo_outputs_command;
+        httpd->commands.checker_events_cb = on_checker_events_command;
+        httpd->commands.checker_report_raw_cb = on_checker_report_raw_command;
         httpd->commands.default_values_for_type_cb = on_default_values_for_type_command;
 
         httpd->commands.xslt_policy_create_cb = on_xslt_policy_create_command;
@@ -136,6 +153,8 @@ namespace MediaConch
         httpd->commands.xslt_policy_rule_duplicate_cb = on_xslt_policy_rule_duplicate_command;
         httpd->commands.xslt_policy_rule_move_cb = on_xslt_policy_rule_move_command;
         httpd->commands.xslt_policy_rule_delete_cb = on_xslt_policy_rule_delete_command;
+
+        MCL->register_analyze_finished_callback(on_analyze_finished, this);
         return 0;
     }
 
@@ -235,6 +254,7 @@ namespace MediaConch
     //--------------------------------------------------------------------------
     int Daemon::finish()
     {
+        MCL->register_analyze_finished_callback(NULL, NULL);
         if (httpd)
             httpd->finish();
         MCL->close();
@@ -415,6 +435,10 @@ namespace MediaConch
             mode = MediaConchLib::compression_None;
         else if (mode_str == "zlib")
             mode = MediaConchLib::compression_ZLib;
+        else if (mode_str == "zstd")
+            mode = MediaConchLib::compression_ZStd;
+        else if (mode_str == "lz4")
+            mode = MediaConchLib::compression_LZ4;
         else
         {
             Help();
@@ -976,7 +1000,7 @@ namespace MediaConch
         else
         {
             res.ok = new RESTAPI::Checker_Report_Ok;
-            res.ok->report = result.report;
+            res.ok->report.swap(result.report);
             res.ok->has_valid = result.has_valid;
             res.ok->valid = result.valid;
         }
@@ -1197,6 +1221,82 @@ namespace MediaConch
         FUN_CMD_END(Checker_List_MediaInfo_Outputs)
     }
 
+    //--------------------------------------------------------------------------
+    FUN_CMD_PROTO(checker_events, Checker_Events)
+    {
+        // Called again by the server while the request is waiting, only the events are logged
+        Daemon *d = (Daemon*)arg;
+        if (!d || !req)
+            return -1;
+
+        MediaConchLib::Checker_EventsRes events;
+        std::string err;
+        if (d->MCL->checker_events(req->user, req->last_event, 0, events, err) < 0)
+        {
+            FUN_CMD_NOK(res, err, -1)
+            return 0;
+        }
+
+        res.last_event = events.last_event;
+        res.events_lost = events.events_lost;
+        res.finished = events.finished;
+        for (size_t i = 0; i < events.progress.size(); ++i)
+        {
+            RESTAPI::Checker_Events_Progress progress;
+            progress.id = events.progress[i].first;
+            progress.percent = events.progress[i].second;
+            res.progress.push_back(progress);
+        }
+
+        if (res.finished.size() || res.events_lost)
+        {
+            std::clog << d->get_date() << "Daemon received Checker_Events command:" << req->to_str() << std::endl;
+            FUN_CMD_END(Checker_Events)
+        }
+        return 0;
+    }
+
+    //--------------------------------------------------------------------------
+    void Daemon::on_analyze_finished(void *arg)
+    {
+        // Called by the thread of the analysis, the requests of events waiting are answered by the server thread
+        Daemon *d = (Daemon*)arg;
+        if (d && d->httpd)
+            d->httpd->analyze_finished();
+    }
+
+    //--------------------------------------------------------------------------
+    FUN_CMD_PROTO(checker_report_raw, Checker_Report_Raw)
+    {
+        FUN_CMD_START(Checker_Report_Raw)
+
+        MediaConchLib::report kind = MediaConchLib::report_Max;
+        if (req->report == RESTAPI::MEDIAINFO)
+            kind = MediaConchLib::report_MediaInfo;
+        else if (req->report == RESTAPI::MEDIATRACE)
+            kind = MediaConchLib::report_MicroMediaTrace;
+        else if (req->report == RESTAPI::VERAPDF)
+            kind = MediaConchLib::report_MediaVeraPdf;
+        else if (req->report == RESTAPI::DPFMANAGER)
+            kind = MediaConchLib::report_MediaDpfManager;
+
+        // The range is applied by the server on the report sent
+        MediaConchLib::Checker_ReportRawRes result;
+        std::string err;
+        if (kind == MediaConchLib::report_Max)
+            FUN_CMD_NOK(res, "Report kind asked is not saved.", req->id)
+        else if (d->MCL->checker_get_report_raw(req->user, req->id, kind, req->accept_deflate, result, err) < 0)
+            FUN_CMD_NOK(res, err, req->id)
+        else
+        {
+            res.report.swap(result.report);
+            res.deflate = result.compress == MediaConchLib::compression_ZLib;
+            res.uncompressed_size = result.uncompressed_size;
+        }
+
+        FUN_CMD_END(Checker_Report_Raw)
+    }
+
     //--------------------------------------------------------------------------
     FUN_CMD_PROTO(default_values_for_type, Default_Values_For_Type)
     {
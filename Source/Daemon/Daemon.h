@@ -121,6 +121,11 @@ namespace MediaConch
                                                        RESTAPI::Checker_File_Information_Res& res, void *arg);
         static int on_checker_list_mediainfo_outputs_command(const RESTAPI::Checker_List_MediaInfo_Outputs_Req* req,
                                                              RESTAPI::Checker_List_MediaInfo_Outputs_Res& res, void *arg);
+        static int on_checker_events_command(const RESTAPI::Checker_Events_Req* req,
+                                             RESTAPI::Checker_Events_Res& res, void *arg);
+        static void on_analyze_finished(void *arg);
+        static int on_checker_report_raw_command(const RESTAPI::Checker_Report_Raw_Req* req,
+                                                 RESTAPI::Checker_Report_Raw_Res& res, void *arg);
         static int on_default_values_for_type_command(const RESTAPI::Default_Values_For_Type_Req* req,
                                                       RESTAPI::Default_Values_For_Type_Res& res, void *arg);
 
@@ -1373,7 +1373,7 @@ int MainWindow::is_analyze_finished(const std::vector<std::string>& files,
                                     std::vector<MediaConchLib::Checker_StatusRes>& res, std::string& err)
 {
     std::vector<long> files_id;
-    for (size_t i = 0; ; )
+    for (size_t i = 0; i < files.size(); ++i)
     {
         long id = workerfiles.get_id_from_registered_file(files[i]);
         if (id < 0)
@@ -1396,6 +1396,13 @@ int MainWindow::is_analyze_finished(const std::string& file, MediaConchLib::Chec
     return MCL.checker_status(user, id, res, err);
 }
 
+//---------------------------------------------------------------------------
+int MainWindow::analyze_events(long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res,
+                               std::string& err)
+{
+    return MCL.checker_events(user, last_event, timeout, res, err);
+}
+
 //---------------------------------------------------------------------------
 int MainWindow::validate(MediaConchLib::report report, const std::vector<std::string>& files,
                          const std::vector<size_t>& policies_ids,
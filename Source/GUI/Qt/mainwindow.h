@@ -95,6 +95,8 @@ public:
     int                         is_analyze_finished(const std::vector<std::string>& files,
                                                     std::vector<MediaConchLib::Checker_StatusRes>& res,std::string& err);
     int                         is_analyze_finished(const std::string& file, MediaConchLib::Checker_StatusRes& res, std::string& err);
+    int                         analyze_events(long last_event, size_t timeout, MediaConchLib::Checker_EventsRes& res,
+                                               std::string& err);
     int                         validate(MediaConchLib::report report, const std::vector<std::string>& files,
                                          const std::vector<size_t>& policies_ids,
                                          const std::vector<std::string>& policies_contents,
@@ -22,7 +22,7 @@ namespace MediaConch {
 
 //---------------------------------------------------------------------------
 WorkerFiles::WorkerFiles(MainWindow* m) : QThread(), mainwindow(m), db(NULL), timer(NULL),
-                                          file_index(0)
+                                          file_index(0), events_last(-1)
 {
 }
 
@@ -50,7 +50,7 @@ void WorkerFiles::run()
     timer->moveToThread(this);
     timer->setSingleShot(true);
     connect(timer, SIGNAL(timeout()), this, SLOT(update_files_registered()), Qt::DirectConnection);
-    timer->start(1000); //TODO
+    timer->start(0);
     exec();
     if (timer)
     {
@@ -505,7 +505,8 @@ void WorkerFiles::update_files_registered()
         timer = NULL;
     }
 
-    update_unfinished_files();
+    // Waiting for the events replaces the delay between two updates
+    bool waited = update_unfinished_files();
     update_add_files_registered();
     update_delete_files_registered();
     update_update_files_registered();
@@ -514,7 +515,7 @@ void WorkerFiles::update_files_registered()
     timer->moveToThread(this);
     timer->setSingleShot(true);
     connect(timer, SIGNAL(timeout()), this, SLOT(update_files_registered()), Qt::DirectConnection);
-    timer->start(1000); //TODO
+    timer->start(waited ? 0 : 1000);
 }
 
 //---------------------------------------------------------------------------
@@ -601,15 +602,31 @@ void WorkerFiles::update_delete_files_registered()
 }
 
 //---------------------------------------------------------------------------
-void WorkerFiles::update_unfinished_files()
+bool WorkerFiles::update_unfinished_files()
 {
     std::string err;
 
+    // Block until a file is finished, at most the delay between two updates
+    bool subscribed = events_last >= 0;
+    MediaConchLib::Checker_EventsRes events;
+    if (mainwindow->analyze_events(events_last, 1000, events, err) < 0)
+    {
+        mainwindow->set_str_msg_to_status_bar(err);
+        return false;
+    }
+    events_last = events.last_event;
+
+    std::set<long> finished(events.finished.begin(), events.finished.end());
+    std::map<long, double> progress(events.progress.begin(), events.progress.end());
+
     unfinished_files_mutex.lock();
     std::vector<std::string> files = unfinished_files;
     unfinished_files_mutex.unlock();
 
+    // Status only of the new files and of the files finished
     std::vector<std::string> vec;
+    std::vector<std::string> registered;
+    std::vector<FileRegistered*> frs;
     for (size_t i = 0; i < files.size(); ++i)
     {
         FileRegistered* fr = get_file_registered_from_file(files[i]);
@@ -619,14 +636,57 @@ void WorkerFiles::update_unfinished_files()
             continue;
         }
 
-        MediaConchLib::Checker_StatusRes st_res;
-        int ret = mainwindow->is_analyze_finished(files[i], st_res, err);
-        if (ret < 0)
+        if (subscribed && !events.events_lost && finished.find(fr->file_id) == finished.end() &&
+            files_waiting_events.find(fr->file_id) != files_waiting_events.end())
         {
-            mainwindow->set_str_msg_to_status_bar(err);
+            std::map<long, double>::iterator it = progress.find(fr->file_id);
+            if (it != progress.end() && it->second != fr->analyze_percent)
+            {
+                fr->analyze_percent = it->second;
+                to_update_files_mutex.lock();
+                if (to_update_files.find(files[i]) != to_update_files.end())
+                    delete to_update_files[files[i]];
+                to_update_files[files[i]] = new FileRegistered(*fr);
+                to_update_files_mutex.unlock();
+
+                working_files_mutex.lock();
+                if (working_files.find(files[i]) != working_files.end())
+                {
+                    delete working_files[files[i]];
+                    working_files[files[i]] = fr;
+                    fr = NULL;
+                }
+                working_files_mutex.unlock();
+            }
+            delete fr;
+            vec.push_back(files[i]);
             continue;
         }
 
+        registered.push_back(files[i]);
+        frs.push_back(fr);
+    }
+
+    // Status of all the files in one request, retried at the next update if it failed
+    std::vector<MediaConchLib::Checker_StatusRes> statuses;
+    if (registered.size() && (mainwindow->is_analyze_finished(registered, statuses, err) < 0 ||
+                              statuses.size() != registered.size()))
+    {
+        mainwindow->set_str_msg_to_status_bar(err);
+        for (size_t i = 0; i < frs.size(); ++i)
+        {
+            vec.push_back(registered[i]);
+            delete frs[i];
+        }
+        registered.clear();
+        frs.clear();
+    }
+
+    for (size_t i = 0; i < registered.size(); ++i)
+    {
+        FileRegistered* fr = frs[i];
+        const MediaConchLib::Checker_StatusRes& st_res = statuses[i];
+
         fr->analyzed = st_res.finished;
         if (st_res.finished)
         {
@@ -642,7 +702,7 @@ void WorkerFiles::update_unfinished_files()
             std::map<std::string, std::string> options;
             std::vector<MediaConchLib::Checker_ValidateRes*> res;
 
-            if (mainwindow->validate((MediaConchLib::report)fr->report_kind, files[i],
+            if (mainwindow->validate((MediaConchLib::report)fr->report_kind, registered[i],
                 policies_ids, policies_contents, options, res, err) < 0)
             {
                 mainwindow->set_str_msg_to_status_bar(err);
@@ -663,7 +723,7 @@ void WorkerFiles::update_unfinished_files()
             {
                 policies_ids.push_back(fr->policy);
 
-                if (mainwindow->validate(MediaConchLib::report_Max, files[i],
+                if (mainwindow->validate(MediaConchLib::report_Max, registered[i],
                     policies_ids, policies_contents, options, res, err) < 0)
                     continue;
 
@@ -681,24 +741,25 @@ void WorkerFiles::update_unfinished_files()
             fr->analyze_percent = 0.0;
             if (st_res.percent)
                 fr->analyze_percent = *st_res.percent;
-            vec.push_back(files[i]);
+            vec.push_back(registered[i]);
+            files_waiting_events.insert(fr->file_id);
         }
 
         to_update_files_mutex.lock();
-        if (to_update_files.find(files[i]) != to_update_files.end())
+        if (to_update_files.find(registered[i]) != to_update_files.end())
         {
-            delete to_update_files[files[i]];
-            to_update_files[files[i]] = new FileRegistered(*fr);
+            delete to_update_files[registered[i]];
+            to_update_files[registered[i]] = new FileRegistered(*fr);
         }
         else
-            to_update_files[files[i]] = new FileRegistered(*fr);
+            to_update_files[registered[i]] = new FileRegistered(*fr);
         to_update_files_mutex.unlock();
 
         working_files_mutex.lock();
-        if (working_files.find(files[i]) != working_files.end())
+        if (working_files.find(registered[i]) != working_files.end())
         {
-            delete working_files[files[i]];
-            working_files[files[i]] = fr;
+            delete working_files[registered[i]];
+            working_files[registered[i]] = fr;
         }
         else
             delete fr;
@@ -720,6 +781,18 @@ void WorkerFiles::update_unfinished_files()
     }
     unfinished_files = vec;
     unfinished_files_mutex.unlock();
+
+    // Only the files still not finished
+    std::set<long> waiting;
+    for (size_t i = 0; i < vec.size(); ++i)
+    {
+        long id = get_id_from_registered_file(vec[i]);
+        if (files_waiting_events.find(id) != files_waiting_events.end())
+            waiting.insert(id);
+    }
+    files_waiting_events.swap(waiting);
+
+    return true;
 }
 
 //---------------------------------------------------------------------------
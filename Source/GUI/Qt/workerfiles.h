@@ -8,6 +8,7 @@
 #define WORKERFILES_H
 
 #include <map>
+#include <set>
 #include <vector>
 #include <string>
 #include <QThread>
@@ -62,7 +63,7 @@ private:
     void remove_registered_files_from_db(const std::vector<FileRegistered*>& files);
     void remove_all_registered_file_from_db();
 
-    void update_unfinished_files();
+    bool update_unfinished_files();
     void update_add_files_registered();
     void update_delete_files_registered();
     void update_update_files_registered();
@@ -90,6 +91,10 @@ private:
 
     std::vector<std::string>                unfinished_files;
     QMutex                                  unfinished_files_mutex;
+
+    // Last event of the analyses, the files already known as not finished get their status when finished
+    long                                    events_last;
+    std::set<long>                          files_waiting_events;
 };
 
 }
@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+
+# Time the lookups done by MediaConch on its SQLite database, with the schema
+# before and after the indexes of the database version 8.
+#
+# Usage: database_lookups.sh [SIZE...]
+#   SIZE: number of files in the generated database (default: 10000 100000 1000000)
+
+SQLITE3="${SQLITE3:-sqlite3}"
+LOOKUPS="${LOOKUPS:-100}"
+
+if ! command -v "$SQLITE3" > /dev/null 2>&1 ; then
+    echo "$SQLITE3 not found, set SQLITE3 to the sqlite3 shell" >&2
+    exit 1
+fi
+
+if [ "$#" -eq 0 ] ; then
+    set -- 10000 100000 1000000
+fi
+
+DIR="$(mktemp -d)"
+trap 'rm -rf "$DIR"' EXIT
+
+# Schema of the database version 7
+create_database() {
+    "$SQLITE3" "$1" <<SQL
+PRAGMA journal_mode=OFF;
+PRAGMA synchronous=OFF;
+CREATE TABLE MEDIACONCH_FILE (ID INTEGER PRIMARY KEY ASC, USER INT DEFAULT -1, FILENAME TEXT NOT NULL,
+    FILE_LAST_MODIFICATION TEXT NOT NULL, ANALYZED INT DEFAULT 0, HAS_ERROR INT DEFAULT 0, ERROR_LOG TEXT,
+    GENERATED_ID TEXT DEFAULT "", SOURCE_ID INT DEFAULT -1, GENERATED_TIME INT DEFAULT -1, GENERATED_LOG TEXT,
+    GENERATED_ERROR_LOG TEXT, OPTIONS TEXT DEFAULT "" NOT NULL);
+CREATE TABLE MEDIACONCH_REPORT (FILE_ID INT NOT NULL, TOOL INT NOT NULL, FORMAT INT NOT NULL,
+    COMPRESS INT DEFAULT 0 NOT NULL, MIL_VERSION INT DEFAULT 0 NOT NULL, REPORT TEXT, OPTIONS TEXT DEFAULT "");
+WITH RECURSIVE N(I) AS (SELECT 1 UNION ALL SELECT I + 1 FROM N WHERE I < $2)
+INSERT INTO MEDIACONCH_FILE (ID, USER, FILENAME, FILE_LAST_MODIFICATION, ANALYZED, OPTIONS)
+    SELECT I, I % 10, '/media/dir' || (I / 1000) || '/file' || I || '.mkv', '2017-01-01 00:00:00', 1, '' FROM N;
+INSERT INTO MEDIACONCH_REPORT (FILE_ID, TOOL, FORMAT, REPORT, OPTIONS)
+    SELECT ID, 2, 0, 'report', '' FROM MEDIACONCH_FILE;
+INSERT INTO MEDIACONCH_REPORT (FILE_ID, TOOL, FORMAT, REPORT, OPTIONS)
+    SELECT ID, 4, 0, 'report', '' FROM MEDIACONCH_FILE;
+SQL
+}
+
+# Indexes added by the database version 8
+add_indexes() {
+    "$SQLITE3" "$1" <<SQL
+CREATE UNIQUE INDEX IF NOT EXISTS MEDIACONCH_REPORT_IDENTITY ON MEDIACONCH_REPORT (FILE_ID, TOOL, FORMAT, OPTIONS);
+CREATE INDEX IF NOT EXISTS MEDIACONCH_FILE_LOOKUP ON MEDIACONCH_FILE (FILENAME, USER, OPTIONS, FILE_LAST_MODIFICATION);
+CREATE INDEX IF NOT EXISTS MEDIACONCH_FILE_USER ON MEDIACONCH_FILE (USER);
+SQL
+}
+
+# Same queries as SQLLiteReport::get_file_id and SQLLiteReport::report_is_registered
+run_lookups() {
+    "$SQLITE3" "$1" <<SQL
+CREATE TEMP TABLE LOOKUP AS
+    WITH RECURSIVE N(I) AS (SELECT 1 UNION ALL SELECT I + 1 FROM N WHERE I < $LOOKUPS)
+    SELECT 1 + ABS(RANDOM()) % $2 AS ID FROM N;
+.timer on
+SELECT 'get_file_id', COUNT(*) FROM LOOKUP L WHERE (SELECT F.ID FROM MEDIACONCH_FILE F
+    WHERE F.FILENAME = '/media/dir' || (L.ID / 1000) || '/file' || L.ID || '.mkv'
+    AND F.USER = L.ID % 10 AND F.OPTIONS = '' AND F.FILE_LAST_MODIFICATION = '2017-01-01 00:00:00') IS NOT NULL;
+SELECT 'report_is_registered', COUNT(*) FROM LOOKUP L WHERE (SELECT COUNT(R.REPORT) FROM MEDIACONCH_REPORT R
+    WHERE R.FILE_ID = L.ID AND R.TOOL = 4 AND R.FORMAT = 0 AND R.OPTIONS = '') > 0;
+.timer off
+EXPLAIN QUERY PLAN SELECT ID FROM MEDIACONCH_FILE WHERE FILENAME = ? AND USER = ? AND OPTIONS = ? AND FILE_LAST_MODIFICATION = ?;
+EXPLAIN QUERY PLAN SELECT COUNT(REPORT) FROM MEDIACONCH_REPORT WHERE FILE_ID = ? AND TOOL = ? AND FORMAT = ? AND OPTIONS = ?;
+SQL
+}
+
+for SIZE in "$@" ; do
+    DB="$DIR/MediaConch_$SIZE.db"
+    create_database "$DB" "$SIZE" > /dev/null || exit 1
+
+    echo "=== $SIZE files, $LOOKUPS lookups, without indexes"
+    run_lookups "$DB" "$SIZE"
+
+    add_indexes "$DB" || exit 1
+    echo "=== $SIZE files, $LOOKUPS lookups, with indexes"
+    run_lookups "$DB" "$SIZE"
+
+    rm -f "$DB"
+done
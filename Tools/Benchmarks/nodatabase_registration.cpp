@@ -0,0 +1,94 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Registration cost of the files in the in-memory database
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#include "Common/NoDatabaseReport.h"
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sstream>
+//---------------------------------------------------------------------------
+
+using namespace MediaConch;
+
+//---------------------------------------------------------------------------
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+//---------------------------------------------------------------------------
+static std::string file_name(long i)
+{
+    std::stringstream name;
+    name << "/media/dir" << i / 1000 << "/file" << i << ".mkv";
+    return name.str();
+}
+
+//---------------------------------------------------------------------------
+// Same calls as Core::checker_analyze and Core::save_reports_to_database for each file
+static void run(long size)
+{
+    NoDatabaseReport db;
+    std::string err;
+    std::vector<long> generated_id;
+    std::vector<DatabaseReportEntry> entries(2);
+    entries[0].report_kind = MediaConchLib::report_MediaInfo;
+    entries[0].report = "report";
+    entries[1].report_kind = MediaConchLib::report_MicroMediaTrace;
+    entries[1].report = "report";
+
+    db.init_report();
+
+    double start = now();
+    for (long i = 0; i < size; ++i)
+    {
+        std::string name = file_name(i);
+        if (db.get_file_id(0, name, "2017-01-01 00:00:00", "", err) >= 0)
+            continue;
+
+        long id = db.add_file(0, name, "2017-01-01 00:00:00", "", err, generated_id);
+        db.save_reports(0, id, entries, true, err);
+    }
+    double registration = now() - start;
+
+    start = now();
+    bool registered = false;
+    for (long i = 0; i < size; ++i)
+    {
+        long id = db.get_file_id(0, file_name(i), "2017-01-01 00:00:00", "", err);
+        db.report_is_registered(0, id, MediaConchLib::report_MicroMediaTrace, MediaConchLib::format_Xml, "",
+                                registered, err);
+    }
+    double lookups = now() - start;
+
+    printf("%10ld files    registration %8.3f s (%6.2f us/file)    lookups %8.3f s (%6.2f us/file)\n",
+           size, registration, registration * 1000000 / size, lookups, lookups * 1000000 / size);
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        run(10000);
+        run(100000);
+        return 0;
+    }
+
+    for (int i = 1; i < argc; ++i)
+        run(atol(argv[i]));
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+
+# Time the registration and the lookups of files in the in-memory database
+# used when MediaConch runs without SQLite (NoDatabaseReport).
+#
+# Usage: nodatabase_registration.sh [SIZE...]
+#   SIZE: number of files registered (default: 10000 100000)
+
+SOURCE="$(cd "$(dirname "$0")/../../Source" && pwd)"
+CXX="${CXX:-c++}"
+if [ -z "$CXXFLAGS" ] ; then
+    CXXFLAGS="-O2 $(pkg-config --cflags libmediainfo 2> /dev/null)"
+fi
+
+DIR="$(mktemp -d)"
+trap 'rm -rf "$DIR"' EXIT
+
+$CXX $CXXFLAGS -I"$SOURCE" -I"$SOURCE/Common" -o "$DIR/nodatabase_registration" \
+    "$(dirname "$0")/nodatabase_registration.cpp" \
+    "$SOURCE/Common/NoDatabaseReport.cpp" "$SOURCE/Common/DatabaseReport.cpp" "$SOURCE/Common/Database.cpp" || exit 1
+
+"$DIR/nodatabase_registration" "$@"
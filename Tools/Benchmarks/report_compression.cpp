@@ -0,0 +1,192 @@
+/*  Copyright (c) MediaArea.net SARL. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a GPLv3+/MPLv2+ license that can
+ *  be found in the License.html file in the root of the source tree.
+ */
+
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+//
+// Compression ratio and speed of the reports saved in the database
+//
+//+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+
+//---------------------------------------------------------------------------
+#include "Common/Compression.h"
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+//---------------------------------------------------------------------------
+
+using namespace MediaConch;
+
+//---------------------------------------------------------------------------
+struct Codec
+{
+    const char*                name;
+    MediaConchLib::compression compress;
+    int                        level;
+};
+
+static const Codec codecs[] =
+{
+    {"zlib",  MediaConchLib::compression_ZLib, 1},
+    {"zlib",  MediaConchLib::compression_ZLib, 6},
+    {"zlib",  MediaConchLib::compression_ZLib, 9},
+    {"zstd",  MediaConchLib::compression_ZStd, 1},
+    {"zstd",  MediaConchLib::compression_ZStd, 3},
+    {"zstd",  MediaConchLib::compression_ZStd, 9},
+    {"zstd",  MediaConchLib::compression_ZStd, 19},
+    {"lz4",   MediaConchLib::compression_LZ4,  0},
+    {"lz4",   MediaConchLib::compression_LZ4,  9},
+};
+
+//---------------------------------------------------------------------------
+static double now()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+//---------------------------------------------------------------------------
+static int read_file(const char* name, std::string& content)
+{
+    std::ifstream file(name, std::ios_base::in | std::ios_base::binary);
+    if (!file.is_open())
+        return -1;
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    content = ss.str();
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+// Same calls as Core when the reports are saved and read, each report is compressed several times
+static int run(const Codec& codec, const std::string& dictionary, const std::vector<std::string>& reports, int repeat)
+{
+    Compression compressor;
+    compressor.set_level(codec.compress, codec.level);
+    std::string err;
+    if (codec.compress == MediaConchLib::compression_ZStd && dictionary.size()
+     && compressor.set_zstd_dictionary(dictionary, err) < 0)
+    {
+        fprintf(stderr, "%s\n", err.c_str());
+        return -1;
+    }
+
+    size_t size = 0;
+    size_t compressed_size = 0;
+    double compression = 0;
+    double decompression = 0;
+    for (size_t i = 0; i < reports.size(); ++i)
+    {
+        MediaConchLib::compression mode = codec.compress;
+        int dictionary_id = 0;
+        std::string report;
+
+        double start = now();
+        for (int j = 0; j < repeat; ++j)
+        {
+            mode = codec.compress;
+            compressor.compress_copy(report, reports[i].c_str(), reports[i].size(), mode, dictionary_id);
+        }
+        compression += now() - start;
+
+        // Not compressed if the result is not smaller
+        if (mode != codec.compress)
+        {
+            fprintf(stderr, "%s %d: report %u is not compressed\n", codec.name, codec.level, (unsigned)i);
+            return -1;
+        }
+
+        std::string dst;
+        start = now();
+        for (int j = 0; j < repeat; ++j)
+        {
+            dst = report;
+            if (compressor.uncompress(dst, mode, reports[i].size(), dictionary_id) < 0)
+                break;
+        }
+        decompression += now() - start;
+
+        if (dst != reports[i])
+        {
+            fprintf(stderr, "%s %d: report %u is not the same after decompression\n", codec.name, codec.level, (unsigned)i);
+            return -1;
+        }
+
+        size += reports[i].size();
+        compressed_size += report.size();
+    }
+
+    if (compression <= 0)
+        compression = 0.000001;
+    if (decompression <= 0)
+        decompression = 0.000001;
+
+    double mb = (double)size * repeat / 1000000;
+    printf("%-6s %5d %12u %8.2f %14.1f %14.1f\n", codec.name, codec.level, (unsigned)compressed_size,
+           (double)size / compressed_size, mb / compression, mb / decompression);
+    return 0;
+}
+
+//---------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+    std::string dictionary;
+    int repeat = 10;
+    std::vector<std::string> reports;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!strcmp(argv[i], "-d") && i + 1 < argc)
+        {
+            if (read_file(argv[++i], dictionary) < 0)
+            {
+                fprintf(stderr, "Cannot read the dictionary %s\n", argv[i]);
+                return 1;
+            }
+            continue;
+        }
+
+        if (!strcmp(argv[i], "-r") && i + 1 < argc)
+        {
+            repeat = atoi(argv[++i]);
+            if (repeat <= 0)
+                repeat = 1;
+            continue;
+        }
+
+        reports.push_back(std::string());
+        if (read_file(argv[i], reports.back()) < 0)
+        {
+            fprintf(stderr, "Cannot read the report %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (reports.empty())
+    {
+        fprintf(stderr, "Usage: %s [-d DICTIONARY] [-r REPEAT] REPORT...\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-6s %5s %12s %8s %14s %14s\n", "codec", "level", "size", "ratio", "comp MB/s", "decomp MB/s");
+    for (size_t i = 0; i < sizeof(codecs) / sizeof(codecs[0]); ++i)
+    {
+        // Codecs not built fall back to zlib
+        if (!Compression::is_available(codecs[i].compress))
+        {
+            fprintf(stderr, "%s %d: not available, skipped\n", codecs[i].name, codecs[i].level);
+            continue;
+        }
+
+        if (run(codecs[i], dictionary, reports, repeat) < 0)
+            return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,35 @@
+#!/usr/bin/env bash
+
+# Compare the compression ratio and the speed of the codecs usable for the
+# reports saved in the database, with the Compression class used by MediaConch,
+# on real reports (MicroMediaTrace reports can be created with:
+# mediaconch -mmt -fx file > file.mmt.xml).
+#
+# Usage: report_compression.sh [-d DICTIONARY] [-r REPEAT] REPORT...
+#   DICTIONARY: zstd dictionary used for the zstd codecs (Compression_ZStd_Dictionary)
+#   REPEAT: number of times each report is compressed and decompressed (default: 10)
+
+SOURCE="$(cd "$(dirname "$0")/../../Source" && pwd)"
+CXX="${CXX:-c++}"
+if [ -z "$CXXFLAGS" ] ; then
+    CXXFLAGS="-O2 $(pkg-config --cflags libmediainfo 2> /dev/null)"
+fi
+
+# zstd and lz4 are built in when pkg-config finds them
+LIBS="-lz"
+if pkg-config --exists libzstd 2> /dev/null ; then
+    CXXFLAGS="$CXXFLAGS -DHAVE_ZSTD $(pkg-config --cflags libzstd)"
+    LIBS="$LIBS $(pkg-config --libs libzstd)"
+fi
+if pkg-config --exists liblz4 2> /dev/null ; then
+    CXXFLAGS="$CXXFLAGS -DHAVE_LZ4 $(pkg-config --cflags liblz4)"
+    LIBS="$LIBS $(pkg-config --libs liblz4)"
+fi
+
+DIR="$(mktemp -d)"
+trap 'rm -rf "$DIR"' EXIT
+
+$CXX $CXXFLAGS -I"$SOURCE" -I"$SOURCE/Common" -o "$DIR/report_compression" \
+    "$(dirname "$0")/report_compression.cpp" "$SOURCE/Common/Compression.cpp" $LIBS || exit 1
+
+"$DIR/report_compression" "$@"